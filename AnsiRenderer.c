@@ -0,0 +1,218 @@
+/*
+ * Incremental ANSI console renderer.  See the comments in AnsiRenderer.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+
+#include "AnsiRenderer.h"
+
+/* Not defined by the Windows headers when targeting versions of Windows older
+than Windows 10, although the console ignores it rather than failing there. */
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+	#define ENABLE_VIRTUAL_TERMINAL_PROCESSING	0x0004
+#endif
+
+/* The longest cursor position sequence is "\x1b[RR;CCCH". */
+#define ansiMAX_MOVE_LENGTH		( 10 )
+
+/* Worst case output is a cursor move before every other cell, plus hiding
+the cursor. */
+#define ansiOUTPUT_BUFFER_SIZE	( ( ( ansiCOLUMNS * ansiROWS ) * ( ansiMAX_MOVE_LENGTH + 1 ) ) + 8 )
+
+/* Marks a cell whose content on the screen is not known, so it differs from
+any character that can be drawn. */
+#define ansiUNKNOWN_CELL		( ( char ) 0 )
+
+/*
+ * Write xLength bytes to the console in one call.
+ */
+static void prvWriteConsole( const char *pcBuffer, size_t xLength );
+
+/*-----------------------------------------------------------*/
+
+/* The frame being drawn, and the frame currently on the screen. */
+static char cFrame[ ansiROWS ][ ansiCOLUMNS ];
+static char cScreen[ ansiROWS ][ ansiCOLUMNS ];
+
+/* The escape sequences and characters for one xAnsiRendererPresent() call. */
+static char cOutput[ ansiOUTPUT_BUFFER_SIZE ];
+
+/* The log is a circular buffer of lines. */
+static char cLog[ ansiLOG_LINES ][ ansiLOG_LINE_LENGTH + 1 ];
+static int iLogNext = 0;
+static int iLogCount = 0;
+
+static HANDLE xConsole = NULL;
+
+/*-----------------------------------------------------------*/
+
+void vAnsiRendererInitialise( void )
+{
+DWORD ulMode;
+
+	xConsole = GetStdHandle( STD_OUTPUT_HANDLE );
+
+	if( GetConsoleMode( xConsole, &ulMode ) != 0 )
+	{
+		SetConsoleMode( xConsole, ulMode | ENABLE_PROCESSED_OUTPUT | ENABLE_VIRTUAL_TERMINAL_PROCESSING );
+	}
+
+	vAnsiRendererClear();
+	vAnsiRendererClearScreen();
+}
+/*-----------------------------------------------------------*/
+
+void vAnsiRendererClearScreen( void )
+{
+static const char cClearAndHome[] = "\x1b[2J\x1b[H\x1b[?25h";
+
+	/* stdout may be holding text written with printf(), which must reach the
+	console before the clear.  The cursor is shown again in case whatever is
+	written next asks for input. */
+	fflush( stdout );
+	prvWriteConsole( cClearAndHome, sizeof( cClearAndHome ) - 1 );
+	memset( cScreen, ansiUNKNOWN_CELL, sizeof( cScreen ) );
+}
+/*-----------------------------------------------------------*/
+
+void vAnsiRendererClear( void )
+{
+	memset( cFrame, ' ', sizeof( cFrame ) );
+}
+/*-----------------------------------------------------------*/
+
+void vAnsiRendererPutChar( int iColumn, int iRow, char cCharacter )
+{
+	if( ( iColumn >= 0 ) && ( iColumn < ansiCOLUMNS ) && ( iRow >= 0 ) && ( iRow < ansiROWS ) )
+	{
+		cFrame[ iRow ][ iColumn ] = cCharacter;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vAnsiRendererPutString( int iColumn, int iRow, const char *pcString )
+{
+	while( *pcString != '\0' )
+	{
+		vAnsiRendererPutChar( iColumn, iRow, *pcString );
+		iColumn++;
+		pcString++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vAnsiRendererPrintf( int iColumn, int iRow, const char *pcFormat, ... )
+{
+char cLine[ ansiCOLUMNS + 1 ];
+va_list xArguments;
+
+	va_start( xArguments, pcFormat );
+	vsnprintf( cLine, sizeof( cLine ), pcFormat, xArguments );
+	va_end( xArguments );
+
+	vAnsiRendererPutString( iColumn, iRow, cLine );
+}
+/*-----------------------------------------------------------*/
+
+void vAnsiRendererLog( const char *pcFormat, ... )
+{
+va_list xArguments;
+
+	va_start( xArguments, pcFormat );
+	vsnprintf( cLog[ iLogNext ], sizeof( cLog[ iLogNext ] ), pcFormat, xArguments );
+	va_end( xArguments );
+
+	iLogNext = ( iLogNext + 1 ) % ansiLOG_LINES;
+
+	if( iLogCount < ansiLOG_LINES )
+	{
+		iLogCount++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vAnsiRendererDrawLog( int iRow )
+{
+int x, iLine;
+
+	/* Oldest line first. */
+	iLine = ( iLogNext + ansiLOG_LINES - iLogCount ) % ansiLOG_LINES;
+
+	for( x = 0; x < iLogCount; x++ )
+	{
+		vAnsiRendererPutString( 0, iRow + x, cLog[ iLine ] );
+		iLine = ( iLine + 1 ) % ansiLOG_LINES;
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xAnsiRendererPresent( void )
+{
+static const char cHideCursor[] = "\x1b[?25l";
+int iRow, iColumn;
+size_t xLength = sizeof( cHideCursor ) - 1;
+BaseType_t xCursorInPlace = pdFALSE;
+
+	/* Start with hiding the cursor, so it does not flicker across the frame
+	as the changed cells are written. */
+	memcpy( cOutput, cHideCursor, xLength );
+
+	for( iRow = 0; iRow < ansiROWS; iRow++ )
+	{
+		/* The cursor is only known to be in the right place while writing a
+		run of changed cells on one row. */
+		xCursorInPlace = pdFALSE;
+
+		for( iColumn = 0; iColumn < ansiCOLUMNS; iColumn++ )
+		{
+			if( cFrame[ iRow ][ iColumn ] == cScreen[ iRow ][ iColumn ] )
+			{
+				xCursorInPlace = pdFALSE;
+			}
+			else
+			{
+				if( xCursorInPlace == pdFALSE )
+				{
+					/* ANSI rows and columns count from 1. */
+					xLength += ( size_t ) snprintf( &( cOutput[ xLength ] ), ansiMAX_MOVE_LENGTH + 1, "\x1b[%d;%dH", iRow + 1, iColumn + 1 );
+					xCursorInPlace = pdTRUE;
+				}
+
+				cOutput[ xLength ] = cFrame[ iRow ][ iColumn ];
+				xLength++;
+				cScreen[ iRow ][ iColumn ] = cFrame[ iRow ][ iColumn ];
+			}
+		}
+	}
+
+	if( xLength > ( sizeof( cHideCursor ) - 1 ) )
+	{
+		prvWriteConsole( cOutput, xLength );
+	}
+	else
+	{
+		xLength = 0;
+	}
+
+	return xLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteConsole( const char *pcBuffer, size_t xLength )
+{
+DWORD ulWritten;
+
+	if( xConsole == NULL )
+	{
+		xConsole = GetStdHandle( STD_OUTPUT_HANDLE );
+	}
+
+	WriteFile( xConsole, pcBuffer, ( DWORD ) xLength, &ulWritten, NULL );
+}
+/*-----------------------------------------------------------*/
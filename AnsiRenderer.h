@@ -0,0 +1,67 @@
+/*
+ * An incremental console renderer.
+ *
+ * Drawing functions write into an in-memory character frame buffer.
+ * xAnsiRendererPresent() compares that frame with the one already on the
+ * screen and writes only the cells that changed, as ANSI escape sequences
+ * collected into one buffer and passed to the console in a single write.  This
+ * replaces clearing the console with system( "cls" ), which spawns a process,
+ * and redrawing everything with many individually flushed printf() calls.
+ *
+ * The renderer also keeps a short log of text lines, so tasks that used to
+ * print status messages can add them to the frame instead of scrolling the
+ * console underneath it.
+ *
+ * None of the functions are thread safe.  Callers must serialise access, for
+ * example by holding a resource for the console.
+ */
+
+#ifndef ANSI_RENDERER_H
+#define ANSI_RENDERER_H
+
+/* The size of the frame buffer, in character cells. */
+#define ansiCOLUMNS				( 80 )
+#define ansiROWS				( 32 )
+
+/* The number of log lines kept, and the maximum length of each. */
+#define ansiLOG_LINES			( 6 )
+#define ansiLOG_LINE_LENGTH		( ansiCOLUMNS )
+
+/*
+ * Switch the console to ANSI escape sequence processing and clear it.  Must be
+ * called once before anything else.  The cursor is hidden while frames are
+ * being presented and shown again by vAnsiRendererClearScreen().
+ */
+void vAnsiRendererInitialise( void );
+
+/*
+ * Clear the console and forget what is on it, so the next
+ * xAnsiRendererPresent() draws every cell.  Use before and after writing to
+ * the console by other means, such as printf().
+ */
+void vAnsiRendererClearScreen( void );
+
+/*
+ * Fill the frame buffer with spaces, then write characters into it.  Anything
+ * falling outside the frame buffer is clipped.
+ */
+void vAnsiRendererClear( void );
+void vAnsiRendererPutChar( int iColumn, int iRow, char cCharacter );
+void vAnsiRendererPutString( int iColumn, int iRow, const char *pcString );
+void vAnsiRendererPrintf( int iColumn, int iRow, const char *pcFormat, ... );
+
+/*
+ * Add a formatted line to the log, discarding the oldest line if the log is
+ * full, and draw the log into the frame buffer starting at iRow.
+ */
+void vAnsiRendererLog( const char *pcFormat, ... );
+void vAnsiRendererDrawLog( int iRow );
+
+/*
+ * Write the cells that differ from the previous frame to the console in a
+ * single write.  Returns the number of bytes written, which is 0 if nothing
+ * changed.
+ */
+size_t xAnsiRendererPresent( void );
+
+#endif /* ANSI_RENDERER_H */
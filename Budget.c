@@ -0,0 +1,328 @@
+/*
+ * Execution time budgets.  See the comments in Budget.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+
+#include "Budget.h"
+
+/* The run time stats counter counts in 1/100ths of a millisecond - see
+Run-time-stats-utils.c. */
+#define budgetRUN_TIME_UNITS_PER_MS	( 100UL )
+#define budgetTICKS_TO_RUN_TIME( xTicks ) ( ( uint32_t ) ( xTicks ) * portTICK_PERIOD_MS * budgetRUN_TIME_UNITS_PER_MS )
+
+typedef struct xBUDGET_TASK
+{
+	TaskHandle_t xHandle;				/* NULL for work. */
+	const void *pvWork;					/* NULL for a task. */
+	const char *pcName;					/* NULL to use the kernel's name. */
+	volatile TaskHandle_t xRunner;		/* The task running the work, if any. */
+	uint32_t ulBudget;					/* Run time stats counter units. */
+	uint32_t ulActions;
+	UBaseType_t uxPriority;				/* Read when the budget is declared. */
+	UBaseType_t uxDemotedPriority;
+
+	/* Updated from the tick hook and the timer service task. */
+	volatile uint32_t ulUsed;			/* By the current job. */
+	volatile BaseType_t xOverran;		/* The current job has overrun. */
+	volatile BaseType_t xAborted;
+	volatile BaseType_t xDemoted;
+
+	/* Only accessed by the task itself. */
+	uint32_t ulLongestJob;
+	uint32_t ulOverruns;
+} BudgetTask_t;
+
+/*
+ * Return the budget of the work xTask is running, or if it is not running any
+ * the budget of xTask, or NULL if it does not have one.
+ */
+static BudgetTask_t *prvFindTask( TaskHandle_t xTask );
+
+/*
+ * Return the budget of pvWork, or NULL if it does not have one.
+ */
+static BudgetTask_t *prvFindWork( const void *pvWork );
+
+/*
+ * The name pxTask is reported under.
+ */
+static const char *prvTaskName( const BudgetTask_t *pxTask );
+
+/*
+ * Take the overrun actions that must run in a task, from the timer service
+ * task.  pvParameter1 is the BudgetTask_t of the task that overran.
+ */
+static void prvDeferredOverrun( void *pvParameter1, uint32_t ulParameter2 );
+
+/*-----------------------------------------------------------*/
+
+static BudgetTask_t xTasks[ budgetMAX_TASKS ];
+static UBaseType_t uxTaskCount = 0;
+
+/* The run time stats counter value at the previous tick, which is not valid
+until the first tick. */
+static uint32_t ulLastTickTime = 0UL;
+static BaseType_t xTicking = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+void vBudgetDeclare( TaskHandle_t xTask, TickType_t xBudget, uint32_t ulActions, UBaseType_t uxDemotedPriority )
+{
+	configASSERT( xTask );
+	configASSERT( uxTaskCount < budgetMAX_TASKS );
+	configASSERT( prvFindTask( xTask ) == NULL );
+
+	xTasks[ uxTaskCount ].xHandle = xTask;
+	xTasks[ uxTaskCount ].ulBudget = budgetTICKS_TO_RUN_TIME( xBudget );
+	xTasks[ uxTaskCount ].ulActions = ulActions;
+	xTasks[ uxTaskCount ].uxPriority = uxTaskPriorityGet( xTask );
+	xTasks[ uxTaskCount ].uxDemotedPriority = uxDemotedPriority;
+	uxTaskCount++;
+}
+/*-----------------------------------------------------------*/
+
+void vBudgetDeclareWork( const void *pvWork, const char *pcName, TickType_t xBudget, uint32_t ulActions )
+{
+	configASSERT( pvWork );
+	configASSERT( pcName );
+	configASSERT( uxTaskCount < budgetMAX_TASKS );
+	configASSERT( prvFindWork( pvWork ) == NULL );
+
+	xTasks[ uxTaskCount ].pvWork = pvWork;
+	xTasks[ uxTaskCount ].pcName = pcName;
+	xTasks[ uxTaskCount ].ulBudget = budgetTICKS_TO_RUN_TIME( xBudget );
+	xTasks[ uxTaskCount ].ulActions = ulActions & ~eBudgetDemote;
+	uxTaskCount++;
+}
+/*-----------------------------------------------------------*/
+
+void vBudgetWorkBegin( const void *pvWork )
+{
+BudgetTask_t *pxWork = prvFindWork( pvWork );
+
+	if( pxWork != NULL )
+	{
+		pxWork->xRunner = xTaskGetCurrentTaskHandle();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vBudgetWorkEnd( const void *pvWork )
+{
+BudgetTask_t *pxWork = prvFindWork( pvWork );
+
+	if( pxWork != NULL )
+	{
+		pxWork->xRunner = NULL;
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xBudgetJobStart( void )
+{
+BudgetTask_t *pxTask = prvFindTask( xTaskGetCurrentTaskHandle() );
+BaseType_t xReturn = pdTRUE;
+uint32_t ulUsed;
+BaseType_t xOverran;
+
+	if( pxTask != NULL )
+	{
+		/* Close the previous job. */
+		taskENTER_CRITICAL();
+		{
+			ulUsed = pxTask->ulUsed;
+			xOverran = pxTask->xOverran;
+			pxTask->ulUsed = 0UL;
+			pxTask->xOverran = pdFALSE;
+			pxTask->xAborted = pdFALSE;
+		}
+		taskEXIT_CRITICAL();
+
+		if( ulUsed > pxTask->ulLongestJob )
+		{
+			pxTask->ulLongestJob = ulUsed;
+		}
+
+		if( pxTask->xDemoted != pdFALSE )
+		{
+			vTaskPrioritySet( NULL, pxTask->uxPriority );
+			pxTask->xDemoted = pdFALSE;
+		}
+
+		if( xOverran != pdFALSE )
+		{
+			pxTask->ulOverruns++;
+
+			if( ( pxTask->ulActions & eBudgetLog ) != 0UL )
+			{
+				vApplicationBudgetOverrunHook( prvTaskName( pxTask ), ulUsed, pxTask->ulBudget );
+			}
+
+			/* This is the job after the one that overran.  A skipped job
+			uses no time, so the job after it always runs. */
+			if( ( pxTask->ulActions & eBudgetSkipNext ) != 0UL )
+			{
+				xReturn = pdFALSE;
+			}
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xBudgetJobAborted( void )
+{
+BudgetTask_t *pxTask = prvFindTask( xTaskGetCurrentTaskHandle() );
+BaseType_t xReturn = pdFALSE;
+
+	if( pxTask != NULL )
+	{
+		xReturn = pxTask->xAborted;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vBudgetTickHook( void )
+{
+uint32_t ulNow = portGET_RUN_TIME_COUNTER_VALUE();
+BudgetTask_t *pxTask = prvFindTask( xTaskGetCurrentTaskHandle() );
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if( xTicking == pdFALSE )
+	{
+		/* Nothing to charge yet. */
+		xTicking = pdTRUE;
+	}
+	else if( ( pxTask != NULL ) && ( pxTask->xOverran == pdFALSE ) )
+	{
+		pxTask->ulUsed += ulNow - ulLastTickTime;
+
+		if( pxTask->ulUsed > pxTask->ulBudget )
+		{
+			pxTask->xOverran = pdTRUE;
+
+			if( ( pxTask->ulActions & eBudgetAbort ) != 0UL )
+			{
+				pxTask->xAborted = pdTRUE;
+			}
+
+			/* Changing a priority and aborting a delay can not be done from
+			an interrupt.  Work has no task of its own to act on. */
+			if( ( pxTask->xHandle != NULL ) && ( ( pxTask->ulActions & ( eBudgetDemote | eBudgetAbort ) ) != 0UL ) )
+			{
+				xTimerPendFunctionCallFromISR( prvDeferredOverrun, ( void * ) pxTask, 0UL, &xHigherPriorityTaskWoken );
+			}
+		}
+	}
+	else if( pxTask != NULL )
+	{
+		/* Already overran - keep counting for the longest job measurement. */
+		pxTask->ulUsed += ulNow - ulLastTickTime;
+	}
+
+	ulLastTickTime = ulNow;
+
+	/* The tick interrupt performs a context switch when it returns if one is
+	needed, so xHigherPriorityTaskWoken is not used. */
+	( void ) xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+void vBudgetPrintReport( void )
+{
+UBaseType_t x;
+
+	printf( "\r\nTask          Budget (ms)  Longest job (ms)  Overruns\r\n" );
+
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		printf( "%-12s  %11.2f  %16.2f  %8lu\r\n", prvTaskName( &( xTasks[ x ] ) ),
+				( double ) xTasks[ x ].ulBudget / budgetRUN_TIME_UNITS_PER_MS,
+				( double ) xTasks[ x ].ulLongestJob / budgetRUN_TIME_UNITS_PER_MS,
+				( unsigned long ) xTasks[ x ].ulOverruns );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BudgetTask_t *prvFindTask( TaskHandle_t xTask )
+{
+BudgetTask_t *pxReturn = NULL;
+UBaseType_t x;
+
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		if( ( xTasks[ x ].pvWork != NULL ) && ( xTasks[ x ].xRunner == xTask ) )
+		{
+			/* Work being run takes the place of the task running it. */
+			pxReturn = &( xTasks[ x ] );
+			break;
+		}
+		else if( ( pxReturn == NULL ) && ( xTasks[ x ].xHandle == xTask ) )
+		{
+			pxReturn = &( xTasks[ x ] );
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BudgetTask_t *prvFindWork( const void *pvWork )
+{
+BudgetTask_t *pxReturn = NULL;
+UBaseType_t x;
+
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		if( ( xTasks[ x ].pvWork != NULL ) && ( xTasks[ x ].pvWork == pvWork ) )
+		{
+			pxReturn = &( xTasks[ x ] );
+			break;
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static const char *prvTaskName( const BudgetTask_t *pxTask )
+{
+	return ( pxTask->pcName != NULL ) ? pxTask->pcName : pcTaskGetName( pxTask->xHandle );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDeferredOverrun( void *pvParameter1, uint32_t ulParameter2 )
+{
+BudgetTask_t *pxTask = ( BudgetTask_t * ) pvParameter1;
+
+	( void ) ulParameter2;
+
+	/* The job may have ended, and the next one started, before the timer
+	service task ran. */
+	if( pxTask->xOverran != pdFALSE )
+	{
+		/* A task raised to a resource ceiling is not demoted, as that would
+		break the ceiling protocol. */
+		if( ( ( pxTask->ulActions & eBudgetDemote ) != 0UL ) && ( uxTaskPriorityGet( pxTask->xHandle ) == pxTask->uxPriority ) )
+		{
+			vTaskPrioritySet( pxTask->xHandle, pxTask->uxDemotedPriority );
+			pxTask->xDemoted = pdTRUE;
+		}
+
+		if( ( pxTask->ulActions & eBudgetAbort ) != 0UL )
+		{
+			xTaskAbortDelay( pxTask->xHandle );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
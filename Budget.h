@@ -0,0 +1,111 @@
+/*
+ * Execution time budgets, so one task that runs for longer than expected can
+ * not take the processor time the other tasks rely on to meet their
+ * deadlines.
+ *
+ * Each task with a budget reports the start of every job by calling
+ * xBudgetJobStart().  The tick hook calls vBudgetTickHook(), which charges
+ * the run time stats counter time that has passed since the previous tick to
+ * the task that was running, so the time a job spends preempted or blocked is
+ * not charged to it.  When a job has used more than its budget one or more of
+ * the actions below are taken, once per job:
+ *
+ * eBudgetLog - vApplicationBudgetOverrunHook() is called from the task
+ * itself, at the start of its next job, where it is safe to write to the
+ * console.
+ *
+ * eBudgetSkipNext - the next job is skipped: xBudgetJobStart() returns
+ * pdFALSE and the task should wait for its following release.
+ *
+ * eBudgetDemote - the task is moved to its demoted priority until the end of
+ * the job, so it only uses time no other task needs.  A task that is holding
+ * a ceiling resource at the time is not demoted.
+ *
+ * eBudgetAbort - xBudgetJobAborted() returns pdTRUE until the next job starts,
+ * so long computations can poll it and give up, and the task is woken if it
+ * is in the Blocked state in the middle of the job, as xTaskAbortDelay()
+ * would.
+ *
+ * The budget is charged at tick resolution.  A task that is switched out part
+ * way through a tick has that whole tick charged to the task running when
+ * the tick interrupt occurs.
+ *
+ * Work that is not a task of its own, such as a job run by the timer service
+ * task, can be given a budget with vBudgetDeclareWork().  The task that runs
+ * it calls vBudgetWorkBegin() and vBudgetWorkEnd() around each piece of it.
+ * In between, the ticks of that task are charged to the work, and
+ * xBudgetJobStart() and xBudgetJobAborted() called by that task apply to the
+ * work.  The task is not demoted or woken on behalf of the work, as it is
+ * shared, so only eBudgetLog, eBudgetSkipNext and eBudgetAbort apply.
+ */
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include "task.h"
+
+/* The maximum number of tasks that can have a budget. */
+#define budgetMAX_TASKS				( 10 )
+
+/* Overrun actions, which can be combined. */
+#define eBudgetLog					( 0x01UL )
+#define eBudgetSkipNext				( 0x02UL )
+#define eBudgetDemote				( 0x04UL )
+#define eBudgetAbort				( 0x08UL )
+
+/*
+ * Give xTask a budget of xBudget ticks of execution per job.  ulActions is
+ * a combination of the overrun actions above, and uxDemotedPriority is only
+ * used if it includes eBudgetDemote.  Must be called before the scheduler is
+ * started.
+ */
+void vBudgetDeclare( TaskHandle_t xTask, TickType_t xBudget, uint32_t ulActions, UBaseType_t uxDemotedPriority );
+
+/*
+ * Give the work identified by pvWork a budget of xBudget ticks of execution
+ * per job.  pcName, which must remain valid, is used in the report and passed
+ * to vApplicationBudgetOverrunHook().  eBudgetDemote is ignored in ulActions.
+ * Must be called before the scheduler is started.
+ */
+void vBudgetDeclareWork( const void *pvWork, const char *pcName, TickType_t xBudget, uint32_t ulActions );
+
+/*
+ * Called by the task that runs pvWork before and after each piece of it.  Do
+ * nothing if pvWork has no budget.
+ */
+void vBudgetWorkBegin( const void *pvWork );
+void vBudgetWorkEnd( const void *pvWork );
+
+/*
+ * Called by a task at the start of each job.  Returns pdFALSE if the job
+ * must be skipped because the previous one overran.  Does nothing, and
+ * returns pdTRUE, for a task without a budget.
+ */
+BaseType_t xBudgetJobStart( void );
+
+/*
+ * Returns pdTRUE if the calling task's current job, or that of the work it is
+ * running, has overrun a budget that includes eBudgetAbort.
+ */
+BaseType_t xBudgetJobAborted( void );
+
+/*
+ * Must be called from vApplicationTickHook().
+ */
+void vBudgetTickHook( void );
+
+/*
+ * Print, for every task and work with a budget, the budget, the longest job measured
+ * and the number of overruns.  Uses printf() so must only be called when no
+ * other task is writing to the console.
+ */
+void vBudgetPrintReport( void );
+
+/*
+ * Defined by the application when eBudgetLog is used.  pcName is the name of
+ * the task or work that overran.  ulUsed and ulBudget are in run time stats
+ * counter units.
+ */
+extern void vApplicationBudgetOverrunHook( const char *pcName, uint32_t ulUsed, uint32_t ulBudget );
+
+#endif /* BUDGET_H */
@@ -0,0 +1,131 @@
+/*  # Gerador do caminho do jogo ZigZag
+	Veja os comentários em Caminho.h.
+*/
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+
+#include "Caminho.h"
+
+/* Menor e maior comprimento sorteado para um segmento, em linhas */
+#define COMPRIMENTO_MINIMO 3
+#define COMPRIMENTO_MAXIMO 10
+
+/* Colunas em que o centro do caminho pode ficar sem que ele saia do display */
+#define CENTRO_MINIMO MEIA_LARGURA_CAMINHO
+#define CENTRO_MAXIMO (LARGURA_CAMINHO - 1 - MEIA_LARGURA_CAMINHO)
+
+
+static void gera_segmento(Caminho *caminho)
+{
+	/* Essa função acrescenta um segmento no fim do buffer circular.
+	   O comprimento é sorteado e depois limitado para que o caminho não encoste na borda. */
+
+	Segmento *segmento = &caminho->segmentos[(caminho->inicio + caminho->quantidade) % CAPACIDADE_SEGMENTOS];
+	int comprimento = COMPRIMENTO_MINIMO + (int)ulRandomBounded(&caminho->aleatorio, COMPRIMENTO_MAXIMO - COMPRIMENTO_MINIMO + 1);
+	int limite;
+
+	if (caminho->proximo_sentido > 0)
+	{
+		limite = CENTRO_MAXIMO - caminho->proximo_centro + 1;
+	}
+	else
+	{
+		limite = caminho->proximo_centro - CENTRO_MINIMO + 1;
+	}
+
+	if (comprimento > limite)
+	{
+		comprimento = (limite > 0) ? limite : 1;
+	}
+
+	segmento->id = caminho->proximo_id++;
+	segmento->linha_inicial = caminho->proxima_linha;
+	segmento->centro_inicial = caminho->proximo_centro;
+	segmento->comprimento = (int16_t)comprimento;
+	segmento->sentido = caminho->proximo_sentido;
+	caminho->quantidade++;
+
+	/* O próximo segmento muda de sentido e começa uma coluna depois do fim deste */
+	caminho->proxima_linha += comprimento;
+	caminho->proximo_sentido = (int8_t)-segmento->sentido;
+	caminho->proximo_centro = (int16_t)(segmento->centro_inicial + segmento->sentido * (comprimento - 1) + caminho->proximo_sentido);
+}
+
+void inicializa_caminho(Caminho *caminho, uint64_t semente, uint64_t fluxo)
+{
+	caminho->inicio = 0;
+	caminho->quantidade = 0;
+	caminho->proximo_id = 0;
+	caminho->proxima_linha = 0;
+	caminho->proximo_centro = LARGURA_CAMINHO / 2;
+	caminho->proximo_sentido = -1;
+	caminho->lotes = 0;
+	vRandomSeed(&caminho->aleatorio, semente, fluxo);
+}
+
+int atualiza_caminho(Caminho *caminho, int32_t linha_base)
+{
+	const Segmento *segmento;
+	int gerados = 0;
+
+	/* Descartando os segmentos que já ficaram para trás da janela */
+	while (caminho->quantidade > 0)
+	{
+		segmento = &caminho->segmentos[caminho->inicio];
+
+		if (segmento->linha_inicial + segmento->comprimento > linha_base)
+		{
+			break;
+		}
+
+		caminho->inicio = (caminho->inicio + 1) % CAPACIDADE_SEGMENTOS;
+		caminho->quantidade--;
+	}
+
+	/* Gerando um lote que completa o buffer */
+	if (caminho->quantidade < LIMITE_MINIMO_SEGMENTOS || caminho->proxima_linha < linha_base + ALTURA_CAMINHO)
+	{
+		while (caminho->quantidade < CAPACIDADE_SEGMENTOS)
+		{
+			gera_segmento(caminho);
+			gerados++;
+		}
+
+		/* Com o buffer já cheio nenhum segmento é gerado, e isso não conta como lote */
+		if (gerados > 0)
+		{
+			caminho->lotes++;
+		}
+	}
+
+	return gerados;
+}
+
+void preenche_quadro(const Caminho *caminho, QuadroCaminho *quadro, int32_t linha_base)
+{
+	/* As linhas da janela e os segmentos estão em ordem, então os dois são percorridos juntos */
+
+	uint32_t i = 0;
+	const Segmento *segmento = &caminho->segmentos[caminho->inicio];
+	int32_t linha_absoluta;
+	int linha, centro;
+
+	for (linha = 0; linha < ALTURA_CAMINHO; linha++)
+	{
+		linha_absoluta = linha_base + linha;
+
+		while (i + 1 < caminho->quantidade && linha_absoluta >= segmento->linha_inicial + segmento->comprimento)
+		{
+			i++;
+			segmento = &caminho->segmentos[(caminho->inicio + i) % CAPACIDADE_SEGMENTOS];
+		}
+
+		centro = segmento->centro_inicial + segmento->sentido * (linha_absoluta - segmento->linha_inicial);
+		quadro->esquerda[linha] = (int16_t)(centro - MEIA_LARGURA_CAMINHO);
+		quadro->direita[linha] = (int16_t)(centro + MEIA_LARGURA_CAMINHO);
+		quadro->segmento[linha] = segmento->id;
+	}
+
+	quadro->linha_base = linha_base;
+}
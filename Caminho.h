@@ -0,0 +1,68 @@
+/*  # Gerador do caminho do jogo ZigZag
+
+	O caminho é uma sequência de segmentos retos em diagonal. Cada segmento anda uma
+	coluna por linha em um sentido, e o segmento seguinte anda no sentido contrário.
+
+	Os segmentos ficam em um buffer circular de capacidade fixa, reservado junto com o
+	Caminho, e são gerados à frente da bolinha em lotes: quando restam menos de
+	LIMITE_MINIMO_SEGMENTOS no buffer, o gerador completa o buffer de uma vez. Assim o custo
+	de geração é dividido entre vários jobs de T2 e nenhum segmento é alocado.
+
+	O Caminho é acessado apenas por T2.
+*/
+
+#ifndef CAMINHO_H
+#define CAMINHO_H
+
+#include "Fisica.h"
+#include "Random.h"
+
+/* Quantos segmentos cabem no buffer circular */
+#define CAPACIDADE_SEGMENTOS 64
+
+/* Quando o buffer tiver menos segmentos que isso, um novo lote é gerado */
+#define LIMITE_MINIMO_SEGMENTOS 16
+
+/* Trecho reto do caminho: a linha linha_inicial + i tem centro centro_inicial + sentido * i */
+typedef struct
+{
+	uint32_t id;
+	int32_t linha_inicial;
+	int16_t centro_inicial;
+	int16_t comprimento;
+	int8_t sentido;
+} Segmento;
+
+typedef struct
+{
+	/* Buffer circular: inicio é o segmento mais antigo e os próximos vêm em seguida */
+	Segmento segmentos[CAPACIDADE_SEGMENTOS];
+	uint32_t inicio;
+	uint32_t quantidade;
+
+	/* Onde e como começa o próximo segmento a ser gerado */
+	uint32_t proximo_id;
+	int32_t proxima_linha;
+	int16_t proximo_centro;
+	int8_t proximo_sentido;
+
+	/* Quantos lotes com ao menos um segmento já foram gerados */
+	uint32_t lotes;
+
+	/* Gerador que sorteia o comprimento dos segmentos */
+	Random_t aleatorio;
+} Caminho;
+
+/* Prepara o caminho para que ele comece no centro do display, indo para a esquerda.
+   O mesmo par (semente, fluxo) gera sempre o mesmo caminho. */
+void inicializa_caminho(Caminho *caminho, uint64_t semente, uint64_t fluxo);
+
+/* Descarta os segmentos que terminam antes de linha_base e, se o buffer estiver abaixo do
+   limite mínimo ou não cobrir a janela que começa em linha_base, gera um lote.
+   Retorna quantos segmentos foram gerados. */
+int atualiza_caminho(Caminho *caminho, int32_t linha_base);
+
+/* Preenche os limites de cada linha da janela que começa em linha_base */
+void preenche_quadro(const Caminho *caminho, QuadroCaminho *quadro, int32_t linha_base);
+
+#endif /* CAMINHO_H */
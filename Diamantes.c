@@ -0,0 +1,118 @@
+/*  # Diamantes do jogo ZigZag
+	Veja os comentários em Diamantes.h.
+*/
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+
+#include "Diamantes.h"
+
+
+static void libera_diamante(Diamantes *diamantes, int16_t indice)
+{
+	/* Essa função tira o diamante da tabela e o coloca no início da lista de livres */
+
+	Diamante *diamante = &diamantes->diamantes[indice];
+
+	diamantes->por_segmento[diamante->segmento % CAPACIDADE_SEGMENTOS] = SEM_DIAMANTE;
+	diamante->proximo_livre = diamantes->livre;
+	diamantes->livre = indice;
+	diamantes->quantidade--;
+}
+
+void inicializa_diamantes(Diamantes *diamantes)
+{
+	int i;
+
+	for (i = 0; i < MAX_DIAMANTES; i++)
+	{
+		diamantes->diamantes[i].proximo_livre = (int16_t)((i + 1 < MAX_DIAMANTES) ? i + 1 : SEM_DIAMANTE);
+	}
+
+	for (i = 0; i < CAPACIDADE_SEGMENTOS; i++)
+	{
+		diamantes->por_segmento[i] = SEM_DIAMANTE;
+	}
+
+	diamantes->livre = 0;
+	diamantes->quantidade = 0;
+}
+
+int adiciona_diamante(Diamantes *diamantes, uint32_t segmento, int32_t linha, int16_t coluna)
+{
+	int16_t indice = diamantes->por_segmento[segmento % CAPACIDADE_SEGMENTOS];
+	Diamante *diamante;
+
+	if (indice != SEM_DIAMANTE)
+	{
+		if (diamantes->diamantes[indice].segmento == segmento)
+		{
+			return 0;
+		}
+
+		/* O diamante é de um segmento que já saiu do buffer do gerador */
+		libera_diamante(diamantes, indice);
+	}
+
+	if (diamantes->livre == SEM_DIAMANTE)
+	{
+		return 0;
+	}
+
+	/* Tirando o primeiro diamante da lista de livres */
+	indice = diamantes->livre;
+	diamante = &diamantes->diamantes[indice];
+	diamantes->livre = diamante->proximo_livre;
+
+	diamante->segmento = segmento;
+	diamante->linha = linha;
+	diamante->coluna = coluna;
+	diamante->proximo_livre = SEM_DIAMANTE;
+
+	diamantes->por_segmento[segmento % CAPACIDADE_SEGMENTOS] = indice;
+	diamantes->quantidade++;
+
+	return 1;
+}
+
+void expira_diamantes(Diamantes *diamantes, int32_t linha_minima)
+{
+	int i;
+	int16_t indice;
+
+	for (i = 0; i < CAPACIDADE_SEGMENTOS; i++)
+	{
+		indice = diamantes->por_segmento[i];
+
+		if (indice != SEM_DIAMANTE && diamantes->diamantes[indice].linha < linha_minima)
+		{
+			libera_diamante(diamantes, indice);
+		}
+	}
+}
+
+const Diamante *diamante_do_segmento(const Diamantes *diamantes, uint32_t segmento)
+{
+	int16_t indice = diamantes->por_segmento[segmento % CAPACIDADE_SEGMENTOS];
+
+	if (indice == SEM_DIAMANTE || diamantes->diamantes[indice].segmento != segmento)
+	{
+		return NULL;
+	}
+
+	return &diamantes->diamantes[indice];
+}
+
+int coleta_diamante(Diamantes *diamantes, uint32_t segmento, int32_t linha, int32_t coluna)
+{
+	const Diamante *diamante = diamante_do_segmento(diamantes, segmento);
+
+	if (diamante == NULL || diamante->linha != linha || diamante->coluna != coluna)
+	{
+		return 0;
+	}
+
+	libera_diamante(diamantes, (int16_t)(diamante - diamantes->diamantes));
+
+	return 1;
+}
@@ -0,0 +1,68 @@
+/*  # Diamantes do jogo ZigZag
+
+	Cada diamante fica em uma célula (linha, coluna) de um segmento do caminho, e cada
+	segmento tem no máximo um diamante. Os diamantes são indexados pelo id do segmento:
+	como o gerador guarda no máximo CAPACIDADE_SEGMENTOS segmentos com ids consecutivos,
+	id % CAPACIDADE_SEGMENTOS identifica um único segmento vivo, e achar o diamante da linha
+	em que a bolinha está custa O(1).
+
+	Os diamantes vêm de um vetor de tamanho fixo. Os livres formam uma lista encadeada pelo
+	índice, e os que ficam para trás da bolinha ou pertencem a um segmento descartado voltam
+	para essa lista.
+
+	Nenhuma das funções é thread safe. As tarefas devem usar um recurso para os diamantes.
+*/
+
+#ifndef DIAMANTES_H
+#define DIAMANTES_H
+
+#include "Caminho.h"
+
+/* Quantos diamantes podem estar no caminho ao mesmo tempo */
+#define MAX_DIAMANTES 16
+
+/* Índice que indica o fim da lista de livres ou um segmento sem diamante */
+#define SEM_DIAMANTE (-1)
+
+typedef struct
+{
+	uint32_t segmento;
+	int32_t linha;
+	int16_t coluna;
+
+	/* Próximo diamante na lista de livres */
+	int16_t proximo_livre;
+} Diamante;
+
+typedef struct
+{
+	Diamante diamantes[MAX_DIAMANTES];
+
+	/* Índice do diamante do segmento id % CAPACIDADE_SEGMENTOS, ou SEM_DIAMANTE */
+	int16_t por_segmento[CAPACIDADE_SEGMENTOS];
+
+	/* Primeiro diamante da lista de livres, ou SEM_DIAMANTE */
+	int16_t livre;
+
+	int quantidade;
+} Diamantes;
+
+/* Deixa todos os diamantes na lista de livres */
+void inicializa_diamantes(Diamantes *diamantes);
+
+/* Coloca um diamante na célula dada do segmento. Um diamante que ainda estivesse no lugar
+   correspondente da tabela pertence a um segmento já descartado e é reaproveitado.
+   Retorna 0 se o segmento já tem um diamante ou se não há diamantes livres. */
+int adiciona_diamante(Diamantes *diamantes, uint32_t segmento, int32_t linha, int16_t coluna);
+
+/* Devolve para a lista de livres os diamantes das linhas anteriores a linha_minima */
+void expira_diamantes(Diamantes *diamantes, int32_t linha_minima);
+
+/* Retorna o diamante do segmento, ou NULL se ele não tiver um */
+const Diamante *diamante_do_segmento(const Diamantes *diamantes, uint32_t segmento);
+
+/* Se houver um diamante na célula (linha, coluna) do segmento, ele é retirado e a função
+   retorna 1. Caso contrário retorna 0. */
+int coleta_diamante(Diamantes *diamantes, uint32_t segmento, int32_t linha, int32_t coluna);
+
+#endif /* DIAMANTES_H */
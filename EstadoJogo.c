@@ -0,0 +1,93 @@
+/*  # Estados do jogo ZigZag
+	Veja os comentários em EstadoJogo.h.
+*/
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "EstadoJogo.h"
+
+
+static EventGroupHandle_t grupo_estados = NULL;
+static const TransicaoJogo *transicoes;
+static int quantidade_transicoes;
+
+/* O estado atual. O grupo de eventos só indica o estado para quem espera por ele: entre
+   deixar o estado de origem e sinalizar o de destino nenhum bit fica ligado. */
+static volatile EstadoJogo estado_atual;
+
+
+void inicializa_estado_do_jogo(const TransicaoJogo *tabela, int quantidade, EstadoJogo inicial)
+{
+	grupo_estados = xEventGroupCreate();
+	configASSERT(grupo_estados);
+
+	transicoes = tabela;
+	quantidade_transicoes = quantidade;
+	estado_atual = inicial;
+	xEventGroupSetBits(grupo_estados, BIT_DO_ESTADO(inicial));
+}
+
+int dispara_evento(EventoJogo evento)
+{
+	const TransicaoJogo *transicao = NULL;
+	int i;
+
+	/* Procurando a transição e deixando o estado de origem sem que outra tarefa dispare
+	   um evento no meio, o que faria duas transições partirem do mesmo estado */
+	vTaskSuspendAll();
+	{
+		for (i = 0; i < quantidade_transicoes && transicao == NULL; i++)
+		{
+			if (transicoes[i].origem == estado_atual && transicoes[i].evento == evento)
+			{
+				transicao = &transicoes[i];
+			}
+		}
+
+		if (transicao != NULL)
+		{
+			xEventGroupClearBits(grupo_estados, BIT_DO_ESTADO(estado_atual));
+			estado_atual = transicao->destino;
+		}
+	}
+	xTaskResumeAll();
+
+	if (transicao == NULL)
+	{
+		return 0;
+	}
+
+	if (transicao->acao != NULL)
+	{
+		transicao->acao();
+	}
+
+	/* Acordando as tarefas que esperam pelo novo estado */
+	xEventGroupSetBits(grupo_estados, BIT_DO_ESTADO(transicao->destino));
+
+	return 1;
+}
+
+EstadoJogo estado_do_jogo(void)
+{
+	return estado_atual;
+}
+
+EstadoJogo espera_estado(EventBits_t estados)
+{
+	EventBits_t bits = xEventGroupWaitBits(grupo_estados, estados, pdFALSE, pdFALSE, portMAX_DELAY);
+	EstadoJogo estado = ESTADO_MENU;
+
+	/* Os bits dos estados são exclusivos, então só um dos pedidos estará ligado */
+	bits &= estados;
+
+	while (bits > 1)
+	{
+		bits >>= 1;
+		estado++;
+	}
+
+	return estado;
+}
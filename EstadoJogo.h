@@ -0,0 +1,69 @@
+/*  # Estados do jogo ZigZag
+
+	O ciclo de vida do jogo é uma máquina de estados: menu, partida em andamento, fim de
+	jogo e sessão encerrada. O estado atual é mantido em um grupo de eventos, com um bit
+	para cada estado, então as tarefas bloqueiam esperando o estado em que trabalham, em
+	vez de testar uma variável a cada job, e acordam assim que a transição acontece.
+
+	As transições são dadas por uma tabela de (estado de origem, evento, estado de destino,
+	ação), definida por quem usa a máquina. Um evento sem transição a partir do estado atual
+	é ignorado. A ação é executada por quem disparou o evento, depois de o estado de origem
+	ser deixado e antes de o estado de destino ser sinalizado. Assim nenhuma tarefa começa
+	um job em nenhum dos dois estados enquanto ela é executada, mas uma tarefa que já
+	passou pela espera do estado de origem pode ainda estar terminando o job dela. A ação
+	não espera por essas tarefas, então o que ela muda e elas usam deve ser protegido por
+	um recurso ou entregue a elas, para ser aplicado no próximo job.
+*/
+
+#ifndef ESTADO_JOGO_H
+#define ESTADO_JOGO_H
+
+#include "event_groups.h"
+
+typedef enum
+{
+	ESTADO_MENU = 0,
+	ESTADO_JOGANDO,
+	ESTADO_FIM_DE_JOGO,
+	ESTADO_ENCERRADO,
+	QUANTIDADE_ESTADOS
+} EstadoJogo;
+
+typedef enum
+{
+	EVENTO_INICIA_PARTIDA = 0,
+	EVENTO_BOLINHA_CAIU,
+	EVENTO_DESISTENCIA,
+	EVENTO_JOGA_NOVAMENTE,
+	EVENTO_SAI_DO_JOGO
+} EventoJogo;
+
+/* Bit do grupo de eventos que indica o estado */
+#define BIT_DO_ESTADO(estado) ((EventBits_t)1 << (estado))
+
+typedef struct
+{
+	EstadoJogo origem;
+	EventoJogo evento;
+	EstadoJogo destino;
+
+	/* Executada na transição, ou NULL */
+	void (*acao)(void);
+} TransicaoJogo;
+
+/* Cria o grupo de eventos e entra no estado inicial. A tabela não é copiada e deve
+   existir enquanto a máquina for usada. */
+void inicializa_estado_do_jogo(const TransicaoJogo *tabela, int quantidade, EstadoJogo inicial);
+
+/* Faz a transição do estado atual pelo evento. Retorna 1 se houve transição ou 0 se o
+   evento foi ignorado. Pode ser chamada antes de o escalonador ser iniciado. */
+int dispara_evento(EventoJogo evento);
+
+/* Retorna o estado atual, sem bloquear */
+EstadoJogo estado_do_jogo(void);
+
+/* Bloqueia até o jogo estar em um dos estados dados (uma combinação de BIT_DO_ESTADO) e
+   retorna esse estado */
+EstadoJogo espera_estado(EventBits_t estados);
+
+#endif /* ESTADO_JOGO_H */
@@ -0,0 +1,71 @@
+/*  # Física da bolinha do jogo ZigZag
+	Veja os comentários em Fisica.h.
+*/
+
+/* FreeRTOS kernel includes. */
+#include "FreeRTOS.h"
+
+#include "Fisica.h"
+
+
+void inicializa_bola(Bola *bola, int32_t linha, int32_t coluna)
+{
+	/* A bolinha começa no meio da célula, descendo para a esquerda */
+	bola->x = coluna * FISICA_UNIDADE + FISICA_UNIDADE / 2;
+	bola->y = linha * FISICA_UNIDADE;
+	bola->vy = VELOCIDADE_BOLA;
+	bola->vx = -VELOCIDADE_BOLA;
+}
+
+void muda_sentido_da_bola(Bola *bola, int direita)
+{
+	/* A bolinha anda na diagonal: uma coluna para cada linha que desce */
+	bola->vx = direita ? bola->vy : -bola->vy;
+}
+
+void move_bola(Bola *bola)
+{
+	bola->x += bola->vx;
+	bola->y += bola->vy;
+}
+
+int linhas_ate_queda(const Bola *bola, const QuadroCaminho *quadro)
+{
+	/* Vetor com 1 nas linhas da janela em que a bolinha estaria fora do caminho */
+	uint8_t fora[ALTURA_CAMINHO];
+
+	int32_t sentido = (bola->vx >= 0) ? 1 : -1;
+	int32_t dy, x;
+	int inicio = bola->y / FISICA_UNIDADE - quadro->linha_base;
+	int linha, resultado = -1;
+
+	if (inicio < 0 || inicio >= ALTURA_CAMINHO)
+	{
+		return -2;
+	}
+
+	/* Para cada linha da janela calcula a coluna em que a bolinha entra nela, mantendo o
+	   sentido atual, e marca se essa coluna está fora do caminho. Na linha em que a bolinha
+	   já está é usada a posição atual. O laço percorre a janela inteira e não tem desvios,
+	   para que o compilador possa vetorizá-lo. */
+	for (linha = 0; linha < ALTURA_CAMINHO; linha++)
+	{
+		dy = (quadro->linha_base + linha) * FISICA_UNIDADE - bola->y;
+		dy = (dy > 0) ? dy : 0;
+		x = bola->x + sentido * dy;
+
+		fora[linha] = (uint8_t)((x < quadro->esquerda[linha] * FISICA_UNIDADE)
+							  | (x >= (quadro->direita[linha] + 1) * FISICA_UNIDADE));
+	}
+
+	/* Procurando a primeira linha, a partir da linha da bolinha, em que ela sai do caminho */
+	for (linha = inicio; linha < ALTURA_CAMINHO && resultado < 0; linha++)
+	{
+		if (fora[linha])
+		{
+			resultado = linha - inicio;
+		}
+	}
+
+	return resultado;
+}
@@ -0,0 +1,65 @@
+/*  # Física da bolinha do jogo ZigZag
+
+	O caminho é formado por linhas numeradas a partir do início da partida. Cada linha
+	tem um trecho ocupado pelo caminho (colunas esquerda..direita). A bolinha desce
+	pelo caminho na diagonal, uma coluna para cada linha, no sentido escolhido pelo
+	jogador, e cai quando sai do trecho ocupado pelo caminho na linha em que está.
+
+	Posições e velocidades usam ponto fixo: FISICA_UNIDADE equivale a uma linha ou coluna.
+*/
+
+#ifndef FISICA_H
+#define FISICA_H
+
+/* Dimensões do trecho de caminho que aparece no display (em caracteres) */
+#define LARGURA_CAMINHO 40
+#define ALTURA_CAMINHO 20
+
+/* Quantas colunas o caminho ocupa para cada lado do seu centro */
+#define MEIA_LARGURA_CAMINHO 2
+
+/* Uma linha ou coluna em ponto fixo */
+#define FISICA_UNIDADE 256
+
+/* Quanto a bolinha desce a cada job de T5 (5ms): 1/32 de linha, ou seja, uma linha a cada 160ms */
+#define VELOCIDADE_BOLA (FISICA_UNIDADE / 32)
+
+/* Janela do caminho produzida por T2 e usada por T1 (desenho) e T5 (física).
+   Os limites de cada linha ficam em vetores separados (esquerda e direita) para que o
+   teste de queda percorra a janela de forma vetorizável. O índice 0 corresponde à linha
+   linha_base, que fica um pouco atrás da bolinha. segmento guarda o id do segmento do
+   caminho ao qual cada linha pertence, usado para achar os diamantes da linha. */
+typedef struct
+{
+	uint32_t sequencia;
+	int32_t linha_base;
+	int16_t esquerda[ALTURA_CAMINHO];
+	int16_t direita[ALTURA_CAMINHO];
+	uint32_t segmento[ALTURA_CAMINHO];
+} QuadroCaminho;
+
+/* Posição (x = coluna, y = linha) e velocidade da bolinha, em ponto fixo */
+typedef struct
+{
+	int32_t x;
+	int32_t y;
+	int32_t vx;
+	int32_t vy;
+} Bola;
+
+/* Coloca a bolinha no centro da coluna e da linha dadas, descendo para a esquerda */
+void inicializa_bola(Bola *bola, int32_t linha, int32_t coluna);
+
+/* Faz a bolinha seguir para a direita (direita != 0) ou para a esquerda */
+void muda_sentido_da_bola(Bola *bola, int direita);
+
+/* Avança a bolinha o equivalente a um job de T5 */
+void move_bola(Bola *bola);
+
+/* Retorna quantas linhas a bolinha ainda percorre no sentido atual antes de sair do caminho:
+	-> 0: a bolinha já está fora do caminho, ou seja, caiu
+	-> -1: a bolinha não sai do caminho dentro da janela
+	-> -2: a linha da bolinha não está na janela, então nada pode ser afirmado */
+int linhas_ate_queda(const Bola *bola, const QuadroCaminho *quadro);
+
+#endif /* FISICA_H */
@@ -108,6 +108,7 @@ functions anyway. */
 #define INCLUDE_xSemaphoreGetMutexHolder		1
 #define INCLUDE_xTimerPendFunctionCall			1
 #define INCLUDE_xTaskAbortDelay					1
+#define INCLUDE_xTaskGetCurrentTaskHandle		1
 
 /* It is a good idea to define configASSERT() while developing.  configASSERT()
 uses the same semantics as the standard C assert() macro. */
@@ -120,7 +121,49 @@ extern void vAssertCalled( unsigned long ulLine, const char * const pcFileName )
 	#define sbSEND_COMPLETED( pxStreamBuffer ) vGenerateCoreBInterrupt( pxStreamBuffer )
 #endif /* configINCLUDE_MESSAGE_BUFFER_AMP_DEMO */
 
+/* Let the idle task sleep the host thread while every task is blocked - see
+TicklessIdle.h.  TickType_t is not yet defined here, so uint32_t is used. */
+#define configUSE_TICKLESS_IDLE					2
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP	2
+extern void vTicklessIdleSleep( uint32_t xExpectedIdleTime );
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vTicklessIdleSleep( xExpectedIdleTime )
+
+/* Record the numbers drawn by the application's Random_t generators, so a run
+can be replayed - see Replay.h. */
+extern void vReplayRandomDraw( uint64_t ullStream, uint32_t ulValue );
+#define traceRANDOM_DRAW( pxRandom, ulValue ) vReplayRandomDraw( ( pxRandom )->ullIncrement >> 1, ( ulValue ) )
+
 /* Include the FreeRTOS+Trace FreeRTOS trace macro definitions. */
 #include "trcRecorder.h"
 
+/* Let the OS tick, ready and memory management events be turned off at
+runtime - see TraceFilter.h.  These are the snapshot recorder's own
+definitions of the macros, with the test of the event class added in front of
+the call into the recorder.  The OS tick macro still advances the recorder's
+time base when the tick events are filtered out, and the ready macro also puts
+new tasks in the scheduling group while only scheduling events are stored. */
+#include "TraceFilter.h"
+
+#if ( TRC_CFG_RECORDER_MODE == TRC_RECORDER_MODE_SNAPSHOT )
+	#undef traceTASK_INCREMENT_TICK
+	#define traceTASK_INCREMENT_TICK( xTickCount ) \
+		if( ( uxSchedulerSuspended == ( UBaseType_t ) pdTRUE ) || ( uxPendedTicks == 0 ) ) { trcKERNEL_HOOKS_INCREMENT_TICK(); } \
+		if( ( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE ) && tracefilterENABLED( tracefilterOS_TICK ) ) { trcKERNEL_HOOKS_NEW_TIME( DIV_NEW_TIME, ( xTickCount ) + 1 ); }
+
+	#undef traceMOVED_TASK_TO_READY_STATE
+	#define traceMOVED_TASK_TO_READY_STATE( pxTCB ) \
+		tracefilterTASK_READY( pxTCB ) \
+		if( tracefilterENABLED( tracefilterREADY ) ) { trcKERNEL_HOOKS_MOVED_TASK_TO_READY_STATE( pxTCB ); }
+
+	#if ( TRC_CFG_INCLUDE_MEMMANG_EVENTS == 1 )
+		#undef traceMALLOC
+		#define traceMALLOC( pvAddress, uiSize ) \
+			if( ( ( pvAddress ) != 0 ) && tracefilterENABLED( tracefilterMEMORY ) ) { vTraceStoreMemMangEvent( MEM_MALLOC_SIZE, ( uint32_t ) ( pvAddress ), ( int32_t ) ( uiSize ) ); }
+
+		#undef traceFREE
+		#define traceFREE( pvAddress, uiSize ) \
+			if( tracefilterENABLED( tracefilterMEMORY ) ) { vTraceStoreMemMangEvent( MEM_FREE_SIZE, ( uint32_t ) ( pvAddress ), ( int32_t ) ( -( int32_t ) ( uiSize ) ) ); }
+	#endif
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
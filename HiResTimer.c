@@ -0,0 +1,318 @@
+/*
+ * High resolution task releases for the Win32 simulator.  See the comments
+ * in HiResTimer.h.
+ */
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "HiResTimer.h"
+#include "TicklessIdle.h"
+#include "TraceFilter.h"
+
+/* Not defined by the Windows headers for versions of Windows older than
+Windows 10 version 1803, which ignore it. */
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+	#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION	0x00000002
+#endif
+
+/* No release is waiting. */
+#define hiresNO_RELEASE					( ~( ( uint64_t ) 0 ) )
+
+typedef struct xHIRES_RELEASE
+{
+	TaskHandle_t xTask;
+	uint64_t ullRelease;				/* hiresNO_RELEASE when not waiting. */
+	HiResReleaseHook_t pxHook;			/* NULL if there is none. */
+	void *pvHookParameter;
+} HiResRelease_t;
+
+/*
+ * The host thread that generates the interrupt at each release instant.
+ */
+static DWORD WINAPI prvTimerThread( LPVOID lpParameter );
+
+/*
+ * The simulated interrupt handler.  Notifies the tasks that are due.
+ */
+static uint32_t prvReleaseInterruptHandler( void );
+
+/*
+ * Find the earliest release instant and tell the host thread about it.  Must
+ * be called from a critical section or from the interrupt handler.
+ */
+static void prvUpdateNextRelease( void );
+
+/*
+ * The release of the calling task, taken now if it has none yet.  Must be
+ * called from a critical section.
+ */
+static HiResRelease_t *prvGetRelease( void );
+
+/*-----------------------------------------------------------*/
+
+static HiResRelease_t xReleases[ hiresMAX_TASKS ];
+static UBaseType_t uxReleaseCount = 0;
+
+/* The earliest release instant, read by the host thread.  Accessed with
+interlocked functions as the host thread is not a FreeRTOS task and can not
+enter a critical section. */
+static volatile LONGLONG llNextRelease = ( LONGLONG ) hiresNO_RELEASE;
+
+/* Signalled when llNextRelease changes. */
+static HANDLE xRearmEvent = NULL;
+
+static LARGE_INTEGER liFrequency, liStart;
+static volatile uint32_t ulMaxLateness = 0UL;
+
+/* The interrupt, as the trace recorder knows it. */
+static traceHandle xTraceISR;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xHiResTimerInitialise( void )
+{
+BaseType_t xReturn = pdFAIL;
+HANDLE xThread;
+UBaseType_t x;
+
+	for( x = 0; x < hiresMAX_TASKS; x++ )
+	{
+		xReleases[ x ].ullRelease = hiresNO_RELEASE;
+	}
+
+	QueryPerformanceFrequency( &liFrequency );
+	QueryPerformanceCounter( &liStart );
+	xRearmEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+
+	if( xRearmEvent != NULL )
+	{
+		xTraceISR = xTraceSetISRProperties( "HiResRelease", hiresINTERRUPT_NUMBER );
+		vPortSetInterruptHandler( hiresINTERRUPT_NUMBER, prvReleaseInterruptHandler );
+
+		xThread = CreateThread( NULL, 0, prvTimerThread, NULL, CREATE_SUSPENDED, NULL );
+
+		if( xThread != NULL )
+		{
+			/* The thread must run as soon as a release is due, like the
+			thread that generates the tick in port.c. */
+			SetThreadPriority( xThread, THREAD_PRIORITY_TIME_CRITICAL );
+			SetThreadPriorityBoost( xThread, TRUE );
+			ResumeThread( xThread );
+			xReturn = pdPASS;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullHiResTimerNow( void )
+{
+LARGE_INTEGER liNow;
+uint64_t ullTicks;
+
+	QueryPerformanceCounter( &liNow );
+	ullTicks = ( uint64_t ) ( liNow.QuadPart - liStart.QuadPart );
+
+	/* Split to avoid overflowing the multiplication after long runs. */
+	return ( ( ullTicks / ( uint64_t ) liFrequency.QuadPart ) * 1000000ULL ) +
+		   ( ( ( ullTicks % ( uint64_t ) liFrequency.QuadPart ) * 1000000ULL ) / ( uint64_t ) liFrequency.QuadPart );
+}
+/*-----------------------------------------------------------*/
+
+void vHiResTimerDelayUntil( uint64_t *pullPreviousRelease, uint32_t ulPeriodUs )
+{
+HiResRelease_t *pxRelease;
+uint64_t ullRelease, ullNow;
+
+	ullRelease = *pullPreviousRelease + ulPeriodUs;
+	ullNow = ullHiResTimerNow();
+
+	if( ( ullRelease + ulPeriodUs ) < ullNow )
+	{
+		ullRelease = ullNow;
+	}
+
+	*pullPreviousRelease = ullRelease;
+
+	taskENTER_CRITICAL();
+	{
+		pxRelease = prvGetRelease();
+		pxRelease->ullRelease = ullRelease;
+		prvUpdateNextRelease();
+	}
+	taskEXIT_CRITICAL();
+
+	/* Given by the interrupt handler at the release instant. */
+	ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+}
+/*-----------------------------------------------------------*/
+
+void vHiResTimerSetReleaseHook( HiResReleaseHook_t pxHook, void *pvParameter )
+{
+HiResRelease_t *pxRelease;
+
+	taskENTER_CRITICAL();
+	{
+		pxRelease = prvGetRelease();
+		pxRelease->pxHook = pxHook;
+		pxRelease->pvHookParameter = pvParameter;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulHiResTimerGetMaxLateness( void )
+{
+	return ulMaxLateness;
+}
+/*-----------------------------------------------------------*/
+
+static DWORD WINAPI prvTimerThread( LPVOID lpParameter )
+{
+HANDLE xTimer, xObjects[ 2 ];
+LARGE_INTEGER liDueTime;
+uint64_t ullNext, ullNow, ullFired = hiresNO_RELEASE;
+
+	( void ) lpParameter;
+
+	xTimer = CreateWaitableTimerEx( NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS );
+
+	if( xTimer == NULL )
+	{
+		/* Older versions of Windows - a normal waitable timer, which wakes
+		later, so more of the wait is spent spinning. */
+		xTimer = CreateWaitableTimer( NULL, TRUE, NULL );
+	}
+
+	xObjects[ 0 ] = xRearmEvent;
+	xObjects[ 1 ] = xTimer;
+
+	for( ;; )
+	{
+		ullNext = ( uint64_t ) InterlockedCompareExchange64( &llNextRelease, 0, 0 );
+		ullNow = ullHiResTimerNow();
+
+		if( ( ullNext == hiresNO_RELEASE ) || ( ullNext == ullFired ) )
+		{
+			/* Nothing to release, or the interrupt for this release instant
+			has been generated and not handled yet. */
+			WaitForSingleObject( xRearmEvent, INFINITE );
+		}
+		else if( ullNow + hiresSPIN_MICROSECONDS < ullNext )
+		{
+			/* Sleep until shortly before the release instant, or until it
+			changes.  The due time is relative, in 100 ns units. */
+			liDueTime.QuadPart = -( ( LONGLONG ) ( ullNext - ullNow - hiresSPIN_MICROSECONDS ) * 10LL );
+			SetWaitableTimer( xTimer, &liDueTime, 0, NULL, NULL, FALSE );
+			WaitForMultipleObjects( 2, xObjects, FALSE, INFINITE );
+		}
+		else
+		{
+			while( ullHiResTimerNow() < ullNext )
+			{
+				/* Spin for the last few microseconds. */
+			}
+
+			ullFired = ullNext;
+			vPortGenerateSimulatedInterrupt( hiresINTERRUPT_NUMBER );
+		}
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvReleaseInterruptHandler( void )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+uint64_t ullNow = ullHiResTimerNow();
+uint32_t ulLateness;
+UBaseType_t x;
+
+	tracefilterISR_BEGIN( xTraceISR );
+
+	for( x = 0; x < uxReleaseCount; x++ )
+	{
+		if( xReleases[ x ].ullRelease <= ullNow )
+		{
+			ulLateness = ( uint32_t ) ( ullNow - xReleases[ x ].ullRelease );
+
+			if( ulLateness > ulMaxLateness )
+			{
+				ulMaxLateness = ulLateness;
+			}
+
+			xReleases[ x ].ullRelease = hiresNO_RELEASE;
+
+			if( xReleases[ x ].pxHook != NULL )
+			{
+				xReleases[ x ].pxHook( xReleases[ x ].pvHookParameter );
+			}
+
+			vTaskNotifyGiveFromISR( xReleases[ x ].xTask, &xHigherPriorityTaskWoken );
+		}
+	}
+
+	prvUpdateNextRelease();
+
+	/* The idle task may be sleeping with the scheduler suspended, until the
+	next tick based release, which would hold up the released task. */
+	if( xHigherPriorityTaskWoken != pdFALSE )
+	{
+		vTicklessIdleWake();
+	}
+
+	tracefilterISR_END( xHigherPriorityTaskWoken );
+
+	return ( uint32_t ) xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+static void prvUpdateNextRelease( void )
+{
+uint64_t ullNext = hiresNO_RELEASE;
+UBaseType_t x;
+
+	for( x = 0; x < uxReleaseCount; x++ )
+	{
+		if( xReleases[ x ].ullRelease < ullNext )
+		{
+			ullNext = xReleases[ x ].ullRelease;
+		}
+	}
+
+	InterlockedExchange64( &llNextRelease, ( LONGLONG ) ullNext );
+	SetEvent( xRearmEvent );
+}
+/*-----------------------------------------------------------*/
+
+static HiResRelease_t *prvGetRelease( void )
+{
+TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
+HiResRelease_t *pxRelease = NULL;
+UBaseType_t x;
+
+	for( x = 0; x < uxReleaseCount; x++ )
+	{
+		if( xReleases[ x ].xTask == xCurrentTask )
+		{
+			pxRelease = &( xReleases[ x ] );
+		}
+	}
+
+	if( ( pxRelease == NULL ) && ( uxReleaseCount < hiresMAX_TASKS ) )
+	{
+		pxRelease = &( xReleases[ uxReleaseCount ] );
+		pxRelease->xTask = xCurrentTask;
+		pxRelease->ullRelease = hiresNO_RELEASE;
+		uxReleaseCount++;
+	}
+
+	configASSERT( pxRelease );
+
+	return pxRelease;
+}
+/*-----------------------------------------------------------*/
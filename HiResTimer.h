@@ -0,0 +1,78 @@
+/*
+ * Task releases at microsecond instants, independent of the tick.
+ *
+ * vTaskDelayUntil() can only release a task on a tick, so with a 1 ms tick a
+ * task with a 5 ms period can be released up to a whole tick late, which is
+ * as long as its execution time.  A task that calls
+ * vHiResTimerDelayUntil() instead is blocked on its task notification, and a
+ * host thread waiting on a high resolution waitable timer generates a
+ * simulated interrupt at the task's release instant.  The interrupt handler
+ * notifies every task whose release instant has passed.
+ *
+ * The host thread wakes up shortly before the release instant and spins for
+ * the remaining time, as even a high resolution waitable timer can wake late
+ * by tens of microseconds.  Times are read from the host performance
+ * counter, in microseconds since vHiResTimerInitialise() was called.
+ */
+
+#ifndef HIRES_TIMER_H
+#define HIRES_TIMER_H
+
+#include "task.h"
+
+/* The simulated interrupt used to release tasks.  The Win32 port uses the
+lowest interrupt numbers for the yield and the tick. */
+#ifndef hiresINTERRUPT_NUMBER
+	#define hiresINTERRUPT_NUMBER		( 3UL )
+#endif
+
+/* The maximum number of tasks that can use the timer. */
+#define hiresMAX_TASKS					( 8 )
+
+/* How long before a release instant the host thread stops sleeping and
+spins, in microseconds. */
+#define hiresSPIN_MICROSECONDS			( 200ULL )
+
+/*
+ * Create the host thread and install the interrupt handler.  Must be called
+ * from vApplicationDaemonTaskStartupHook(), or from a task, as the Win32 port
+ * only accepts interrupt handlers once the scheduler has started.
+ */
+BaseType_t xHiResTimerInitialise( void );
+
+/*
+ * Microseconds since xHiResTimerInitialise() was called.
+ */
+uint64_t ullHiResTimerNow( void );
+
+/*
+ * Block the calling task until *pullPreviousRelease + ulPeriodUs, then set
+ * *pullPreviousRelease to that instant, so a periodic task does not drift.
+ * Set *pullPreviousRelease to ullHiResTimerNow() before the first call.  If
+ * the release instant has already passed by more than a period, the task is
+ * released straight away and the next period starts from now, so a task that
+ * was held up does not run a burst of late jobs.
+ */
+void vHiResTimerDelayUntil( uint64_t *pullPreviousRelease, uint32_t ulPeriodUs );
+
+/*
+ * A function called by the interrupt handler when a task is released, with
+ * the parameter given to vHiResTimerSetReleaseHook().
+ */
+typedef void ( *HiResReleaseHook_t )( void *pvParameter );
+
+/*
+ * Have pxHook called with pvParameter each time the calling task is released,
+ * just before it is notified, for example to mark the release in the trace at
+ * the release instant.  pxHook runs in the interrupt handler, so must not
+ * block and must only use the FromISR API.
+ */
+void vHiResTimerSetReleaseHook( HiResReleaseHook_t pxHook, void *pvParameter );
+
+/*
+ * The largest lateness measured between a release instant and the interrupt
+ * that released it, in microseconds.
+ */
+uint32_t ulHiResTimerGetMaxLateness( void );
+
+#endif /* HIRES_TIMER_H */
@@ -0,0 +1,671 @@
+/*
+ * Simulated interrupt to task latency measurements.  See the comments in
+ * IrqLatency.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <semphr.h>
+#include <stream_buffer.h>
+#include <event_groups.h>
+
+#include "IrqLatency.h"
+#include "TicklessIdle.h"
+#include "TraceFilter.h"
+
+/* The ways the interrupt handler unblocks the woken task. */
+typedef enum
+{
+	eIrqLatencyNotification = 0,
+	eIrqLatencySemaphore,
+	eIrqLatencyQueue,
+	eIrqLatencyStreamBuffer,
+	eIrqLatencyEventGroup,
+	eIrqLatencyMechanismCount
+} IrqLatencyMechanism_t;
+
+/* The spans of each sample. */
+typedef enum
+{
+	eIrqLatencyToHandler = 0,
+	eIrqLatencyHandlerToTask,
+	eIrqLatencyToTask,
+	eIrqLatencySpanCount
+} IrqLatencySpan_t;
+
+/* The states of the sample in flight.  The generating thread claims a sample
+before it takes the first time stamp, so the sample is only checked for
+being lost once that time stamp is valid.  A lost sample stays in flight until
+its task is blocked again. */
+#define irqlatencyIDLE					( 0 )
+#define irqlatencyCLAIMED				( 1 )
+#define irqlatencyGENERATED				( 2 )
+#define irqlatencyLOST					( 3 )
+
+/* The bit the event group mechanism sets. */
+#define irqlatencyEVENT_BIT				( ( EventBits_t ) 0x01 )
+
+/* The number of priorities each mechanism is measured at. */
+#define irqlatencyGAP_COUNT				( sizeof( xPriorityGaps ) / sizeof( xPriorityGaps[ 0 ] ) )
+
+typedef struct xIRQ_LATENCY_TIMES
+{
+	uint32_t ulSamples;
+	uint64_t ullTotal;			/* In performance counter counts. */
+	uint32_t ulMinimum;
+	uint32_t ulMaximum;
+	uint32_t ulHistogram[ irqlatencyHISTOGRAM_BUCKETS ];
+} IrqLatencyTimes_t;
+
+typedef struct xIRQ_LATENCY_CASE
+{
+	IrqLatencyTimes_t xSpans[ eIrqLatencySpanCount ];
+	uint32_t ulLost;
+} IrqLatencyCase_t;
+
+/*
+ * The task that steps through the cases.
+ */
+static void prvControlTask( void *pvParameters );
+
+/*
+ * The task that keeps the processor busy at the background priority while a
+ * case is measured.
+ */
+static void prvBackgroundTask( void *pvParameters );
+
+/*
+ * The task woken through the mechanism passed as its parameter.
+ */
+static void prvWokenTask( void *pvParameters );
+
+/*
+ * The host thread that generates the interrupts.
+ */
+static DWORD WINAPI prvGeneratorThread( LPVOID lpParameter );
+
+/*
+ * The simulated interrupt handler.  Unblocks the task of the current
+ * mechanism.
+ */
+static uint32_t prvInterruptHandler( void );
+
+/*
+ * Record the sample in flight, which the woken task received at llWoken.
+ */
+static void prvRecordSample( LONGLONG llWoken );
+
+/*
+ * Count the sample in flight as lost if it has waited too long, and end a lost
+ * sample once its task is blocked again.
+ */
+static void prvCheckForLostSample( void );
+
+/*
+ * Remove whatever the interrupt handler sent through the current mechanism,
+ * so a lost sample does not wake its task during the next one.
+ */
+static void prvDrainMechanism( void );
+
+/*
+ * Add one time, in performance counter counts, to pxTimes.
+ */
+static void prvRecordTime( IrqLatencyTimes_t *pxTimes, uint32_t ulCounts );
+
+/*
+ * Convert performance counter counts to microseconds.
+ */
+static double prvCountsToMicroseconds( uint64_t ullCounts );
+
+/*-----------------------------------------------------------*/
+
+static const char * const pcMechanismNames[ eIrqLatencyMechanismCount ] =
+{
+	"Notification", "Semaphore", "Queue", "StreamBuffer", "EventGroup"
+};
+
+static const char * const pcSpanNames[ eIrqLatencySpanCount ] =
+{
+	"generate_to_handler", "handler_to_task", "generate_to_task"
+};
+
+/* The priority of the woken task relative to the background task, in the
+order the cases are measured. */
+static const BaseType_t xPriorityGaps[] = { -1, 0, 1, 2 };
+
+static IrqLatencyCase_t xCases[ eIrqLatencyMechanismCount ][ irqlatencyGAP_COUNT ];
+
+/* The case being measured, only changed while no sample is in flight. */
+static volatile IrqLatencyMechanism_t eMechanism = eIrqLatencyNotification;
+static volatile UBaseType_t uxGap = 0;
+static volatile uint32_t ulCaseSamples = 0;
+
+/* Shared with the generating thread, which is not a FreeRTOS task and can not
+enter a critical section, so accessed with interlocked functions. */
+static volatile LONG lArmed = 0;
+static volatile LONG lInFlight = irqlatencyIDLE;
+static volatile LONGLONG llGenerated = 0, llHandled = 0;
+
+static TaskHandle_t xWokenTasks[ eIrqLatencyMechanismCount ];
+static TaskHandle_t xBackgroundTask = NULL;
+static SemaphoreHandle_t xSemaphore = NULL;
+static QueueHandle_t xQueue = NULL;
+static StreamBufferHandle_t xStreamBuffer = NULL;
+static EventGroupHandle_t xEventGroup = NULL;
+
+static UBaseType_t uxBackground = 0;
+static uint32_t ulSamplesRequired = 0;
+static volatile BaseType_t xBackgroundRunning = pdFALSE;
+static volatile BaseType_t xComplete = pdFALSE;
+static LONGLONG llCountsPerSecond = 0;
+
+/* The interrupt, as the trace recorder knows it. */
+static traceHandle xTraceISR;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xIrqLatencyStart( UBaseType_t uxBackgroundPriority, uint32_t ulSamplesPerCase )
+{
+LARGE_INTEGER liFrequency;
+HANDLE xThread;
+UBaseType_t x;
+
+	configASSERT( uxBackgroundPriority >= 1 );
+	configASSERT( ( uxBackgroundPriority + 3 ) <= irqlatencyCONTROL_PRIORITY );
+	configASSERT( ulSamplesPerCase > 0 );
+
+	QueryPerformanceFrequency( &liFrequency );
+	llCountsPerSecond = liFrequency.QuadPart;
+	uxBackground = uxBackgroundPriority;
+	ulSamplesRequired = ulSamplesPerCase;
+
+	xSemaphore = xSemaphoreCreateBinary();
+	xQueue = xQueueCreate( 1, sizeof( uint32_t ) );
+	xStreamBuffer = xStreamBufferCreate( sizeof( uint32_t ) * 2, sizeof( uint32_t ) );
+	xEventGroup = xEventGroupCreate();
+
+	if( ( xSemaphore == NULL ) || ( xQueue == NULL ) || ( xStreamBuffer == NULL ) || ( xEventGroup == NULL ) )
+	{
+		return pdFAIL;
+	}
+
+	/* The tasks are all created now, and none of them is ever deleted, so the
+	number of tasks does not change while the harness runs. */
+	for( x = 0; x < eIrqLatencyMechanismCount; x++ )
+	{
+		if( xTaskCreate( prvWokenTask, "IrqWoken", configMINIMAL_STACK_SIZE, ( void * ) x, uxBackgroundPriority, &( xWokenTasks[ x ] ) ) != pdPASS )
+		{
+			return pdFAIL;
+		}
+	}
+
+	if( ( xTaskCreate( prvBackgroundTask, "IrqBusy", configMINIMAL_STACK_SIZE, NULL, uxBackgroundPriority, &xBackgroundTask ) != pdPASS ) ||
+		( xTaskCreate( prvControlTask, "IrqCtrl", configMINIMAL_STACK_SIZE, NULL, irqlatencyCONTROL_PRIORITY, NULL ) != pdPASS ) )
+	{
+		return pdFAIL;
+	}
+
+	xTraceISR = xTraceSetISRProperties( "IrqLatency", irqlatencyINTERRUPT_NUMBER );
+	vPortSetInterruptHandler( irqlatencyINTERRUPT_NUMBER, prvInterruptHandler );
+
+	xThread = CreateThread( NULL, 0, prvGeneratorThread, NULL, CREATE_SUSPENDED, NULL );
+
+	if( xThread == NULL )
+	{
+		return pdFAIL;
+	}
+
+	/* As in HiResTimer.c, the thread must not be held up by the threads that
+	run the tasks, or the time stamp it takes would not be the time the
+	interrupt was generated. */
+	SetThreadPriority( xThread, THREAD_PRIORITY_TIME_CRITICAL );
+	SetThreadPriorityBoost( xThread, TRUE );
+	ResumeThread( xThread );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIrqLatencyIsComplete( void )
+{
+	return xComplete;
+}
+/*-----------------------------------------------------------*/
+
+void vIrqLatencyPrintReport( void )
+{
+const IrqLatencyCase_t *pxCase;
+UBaseType_t uxMechanism, x;
+double dMean[ eIrqLatencySpanCount ];
+IrqLatencySpan_t eSpan;
+
+	printf( "\r\nInterrupt latency  Gap  Samples  Lost  Handler mean/max (us)  Task mean/max (us)  Total min/mean/max (us)%s\r\n",
+			( xComplete != pdFALSE ) ? "" : "  (incomplete)" );
+
+	for( uxMechanism = 0; uxMechanism < eIrqLatencyMechanismCount; uxMechanism++ )
+	{
+		for( x = 0; x < irqlatencyGAP_COUNT; x++ )
+		{
+			pxCase = &( xCases[ uxMechanism ][ x ] );
+
+			for( eSpan = eIrqLatencyToHandler; eSpan < eIrqLatencySpanCount; eSpan++ )
+			{
+				dMean[ eSpan ] = 0.0;
+
+				if( pxCase->xSpans[ eSpan ].ulSamples > 0UL )
+				{
+					dMean[ eSpan ] = prvCountsToMicroseconds( pxCase->xSpans[ eSpan ].ullTotal ) / ( double ) pxCase->xSpans[ eSpan ].ulSamples;
+				}
+			}
+
+			printf( "%-17s  %+3ld  %7lu  %4lu  %9.1f / %9.1f  %8.1f / %7.1f  %6.1f / %6.1f / %7.1f\r\n", pcMechanismNames[ uxMechanism ],
+					( long ) xPriorityGaps[ x ], ( unsigned long ) pxCase->xSpans[ eIrqLatencyToTask ].ulSamples, ( unsigned long ) pxCase->ulLost,
+					dMean[ eIrqLatencyToHandler ], prvCountsToMicroseconds( pxCase->xSpans[ eIrqLatencyToHandler ].ulMaximum ),
+					dMean[ eIrqLatencyHandlerToTask ], prvCountsToMicroseconds( pxCase->xSpans[ eIrqLatencyHandlerToTask ].ulMaximum ),
+					prvCountsToMicroseconds( pxCase->xSpans[ eIrqLatencyToTask ].ulMinimum ), dMean[ eIrqLatencyToTask ],
+					prvCountsToMicroseconds( pxCase->xSpans[ eIrqLatencyToTask ].ulMaximum ) );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xIrqLatencyWriteResults( const char *pcFileName )
+{
+const IrqLatencyTimes_t *pxTimes;
+FILE *pxFile;
+UBaseType_t uxMechanism, x, uxBucket;
+IrqLatencySpan_t eSpan;
+
+	pxFile = fopen( pcFileName, "w" );
+
+	if( pxFile == NULL )
+	{
+		return pdFAIL;
+	}
+
+	/* Histogram bucket n counts the samples below 2^n microseconds. */
+	fprintf( pxFile, "mechanism,priority_gap,samples,lost,span,min_us,mean_us,max_us" );
+
+	for( uxBucket = 0; uxBucket < irqlatencyHISTOGRAM_BUCKETS; uxBucket++ )
+	{
+		fprintf( pxFile, ",hist_%lu", ( unsigned long ) uxBucket );
+	}
+
+	fprintf( pxFile, "\n" );
+
+	for( uxMechanism = 0; uxMechanism < eIrqLatencyMechanismCount; uxMechanism++ )
+	{
+		for( x = 0; x < irqlatencyGAP_COUNT; x++ )
+		{
+			for( eSpan = eIrqLatencyToHandler; eSpan < eIrqLatencySpanCount; eSpan++ )
+			{
+				pxTimes = &( xCases[ uxMechanism ][ x ].xSpans[ eSpan ] );
+
+				fprintf( pxFile, "%s,%ld,%lu,%lu,%s,%.2f,%.2f,%.2f", pcMechanismNames[ uxMechanism ], ( long ) xPriorityGaps[ x ],
+						 ( unsigned long ) pxTimes->ulSamples, ( unsigned long ) xCases[ uxMechanism ][ x ].ulLost, pcSpanNames[ eSpan ],
+						 prvCountsToMicroseconds( pxTimes->ulMinimum ),
+						 ( pxTimes->ulSamples > 0UL ) ? prvCountsToMicroseconds( pxTimes->ullTotal ) / ( double ) pxTimes->ulSamples : 0.0,
+						 prvCountsToMicroseconds( pxTimes->ulMaximum ) );
+
+				for( uxBucket = 0; uxBucket < irqlatencyHISTOGRAM_BUCKETS; uxBucket++ )
+				{
+					fprintf( pxFile, ",%lu", ( unsigned long ) pxTimes->ulHistogram[ uxBucket ] );
+				}
+
+				fprintf( pxFile, "\n" );
+			}
+		}
+	}
+
+	fclose( pxFile );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvControlTask( void *pvParameters )
+{
+UBaseType_t uxMechanism, x;
+
+	( void ) pvParameters;
+
+	for( uxMechanism = 0; uxMechanism < eIrqLatencyMechanismCount; uxMechanism++ )
+	{
+		for( x = 0; x < irqlatencyGAP_COUNT; x++ )
+		{
+			/* No sample is in flight, so the case can change. */
+			vTaskPrioritySet( xWokenTasks[ uxMechanism ], ( UBaseType_t ) ( ( BaseType_t ) uxBackground + xPriorityGaps[ x ] ) );
+			eMechanism = ( IrqLatencyMechanism_t ) uxMechanism;
+			uxGap = x;
+			ulCaseSamples = 0;
+
+			xBackgroundRunning = pdTRUE;
+			xTaskNotifyGive( xBackgroundTask );
+			InterlockedExchange( &lArmed, 1 );
+
+			while( ulCaseSamples < ulSamplesRequired )
+			{
+				vTaskDelay( pdMS_TO_TICKS( 10 ) );
+				prvCheckForLostSample();
+			}
+
+			/* Stop generating, then wait for the last sample to arrive or be
+			lost. */
+			InterlockedExchange( &lArmed, 0 );
+
+			while( InterlockedCompareExchange( &lInFlight, irqlatencyIDLE, irqlatencyIDLE ) != irqlatencyIDLE )
+			{
+				vTaskDelay( pdMS_TO_TICKS( 10 ) );
+				prvCheckForLostSample();
+			}
+
+			xBackgroundRunning = pdFALSE;
+		}
+	}
+
+	xComplete = pdTRUE;
+
+	/* Deleting the task would change the number of tasks, which the death
+	demo checks. */
+	vTaskSuspend( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBackgroundTask( void *pvParameters )
+{
+LARGE_INTEGER liStart, liNow;
+LONGLONG llBusyCounts;
+
+	( void ) pvParameters;
+
+	llBusyCounts = ( llCountsPerSecond * ( LONGLONG ) irqlatencyBUSY_US ) / 1000000LL;
+
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+		while( xBackgroundRunning != pdFALSE )
+		{
+			QueryPerformanceCounter( &liStart );
+
+			do
+			{
+				QueryPerformanceCounter( &liNow );
+			} while( ( liNow.QuadPart - liStart.QuadPart ) < llBusyCounts );
+
+			vTaskDelay( 1 );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvWokenTask( void *pvParameters )
+{
+const IrqLatencyMechanism_t eOwnMechanism = ( IrqLatencyMechanism_t ) ( size_t ) pvParameters;
+LARGE_INTEGER liWoken;
+uint32_t ulValue;
+BaseType_t xReceived = pdFALSE;
+
+	for( ;; )
+	{
+		switch( eOwnMechanism )
+		{
+			case eIrqLatencyNotification:
+				xReceived = ( ulTaskNotifyTake( pdTRUE, portMAX_DELAY ) != 0UL ) ? pdTRUE : pdFALSE;
+				break;
+
+			case eIrqLatencySemaphore:
+				xReceived = xSemaphoreTake( xSemaphore, portMAX_DELAY );
+				break;
+
+			case eIrqLatencyQueue:
+				xReceived = xQueueReceive( xQueue, &ulValue, portMAX_DELAY );
+				break;
+
+			case eIrqLatencyStreamBuffer:
+				xReceived = ( xStreamBufferReceive( xStreamBuffer, &ulValue, sizeof( ulValue ), portMAX_DELAY ) == sizeof( ulValue ) ) ? pdTRUE : pdFALSE;
+				break;
+
+			case eIrqLatencyEventGroup:
+				xReceived = ( ( xEventGroupWaitBits( xEventGroup, irqlatencyEVENT_BIT, pdTRUE, pdFALSE, portMAX_DELAY ) & irqlatencyEVENT_BIT ) != 0 ) ? pdTRUE : pdFALSE;
+				break;
+
+			default:
+				configASSERT( pdFALSE );
+				break;
+		}
+
+		/* Taken as soon as the task runs again, before anything else. */
+		QueryPerformanceCounter( &liWoken );
+
+		if( xReceived != pdFALSE )
+		{
+			prvRecordSample( liWoken.QuadPart );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static DWORD WINAPI prvGeneratorThread( LPVOID lpParameter )
+{
+LARGE_INTEGER liNow;
+
+	( void ) lpParameter;
+
+	for( ;; )
+	{
+		/* Wait from 1 to 4 milliseconds, taken from the low bits of the
+		counter, so interrupts fall at varying points of the tick period. */
+		QueryPerformanceCounter( &liNow );
+		Sleep( 1UL + ( DWORD ) ( liNow.QuadPart % 4 ) );
+
+		if( InterlockedCompareExchange( &lInFlight, irqlatencyCLAIMED, irqlatencyIDLE ) == irqlatencyIDLE )
+		{
+			/* The control task only changes the case while no sample is in
+			flight, so it is checked to be armed after the sample is
+			claimed. */
+			if( InterlockedCompareExchange( &lArmed, 0, 0 ) != 0 )
+			{
+				QueryPerformanceCounter( &liNow );
+				llGenerated = liNow.QuadPart;
+				InterlockedExchange( &lInFlight, irqlatencyGENERATED );
+				vPortGenerateSimulatedInterrupt( irqlatencyINTERRUPT_NUMBER );
+			}
+			else
+			{
+				InterlockedExchange( &lInFlight, irqlatencyIDLE );
+			}
+		}
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvInterruptHandler( void )
+{
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+LARGE_INTEGER liNow;
+uint32_t ulValue = 0;
+
+	QueryPerformanceCounter( &liNow );
+	llHandled = liNow.QuadPart;
+
+	/* Stored after the time stamp, so the recorder's time is only counted
+	in the span from the handler to the task, and not at all while the ISR
+	event class is filtered out. */
+	tracefilterISR_BEGIN( xTraceISR );
+
+	/* A sample already counted as lost is not delivered late. */
+	if( InterlockedCompareExchange( &lInFlight, irqlatencyGENERATED, irqlatencyGENERATED ) != irqlatencyGENERATED )
+	{
+		tracefilterISR_END( pdFALSE );
+		return pdFALSE;
+	}
+
+	switch( eMechanism )
+	{
+		case eIrqLatencyNotification:
+			vTaskNotifyGiveFromISR( xWokenTasks[ eIrqLatencyNotification ], &xHigherPriorityTaskWoken );
+			break;
+
+		case eIrqLatencySemaphore:
+			xSemaphoreGiveFromISR( xSemaphore, &xHigherPriorityTaskWoken );
+			break;
+
+		case eIrqLatencyQueue:
+			xQueueSendFromISR( xQueue, &ulValue, &xHigherPriorityTaskWoken );
+			break;
+
+		case eIrqLatencyStreamBuffer:
+			xStreamBufferSendFromISR( xStreamBuffer, &ulValue, sizeof( ulValue ), &xHigherPriorityTaskWoken );
+			break;
+
+		case eIrqLatencyEventGroup:
+			/* Pended to the timer task, which sets the bit. */
+			xEventGroupSetBitsFromISR( xEventGroup, irqlatencyEVENT_BIT, &xHigherPriorityTaskWoken );
+			break;
+
+		default:
+			break;
+	}
+
+	/* The idle task may be sleeping with the scheduler suspended, as in
+	HiResTimer.c. */
+	if( xHigherPriorityTaskWoken != pdFALSE )
+	{
+		vTicklessIdleWake();
+	}
+
+	tracefilterISR_END( xHigherPriorityTaskWoken );
+
+	return ( uint32_t ) xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordSample( LONGLONG llWoken )
+{
+IrqLatencyCase_t *pxCase = &( xCases[ eMechanism ][ uxGap ] );
+LONGLONG llSampleGenerated = llGenerated, llSampleHandled = llHandled;
+
+	/* The time stamps are only valid if the sample was not counted as lost
+	while the task waited.  The next sample is not generated until the task
+	has blocked again, so it can not be this one. */
+	if( InterlockedCompareExchange( &lInFlight, irqlatencyIDLE, irqlatencyGENERATED ) == irqlatencyGENERATED )
+	{
+		prvRecordTime( &( pxCase->xSpans[ eIrqLatencyToHandler ] ), ( uint32_t ) ( llSampleHandled - llSampleGenerated ) );
+		prvRecordTime( &( pxCase->xSpans[ eIrqLatencyHandlerToTask ] ), ( uint32_t ) ( llWoken - llSampleHandled ) );
+		prvRecordTime( &( pxCase->xSpans[ eIrqLatencyToTask ] ), ( uint32_t ) ( llWoken - llSampleGenerated ) );
+		ulCaseSamples++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckForLostSample( void )
+{
+LARGE_INTEGER liNow;
+LONGLONG llTimeout = ( llCountsPerSecond * ( LONGLONG ) irqlatencyLOST_TIMEOUT_MS ) / 1000LL;
+eTaskState eState;
+
+	QueryPerformanceCounter( &liNow );
+
+	if( ( InterlockedCompareExchange( &lInFlight, irqlatencyGENERATED, irqlatencyGENERATED ) == irqlatencyGENERATED ) &&
+		( ( liNow.QuadPart - llGenerated ) > llTimeout ) )
+	{
+		/* Once the sample is lost the handler sends nothing more for it, so
+		what it sent can be removed. */
+		if( InterlockedCompareExchange( &lInFlight, irqlatencyLOST, irqlatencyGENERATED ) == irqlatencyGENERATED )
+		{
+			xCases[ eMechanism ][ uxGap ].ulLost++;
+			prvDrainMechanism();
+		}
+	}
+
+	if( InterlockedCompareExchange( &lInFlight, irqlatencyLOST, irqlatencyLOST ) == irqlatencyLOST )
+	{
+		/* The task may still have been readied by the lost sample.  A task
+		waiting for a notification without a time out is reported as
+		suspended rather than blocked. */
+		eState = eTaskGetState( xWokenTasks[ eMechanism ] );
+
+		if( ( eState == eBlocked ) || ( eState == eSuspended ) )
+		{
+			InterlockedExchange( &lInFlight, irqlatencyIDLE );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvDrainMechanism( void )
+{
+uint32_t ulValue;
+
+	switch( eMechanism )
+	{
+		case eIrqLatencyNotification:
+			/* ulTaskNotifyTake() returns 0, and the task waits again, if the
+			value is cleared before it runs. */
+			xTaskNotify( xWokenTasks[ eIrqLatencyNotification ], 0UL, eSetValueWithOverwrite );
+			break;
+
+		case eIrqLatencySemaphore:
+			xSemaphoreTake( xSemaphore, 0 );
+			break;
+
+		case eIrqLatencyQueue:
+			xQueueReceive( xQueue, &ulValue, 0 );
+			break;
+
+		case eIrqLatencyStreamBuffer:
+			xStreamBufferReceive( xStreamBuffer, &ulValue, sizeof( ulValue ), 0 );
+			break;
+
+		case eIrqLatencyEventGroup:
+			xEventGroupClearBits( xEventGroup, irqlatencyEVENT_BIT );
+			break;
+
+		default:
+			break;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordTime( IrqLatencyTimes_t *pxTimes, uint32_t ulCounts )
+{
+uint64_t ullMicroseconds = ( ( uint64_t ) ulCounts * 1000000ULL ) / ( uint64_t ) llCountsPerSecond;
+UBaseType_t uxBucket = 0;
+
+	if( ( pxTimes->ulSamples == 0UL ) || ( ulCounts < pxTimes->ulMinimum ) )
+	{
+		pxTimes->ulMinimum = ulCounts;
+	}
+
+	if( ulCounts > pxTimes->ulMaximum )
+	{
+		pxTimes->ulMaximum = ulCounts;
+	}
+
+	pxTimes->ulSamples++;
+	pxTimes->ullTotal += ulCounts;
+
+	/* Bucket n holds times below 2^n microseconds. */
+	while( ( ullMicroseconds > 0ULL ) && ( uxBucket < ( irqlatencyHISTOGRAM_BUCKETS - 1 ) ) )
+	{
+		ullMicroseconds >>= 1;
+		uxBucket++;
+	}
+
+	pxTimes->ulHistogram[ uxBucket ]++;
+}
+/*-----------------------------------------------------------*/
+
+static double prvCountsToMicroseconds( uint64_t ullCounts )
+{
+	return ( llCountsPerSecond > 0 ) ? ( ( double ) ullCounts * 1000000.0 ) / ( double ) llCountsPerSecond : 0.0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,80 @@
+/*
+ * Measures how long a simulated interrupt takes to run the task it unblocks.
+ *
+ * A host thread generates a simulated interrupt every few milliseconds,
+ * noting the performance counter just before it does.  The interrupt handler
+ * notes the counter again and unblocks a task through one of several
+ * mechanisms, and the task notes the counter as soon as its blocking call
+ * returns.  Each sample therefore has three spans: from generation to the
+ * handler, which is the simulator's own interrupt latency, from the handler to
+ * the task, which is the cost of the mechanism and of the context switch, and
+ * the total of the two.
+ *
+ * Each mechanism is measured with the woken task at several priorities
+ * relative to a background task that keeps the processor busy, so the report
+ * shows what the latency becomes when the woken task preempts, shares its
+ * priority with, or has to wait for, the running task.  The event group
+ * mechanism sets its bits through the timer task, so its latency includes the
+ * deferral to that task.
+ *
+ * Only one sample is in flight at a time.  A sample whose task has not run
+ * irqlatencyLOST_TIMEOUT_MS after its interrupt was generated is counted as
+ * lost.  Whatever the handler sent for it is then removed from the mechanism,
+ * and the next sample is only generated once the task is blocked again, so a
+ * task that wakes late is not timed against the next sample.  The mechanisms
+ * are measured one after another, each for the same number of samples, and
+ * the harness then stops generating interrupts.
+ */
+
+#ifndef IRQ_LATENCY_H
+#define IRQ_LATENCY_H
+
+/* The simulated interrupt the harness installs its handler on.  HiResTimer.c
+uses 3. */
+#ifndef irqlatencyINTERRUPT_NUMBER
+	#define irqlatencyINTERRUPT_NUMBER		( 4 )
+#endif
+
+/* The priority of the task that runs the measurements, which must be above
+every priority the woken tasks are given. */
+#define irqlatencyCONTROL_PRIORITY			( configMAX_PRIORITIES - 2 )
+
+/* How long the background task keeps the processor busy before it blocks for
+a tick. */
+#define irqlatencyBUSY_US					( 1000UL )
+
+#define irqlatencyLOST_TIMEOUT_MS			( 100UL )
+
+/* The latency histograms have power of two buckets, as in TickWork.h. */
+#define irqlatencyHISTOGRAM_BUCKETS			( 12 )
+
+/*
+ * Create the tasks and objects of the harness, which start measuring once the
+ * scheduler is started.  The background task runs at uxBackgroundPriority,
+ * and the woken tasks from one below it to two above it, so
+ * uxBackgroundPriority must be at least 1 and at most
+ * irqlatencyCONTROL_PRIORITY - 3.  ulSamplesPerCase samples are taken for
+ * each mechanism at each priority.  Must be called before the scheduler is
+ * started.  Returns pdFAIL if a task or object could not be created.
+ */
+BaseType_t xIrqLatencyStart( UBaseType_t uxBackgroundPriority, uint32_t ulSamplesPerCase );
+
+/*
+ * Returns pdTRUE once every case has been measured.
+ */
+BaseType_t xIrqLatencyIsComplete( void );
+
+/*
+ * Print the samples, lost samples and the minimum, mean and maximum of each
+ * span for every case.  Uses printf() so must only be called when no other
+ * task is writing to the console.
+ */
+void vIrqLatencyPrintReport( void );
+
+/*
+ * Write every span of every case, with its histogram, to pcFileName as comma
+ * separated values.  Returns pdFAIL if the file could not be written.
+ */
+BaseType_t xIrqLatencyWriteResults( const char *pcFileName );
+
+#endif /* IRQ_LATENCY_H */
@@ -0,0 +1,344 @@
+/*
+ * Per job execution time measurement.  See the comments in JobProfiler.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "JobProfiler.h"
+
+/* The run time stats counter counts in 1/100ths of a millisecond, so in
+units of 10 microseconds - see Run-time-stats-utils.c. */
+#define profilerMICROSECONDS_PER_UNIT	( 10UL )
+
+typedef struct xPROFILED_TASK
+{
+	TaskHandle_t xHandle;			/* NULL for work. */
+	const void *pvWork;				/* NULL for a task. */
+	const char *pcName;				/* NULL to use the kernel's name. */
+	volatile TaskHandle_t xRunner;	/* The task running the work, if any. */
+	volatile uint32_t ulRunTime;	/* Of work, charged by vProfilerTickHook(). */
+	BaseType_t xStarted;			/* pdTRUE once the first job has started. */
+	uint32_t ulJobStartRunTime;		/* The task's run time when its current job started. */
+	uint32_t ulJobs;				/* Completed jobs, including those not kept. */
+	uint32_t ulMaximum;
+	uint64_t ullTotal;
+	uint32_t ulSamples[ profilerMAX_SAMPLES ];
+} ProfiledTask_t;
+
+/*
+ * The entry of xTask, or of pvWork if xTask is NULL, registering it if it has
+ * none and there is room.  Returns NULL if there is no room.
+ */
+static ProfiledTask_t *prvGetTask( TaskHandle_t xTask, const void *pvWork );
+
+/*
+ * The entry of the work xTask is running, or NULL if it is not running any
+ * declared work.
+ */
+static ProfiledTask_t *prvFindRunningWork( TaskHandle_t xTask );
+
+/*
+ * The entry of pvWork, or NULL if it was not declared.
+ */
+static ProfiledTask_t *prvFindWork( const void *pvWork );
+
+/*
+ * The name xTask is reported under.
+ */
+static const char *prvTaskName( const ProfiledTask_t *pxTask );
+
+/*-----------------------------------------------------------*/
+
+static ProfiledTask_t xTasks[ profilerMAX_TASKS ];
+static volatile UBaseType_t uxTaskCount = 0;
+
+/* The run time stats counter value at the previous tick, which is not valid
+until the first tick. */
+static uint32_t ulLastTickTime = 0UL;
+static BaseType_t xTicking = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+void vProfilerDeclareTask( TaskHandle_t xTask, const char *pcName )
+{
+ProfiledTask_t *pxTask;
+
+	configASSERT( xTask );
+	configASSERT( pcName );
+
+	pxTask = prvGetTask( xTask, NULL );
+	configASSERT( pxTask );
+
+	if( pxTask != NULL )
+	{
+		pxTask->pcName = pcName;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerDeclareWork( const void *pvWork, const char *pcName )
+{
+ProfiledTask_t *pxTask;
+
+	configASSERT( pvWork );
+	configASSERT( pcName );
+
+	pxTask = prvGetTask( NULL, pvWork );
+	configASSERT( pxTask );
+
+	if( pxTask != NULL )
+	{
+		pxTask->pcName = pcName;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerWorkBegin( const void *pvWork )
+{
+ProfiledTask_t *pxWork = prvFindWork( pvWork );
+
+	if( pxWork != NULL )
+	{
+		pxWork->xRunner = xTaskGetCurrentTaskHandle();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerWorkEnd( const void *pvWork )
+{
+ProfiledTask_t *pxWork = prvFindWork( pvWork );
+
+	if( pxWork != NULL )
+	{
+		pxWork->xRunner = NULL;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerJobStart( void )
+{
+TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
+ProfiledTask_t *pxTask;
+TaskStatus_t xStatus;
+uint32_t ulRunTime, ulJobTime;
+
+	pxTask = prvFindRunningWork( xCurrentTask );
+
+	if( pxTask != NULL )
+	{
+		ulRunTime = pxTask->ulRunTime;
+	}
+	else
+	{
+		pxTask = prvGetTask( xCurrentTask, NULL );
+
+		/* eRunning is passed so vTaskGetInfo() does not look up the state,
+		and the stack is not measured. */
+		vTaskGetInfo( xCurrentTask, &xStatus, pdFALSE, eRunning );
+		ulRunTime = xStatus.ulRunTimeCounter;
+	}
+
+	if( pxTask == NULL )
+	{
+		/* There was no room for this task. */
+		return;
+	}
+
+	if( pxTask->xStarted == pdFALSE )
+	{
+		/* First job of this task. */
+		pxTask->xStarted = pdTRUE;
+	}
+	else
+	{
+		ulJobTime = ulRunTime - pxTask->ulJobStartRunTime;
+
+		if( pxTask->ulJobs < profilerMAX_SAMPLES )
+		{
+			pxTask->ulSamples[ pxTask->ulJobs ] = ulJobTime;
+		}
+
+		if( ulJobTime > pxTask->ulMaximum )
+		{
+			pxTask->ulMaximum = ulJobTime;
+		}
+
+		pxTask->ullTotal += ulJobTime;
+		pxTask->ulJobs++;
+	}
+
+	pxTask->ulJobStartRunTime = ulRunTime;
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerTickHook( void )
+{
+uint32_t ulNow = portGET_RUN_TIME_COUNTER_VALUE();
+ProfiledTask_t *pxWork;
+
+	if( xTicking == pdFALSE )
+	{
+		/* Nothing to charge yet. */
+		xTicking = pdTRUE;
+	}
+	else
+	{
+		pxWork = prvFindRunningWork( xTaskGetCurrentTaskHandle() );
+
+		if( pxWork != NULL )
+		{
+			pxWork->ulRunTime += ulNow - ulLastTickTime;
+		}
+	}
+
+	ulLastTickTime = ulNow;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulProfilerGetMaximum( TaskHandle_t xTask )
+{
+uint32_t ulReturn = 0UL;
+UBaseType_t x;
+
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		if( ( xTasks[ x ].pvWork == NULL ) && ( xTasks[ x ].xHandle == xTask ) )
+		{
+			ulReturn = xTasks[ x ].ulMaximum;
+		}
+	}
+
+	return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xProfilerWriteCsv( const char *pcFileName )
+{
+FILE *pxFile;
+BaseType_t xReturn = pdFAIL;
+UBaseType_t x;
+uint32_t ulJob, ulKept;
+
+	pxFile = fopen( pcFileName, "w" );
+
+	if( pxFile != NULL )
+	{
+		fprintf( pxFile, "task,job,cpu_us\n" );
+
+		for( x = 0; x < uxTaskCount; x++ )
+		{
+			ulKept = ( xTasks[ x ].ulJobs < profilerMAX_SAMPLES ) ? xTasks[ x ].ulJobs : profilerMAX_SAMPLES;
+
+			for( ulJob = 0; ulJob < ulKept; ulJob++ )
+			{
+				fprintf( pxFile, "%s,%lu,%lu\n", prvTaskName( &( xTasks[ x ] ) ), ( unsigned long ) ulJob,
+						 ( unsigned long ) ( xTasks[ x ].ulSamples[ ulJob ] * profilerMICROSECONDS_PER_UNIT ) );
+			}
+		}
+
+		fclose( pxFile );
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vProfilerPrintReport( void )
+{
+UBaseType_t x;
+double dMean;
+
+	printf( "\r\nTask                    Jobs      Mean (ms)  Max (ms)\r\n" );
+
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		dMean = 0.0;
+
+		if( xTasks[ x ].ulJobs > 0UL )
+		{
+			dMean = ( ( double ) xTasks[ x ].ullTotal / ( double ) xTasks[ x ].ulJobs ) * profilerMICROSECONDS_PER_UNIT / 1000.0;
+		}
+
+		printf( "%-22s  %8lu  %9.3f  %8.3f\r\n", prvTaskName( &( xTasks[ x ] ) ), ( unsigned long ) xTasks[ x ].ulJobs,
+				dMean, ( double ) xTasks[ x ].ulMaximum * profilerMICROSECONDS_PER_UNIT / 1000.0 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static ProfiledTask_t *prvGetTask( TaskHandle_t xTask, const void *pvWork )
+{
+ProfiledTask_t *pxTask = NULL;
+UBaseType_t x;
+
+	taskENTER_CRITICAL();
+	{
+		for( x = 0; x < uxTaskCount; x++ )
+		{
+			if( ( xTasks[ x ].xHandle == xTask ) && ( xTasks[ x ].pvWork == pvWork ) )
+			{
+				pxTask = &( xTasks[ x ] );
+				break;
+			}
+		}
+
+		if( ( pxTask == NULL ) && ( uxTaskCount < profilerMAX_TASKS ) )
+		{
+			pxTask = &( xTasks[ uxTaskCount ] );
+			pxTask->xHandle = xTask;
+			pxTask->pvWork = pvWork;
+			uxTaskCount++;
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return pxTask;
+}
+/*-----------------------------------------------------------*/
+
+static ProfiledTask_t *prvFindRunningWork( TaskHandle_t xTask )
+{
+ProfiledTask_t *pxReturn = NULL;
+UBaseType_t x;
+
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		if( ( xTasks[ x ].pvWork != NULL ) && ( xTasks[ x ].xRunner == xTask ) )
+		{
+			pxReturn = &( xTasks[ x ] );
+			break;
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static ProfiledTask_t *prvFindWork( const void *pvWork )
+{
+ProfiledTask_t *pxReturn = NULL;
+UBaseType_t x;
+
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		if( ( xTasks[ x ].pvWork != NULL ) && ( xTasks[ x ].pvWork == pvWork ) )
+		{
+			pxReturn = &( xTasks[ x ] );
+			break;
+		}
+	}
+
+	return pxReturn;
+}
+/*-----------------------------------------------------------*/
+
+static const char *prvTaskName( const ProfiledTask_t *pxTask )
+{
+	return ( pxTask->pcName != NULL ) ? pxTask->pcName : pcTaskGetName( pxTask->xHandle );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,93 @@
+/*
+ * Records the processor time used by every job of the tasks that report
+ * their jobs, so the execution times assumed by the analysis can be compared
+ * with measured ones.
+ *
+ * A task calls vProfilerJobStart() at the start of each job.  The time of a
+ * job is taken from the run time the kernel accounts to the task at each
+ * context switch (configGENERATE_RUN_TIME_STATS), which only counts the time
+ * the task spent in the Running state.  The kernel only adds the current
+ * period in the Running state when the task is switched out, so each job's
+ * time is the difference between the run time read at the start of that job
+ * and at the start of the next one.  This assumes the task only blocks at the
+ * end of each job, which is true of a task whose job ends with
+ * vTaskDelayUntil().
+ *
+ * The times are kept in memory and written to a CSV file with one row per
+ * job, for offline analysis with Tools/pwcet.py.  The kernel truncates task
+ * names to configMAX_TASK_NAME_LEN characters, so a task can be declared with
+ * vProfilerDeclareTask() under its full name, which the CSV and the report
+ * then use.
+ *
+ * Work that is not a task of its own, such as a job run by the timer service
+ * task, can be profiled by declaring it with vProfilerDeclareWork().  The task
+ * that runs it calls vProfilerWorkBegin() and vProfilerWorkEnd() around each
+ * piece of it, and vProfilerJobStart() called in between starts a job of the
+ * work.  The kernel only accounts run time to tasks, so vProfilerTickHook()
+ * charges the time since the previous tick to the work the running task is
+ * running.  The time of work is therefore measured at tick resolution, and a
+ * tick is charged to the work if it is being run when the tick occurs.
+ */
+
+#ifndef JOB_PROFILER_H
+#define JOB_PROFILER_H
+
+#include "task.h"
+
+/* The maximum number of tasks that can be profiled, and of jobs kept per
+task.  The maximum is still updated for jobs past the limit. */
+#define profilerMAX_TASKS			( 10 )
+#define profilerMAX_SAMPLES			( 65536UL )
+
+/*
+ * Register xTask under pcName, which must remain valid while the profiler is
+ * used.  Must be called before the first job of xTask starts.  A task that is
+ * not declared is registered by its first job, under its kernel name.
+ */
+void vProfilerDeclareTask( TaskHandle_t xTask, const char *pcName );
+
+/*
+ * Register the work identified by pvWork under pcName, which must remain
+ * valid while the profiler is used.  Work that is not declared is not
+ * profiled.
+ */
+void vProfilerDeclareWork( const void *pvWork, const char *pcName );
+
+/*
+ * Called by the task that runs pvWork before and after each piece of it.  Do
+ * nothing if pvWork was not declared.
+ */
+void vProfilerWorkBegin( const void *pvWork );
+void vProfilerWorkEnd( const void *pvWork );
+
+/*
+ * Called by a task at the start of each job, or of each job of the work it
+ * is running.  The first call from a task that was not declared registers it.
+ */
+void vProfilerJobStart( void );
+
+/*
+ * Must be called from vApplicationTickHook() when work is profiled.
+ */
+void vProfilerTickHook( void );
+
+/*
+ * The longest job measured for xTask, in run time stats counter units, or 0
+ * if no job of xTask has completed.
+ */
+uint32_t ulProfilerGetMaximum( TaskHandle_t xTask );
+
+/*
+ * Write "task,job,cpu_us" rows for every job kept to pcFileName.  Returns
+ * pdFAIL if the file could not be created.
+ */
+BaseType_t xProfilerWriteCsv( const char *pcFileName );
+
+/*
+ * Print the number of jobs and the mean and maximum measured time of each
+ * task.  Uses printf() so must only be called when no other task is writing
+ * to the console.
+ */
+void vProfilerPrintReport( void );
+
+#endif /* JOB_PROFILER_H */
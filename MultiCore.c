@@ -0,0 +1,913 @@
+/*
+ * Virtual time multi-core simulation of the task set.  See the comments in
+ * MultiCore.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "MultiCore.h"
+
+/* The range of the periods of synthetic tasks, in microseconds. */
+#define multicoreMIN_SYNTHETIC_PERIOD	( 10000.0 )
+#define multicoreMAX_SYNTHETIC_PERIOD	( 1000000.0 )
+
+/* How many sets of synthetic utilisations are drawn before giving up on
+finding one in which no task uses more than a whole core. */
+#define multicoreSYNTHETIC_DRAWS		( 1000 )
+
+/* Returned by prvHighestPriorityPending() when no job is pending. */
+#define multicoreNO_TASK				( ( UBaseType_t ) multicoreMAX_TASKS )
+
+/* Marks a ready structure entry that no core has claimed. */
+#define multicoreUNCLAIMED				( 0L )
+
+/* What each core's host thread simulates. */
+typedef struct xMULTICORE_CORE
+{
+	MultiCoreTaskSet_t *pxSet;
+	UBaseType_t uxCore;
+} MultiCoreCore_t;
+
+/*
+ * Give every task a deadline monotonic priority.  Tasks with equal deadlines
+ * are ordered by the order in which they were added.
+ */
+static void prvAssignPriorities( MultiCoreTaskSet_t *pxSet );
+
+/*
+ * Run response time analysis on the tasks assigned to uxCore, recording the
+ * response time of each.  Returns pdFALSE if any of them misses its deadline.
+ */
+static BaseType_t prvCoreSchedulable( MultiCoreTaskSet_t *pxSet, UBaseType_t uxCore );
+
+/*
+ * The utilisation of the tasks assigned to uxCore, in millionths.
+ */
+static uint32_t prvCoreLoad( const MultiCoreTaskSet_t *pxSet, UBaseType_t uxCore );
+
+/*
+ * Reset the job state and statistics of every task.
+ */
+static void prvResetJobs( MultiCoreTaskSet_t *pxSet );
+
+/*
+ * Release the jobs of pxTask that are due at ulNow, and count a deadline miss
+ * if its oldest pending job has passed its deadline.
+ */
+static void prvReleaseJobs( MultiCoreTask_t *pxTask, uint32_t ulNow );
+
+/*
+ * Return the index of the highest priority task on uxCore with a pending job.
+ */
+static UBaseType_t prvHighestPriorityPending( const MultiCoreTaskSet_t *pxSet, UBaseType_t uxCore );
+
+/*
+ * Execute the oldest pending job of pxTask for one quantum starting at ulNow.
+ * Returns pdTRUE if that completed the job.
+ */
+static BaseType_t prvExecute( MultiCoreTask_t *pxTask, uint32_t ulNow );
+
+/*
+ * The host thread that simulates one core.  lpParameter is a MultiCoreCore_t.
+ */
+static DWORD WINAPI prvCoreThread( LPVOID lpParameter );
+
+/*
+ * Release the due jobs of every task and fill the shared ready structure with
+ * the tasks that have a pending job, most urgent first.  Run by one core at
+ * the start of each quantum of a global simulation.
+ */
+static void prvBuildReadyList( MultiCoreTaskSet_t *pxSet, uint32_t ulNow );
+
+/*
+ * Returns pdTRUE if the oldest pending job of pxA is more urgent than that of
+ * pxB under the policy of the global simulation.
+ */
+static BaseType_t prvMoreUrgent( const MultiCoreTaskSet_t *pxSet, const MultiCoreTask_t *pxA, const MultiCoreTask_t *pxB );
+
+/*
+ * Claim the ready structure entry of task uxTask for uxCore.  Returns pdTRUE
+ * if no other core had claimed it.
+ */
+static BaseType_t prvClaim( UBaseType_t uxTask, UBaseType_t uxCore );
+
+/*
+ * Wait until all uxCores core threads of the global simulation reach the
+ * barrier.
+ */
+static void prvBarrier( UBaseType_t uxCores );
+
+/*
+ * The host thread that simulates one core of a global simulation.
+ * lpParameter is a MultiCoreCore_t.
+ */
+static DWORD WINAPI prvGlobalCoreThread( LPVOID lpParameter );
+
+/*
+ * Create one host thread per core running pxThreadFunction, pin each to a
+ * host processor, and wait for all of them to finish.
+ */
+static void prvRunCoreThreads( MultiCoreTaskSet_t *pxSet, LPTHREAD_START_ROUTINE pxThreadFunction );
+
+/*-----------------------------------------------------------*/
+
+/* The shared ready structure of a global simulation: the tasks with a pending
+job, most urgent first, and the core that claimed each task's job in the
+current quantum (the core number plus one, or multicoreUNCLAIMED). */
+static UBaseType_t uxReady[ multicoreMAX_TASKS ];
+static UBaseType_t uxReadyCount = 0;
+static UBaseType_t uxSelectedCount = 0;
+static volatile LONG lClaimedBy[ multicoreMAX_TASKS ];
+
+/* The task each core ran in the previous quantum without completing it. */
+static UBaseType_t uxPreviousTask[ multicoreMAX_CORES ];
+
+/* The lock step barrier between the core threads. */
+static volatile LONG lBarrierCount = 0;
+static volatile LONG lBarrierGeneration = 0;
+
+/*-----------------------------------------------------------*/
+
+void vMultiCoreInitialise( MultiCoreTaskSet_t *pxSet )
+{
+	memset( pxSet, 0x00, sizeof( MultiCoreTaskSet_t ) );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xMultiCoreAddTask( MultiCoreTaskSet_t *pxSet, const char *pcName, uint32_t ulWcet, uint32_t ulPeriod, uint32_t ulDeadline )
+{
+MultiCoreTask_t *pxTask;
+
+	configASSERT( ( ulWcet > 0 ) && ( ulWcet <= ulDeadline ) && ( ulDeadline <= ulPeriod ) );
+
+	if( pxSet->uxTaskCount >= multicoreMAX_TASKS )
+	{
+		return pdFAIL;
+	}
+
+	pxTask = &( pxSet->xTasks[ pxSet->uxTaskCount ] );
+	strncpy( pxTask->cName, pcName, sizeof( pxTask->cName ) - 1 );
+	pxTask->cName[ sizeof( pxTask->cName ) - 1 ] = '\0';
+
+	/* Execution is simulated in whole quanta. */
+	pxTask->ulWcet = ( ( ulWcet + multicoreQUANTUM_US - 1 ) / multicoreQUANTUM_US ) * multicoreQUANTUM_US;
+	pxTask->ulPeriod = ulPeriod;
+	pxTask->ulDeadline = ulDeadline;
+	pxTask->uxCore = multicoreNO_CORE;
+	pxSet->uxTaskCount++;
+
+	prvAssignPriorities( pxSet );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xMultiCoreAddSyntheticTasks( MultiCoreTaskSet_t *pxSet, UBaseType_t uxCount, uint32_t ulUtilisationPercent, Random_t *pxRandom )
+{
+double dUtilisations[ multicoreMAX_TASKS ];
+double dSum, dNextSum, dPeriod;
+char cName[ multicoreNAME_LENGTH ];
+UBaseType_t x, uxDraw;
+uint32_t ulPeriod, ulWcet;
+BaseType_t xDiscard = pdTRUE;
+
+	/* No task can use more than a whole core. */
+	if( ( uxCount > ( multicoreMAX_TASKS - pxSet->uxTaskCount ) ) || ( ulUtilisationPercent > ( uxCount * 100UL ) ) )
+	{
+		return pdFAIL;
+	}
+
+	/* UUniFast-Discard: draw the whole set with UUniFast, which splits the
+	remaining utilisation between each task and the ones still to be drawn,
+	and draw it again if any task was given more than a whole core.  Close to
+	100 percent per task almost every set is discarded, so give up after
+	multicoreSYNTHETIC_DRAWS sets. */
+	for( uxDraw = 0; ( uxDraw < multicoreSYNTHETIC_DRAWS ) && ( xDiscard != pdFALSE ); uxDraw++ )
+	{
+		dSum = ulUtilisationPercent / 100.0;
+		xDiscard = pdFALSE;
+
+		for( x = 0; x < uxCount; x++ )
+		{
+			if( x < ( uxCount - 1 ) )
+			{
+				dNextSum = dSum * pow( ulRandomNext( pxRandom ) / 4294967296.0, 1.0 / ( double ) ( uxCount - 1 - x ) );
+			}
+			else
+			{
+				dNextSum = 0.0;
+			}
+
+			dUtilisations[ x ] = dSum - dNextSum;
+			dSum = dNextSum;
+
+			if( dUtilisations[ x ] > 1.0 )
+			{
+				xDiscard = pdTRUE;
+			}
+		}
+	}
+
+	if( xDiscard != pdFALSE )
+	{
+		return pdFAIL;
+	}
+
+	for( x = 0; x < uxCount; x++ )
+	{
+		dPeriod = exp( log( multicoreMIN_SYNTHETIC_PERIOD ) +
+					   ( ulRandomNext( pxRandom ) / 4294967296.0 ) * ( log( multicoreMAX_SYNTHETIC_PERIOD ) - log( multicoreMIN_SYNTHETIC_PERIOD ) ) );
+
+		/* Whole milliseconds, as the periods of the application's tasks. */
+		ulPeriod = ( ( uint32_t ) ( dPeriod / 1000.0 ) ) * 1000UL;
+
+		/* Rounding up can still take a task of a whole core past its
+		period. */
+		ulWcet = ( uint32_t ) ( dUtilisations[ x ] * ulPeriod ) + 1UL;
+		if( ulWcet > ulPeriod )
+		{
+			ulWcet = ulPeriod;
+		}
+
+		snprintf( cName, sizeof( cName ), "Sintetica %u", ( unsigned ) x );
+		( void ) xMultiCoreAddTask( pxSet, cName, ulWcet, ulPeriod, ulPeriod );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxMultiCorePartition( MultiCoreTaskSet_t *pxSet, UBaseType_t uxCores, MultiCoreHeuristic_t eHeuristic )
+{
+UBaseType_t uxOrder[ multicoreMAX_TASKS ];
+UBaseType_t x, y, uxTemp, uxCore, uxCandidate, uxUnassigned = 0;
+uint32_t ulLoad, ulLeastLoad;
+MultiCoreTask_t *pxTask;
+BaseType_t xTried[ multicoreMAX_CORES ];
+
+	configASSERT( ( uxCores > 0 ) && ( uxCores <= multicoreMAX_CORES ) );
+
+	pxSet->uxCores = uxCores;
+	pxSet->eMode = eMultiCorePartitioned;
+	pxSet->eHeuristic = eHeuristic;
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxSet->xTasks[ x ].uxCore = multicoreNO_CORE;
+		pxSet->xTasks[ x ].ulAnalysedResponse = 0;
+		uxOrder[ x ] = x;
+	}
+
+	/* Order the tasks by decreasing utilisation.  C1 / T1 < C2 / T2 is
+	compared as C1 * T2 < C2 * T1 to stay in integers. */
+	for( x = 1; x < pxSet->uxTaskCount; x++ )
+	{
+		for( y = x; y > 0; y-- )
+		{
+			if( ( ( uint64_t ) pxSet->xTasks[ uxOrder[ y - 1 ] ].ulWcet * pxSet->xTasks[ uxOrder[ y ] ].ulPeriod ) >=
+				( ( uint64_t ) pxSet->xTasks[ uxOrder[ y ] ].ulWcet * pxSet->xTasks[ uxOrder[ y - 1 ] ].ulPeriod ) )
+			{
+				break;
+			}
+
+			uxTemp = uxOrder[ y ];
+			uxOrder[ y ] = uxOrder[ y - 1 ];
+			uxOrder[ y - 1 ] = uxTemp;
+		}
+	}
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxTask = &( pxSet->xTasks[ uxOrder[ x ] ] );
+
+		for( uxCore = 0; uxCore < uxCores; uxCore++ )
+		{
+			xTried[ uxCore ] = pdFALSE;
+		}
+
+		/* Try the cores in the order the heuristic prefers them until the
+		analysis accepts one. */
+		for( y = 0; ( y < uxCores ) && ( pxTask->uxCore == multicoreNO_CORE ); y++ )
+		{
+			if( eHeuristic == eMultiCoreFirstFit )
+			{
+				uxCandidate = y;
+			}
+			else
+			{
+				uxCandidate = multicoreNO_CORE;
+				ulLeastLoad = 0;
+
+				for( uxCore = 0; uxCore < uxCores; uxCore++ )
+				{
+					ulLoad = prvCoreLoad( pxSet, uxCore );
+
+					if( ( xTried[ uxCore ] == pdFALSE ) && ( ( uxCandidate == multicoreNO_CORE ) || ( ulLoad < ulLeastLoad ) ) )
+					{
+						uxCandidate = uxCore;
+						ulLeastLoad = ulLoad;
+					}
+				}
+			}
+
+			xTried[ uxCandidate ] = pdTRUE;
+			pxTask->uxCore = uxCandidate;
+
+			if( prvCoreSchedulable( pxSet, uxCandidate ) == pdFALSE )
+			{
+				pxTask->uxCore = multicoreNO_CORE;
+			}
+		}
+
+		if( pxTask->uxCore == multicoreNO_CORE )
+		{
+			uxUnassigned++;
+		}
+	}
+
+	/* Tasks accepted later change the response times of the tasks already on
+	a core, so analyse the final assignment again. */
+	for( uxCore = 0; uxCore < uxCores; uxCore++ )
+	{
+		prvCoreSchedulable( pxSet, uxCore );
+	}
+
+	return uxUnassigned;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxMultiCoreMinimumCores( MultiCoreTaskSet_t *pxSet, MultiCoreHeuristic_t eHeuristic )
+{
+UBaseType_t uxCores;
+
+	for( uxCores = 1; uxCores <= multicoreMAX_CORES; uxCores++ )
+	{
+		if( uxMultiCorePartition( pxSet, uxCores, eHeuristic ) == 0 )
+		{
+			return uxCores;
+		}
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vMultiCoreSimulatePartitioned( MultiCoreTaskSet_t *pxSet, uint32_t ulHorizon )
+{
+	configASSERT( ( pxSet->uxCores > 0 ) && ( pxSet->eMode == eMultiCorePartitioned ) );
+
+	prvResetJobs( pxSet );
+	pxSet->ulHorizon = ulHorizon;
+
+	/* Each thread only touches the tasks assigned to its own core, so the
+	threads need no synchronisation. */
+	prvRunCoreThreads( pxSet, prvCoreThread );
+}
+/*-----------------------------------------------------------*/
+
+void vMultiCoreSimulateGlobal( MultiCoreTaskSet_t *pxSet, UBaseType_t uxCores, MultiCoreMode_t ePolicy, uint32_t ulMigrationCost, uint32_t ulHorizon )
+{
+UBaseType_t x;
+
+	configASSERT( ( uxCores > 0 ) && ( uxCores <= multicoreMAX_CORES ) );
+	configASSERT( ePolicy != eMultiCorePartitioned );
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxSet->xTasks[ x ].uxCore = multicoreNO_CORE;
+		pxSet->xTasks[ x ].ulAnalysedResponse = 0;
+	}
+
+	for( x = 0; x < multicoreMAX_CORES; x++ )
+	{
+		uxPreviousTask[ x ] = multicoreNO_TASK;
+	}
+
+	pxSet->uxCores = uxCores;
+	pxSet->eMode = ePolicy;
+	pxSet->ulMigrationCost = ( ( ulMigrationCost + multicoreQUANTUM_US - 1 ) / multicoreQUANTUM_US ) * multicoreQUANTUM_US;
+	pxSet->ulHorizon = ulHorizon;
+	prvResetJobs( pxSet );
+
+	lBarrierCount = 0;
+	lBarrierGeneration = 0;
+
+	prvRunCoreThreads( pxSet, prvGlobalCoreThread );
+}
+/*-----------------------------------------------------------*/
+
+void vMultiCorePrintReport( const MultiCoreTaskSet_t *pxSet )
+{
+UBaseType_t x, uxCore;
+const MultiCoreTask_t *pxTask;
+char cCore[ 8 ], cResponse[ 12 ];
+
+	if( pxSet->eMode == eMultiCorePartitioned )
+	{
+		printf( "\r\n%u cores, partitioned, %s fit decreasing\r\n", ( unsigned ) pxSet->uxCores,
+				( pxSet->eHeuristic == eMultiCoreFirstFit ) ? "first" : "worst" );
+	}
+	else
+	{
+		printf( "\r\n%u cores, global %s, migration cost %lu us\r\n", ( unsigned ) pxSet->uxCores,
+				( pxSet->eMode == eMultiCoreGlobalEdf ) ? "EDF" : "fixed priority", ( unsigned long ) pxSet->ulMigrationCost );
+	}
+
+	for( uxCore = 0; uxCore < pxSet->uxCores; uxCore++ )
+	{
+		printf( "Core %u:", ( unsigned ) uxCore );
+
+		if( pxSet->eMode == eMultiCorePartitioned )
+		{
+			printf( " utilisation %.1f%%", prvCoreLoad( pxSet, uxCore ) / 10000.0 );
+		}
+
+		if( pxSet->ulHorizon != 0 )
+		{
+			printf( " busy %.1f%% of the simulation", 100.0 - ( ( 100.0 * pxSet->ulIdle[ uxCore ] ) / pxSet->ulHorizon ) );
+		}
+
+		printf( "\r\n" );
+	}
+
+	printf( "%-20s %4s %4s %9s %9s %9s %9s %9s %7s %7s %9s %8s\r\n", "Task", "Core", "Prio", "C (us)", "T (us)", "D (us)",
+			"RTA (us)", "Sim (us)", "Jobs", "Misses", "Preempted", "Migrated" );
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxTask = &( pxSet->xTasks[ x ] );
+
+		if( pxSet->eMode != eMultiCorePartitioned )
+		{
+			/* Any core may run the task, and there is no per-core analysis. */
+			strcpy( cCore, "-" );
+			strcpy( cResponse, "-" );
+		}
+		else if( pxTask->uxCore == multicoreNO_CORE )
+		{
+			printf( "%-20s %4s %4u %9lu %9lu %9lu   not assigned to any core\r\n", pxTask->cName, "-", ( unsigned ) pxTask->uxPriority,
+					( unsigned long ) pxTask->ulWcet, ( unsigned long ) pxTask->ulPeriod, ( unsigned long ) pxTask->ulDeadline );
+			continue;
+		}
+		else
+		{
+			snprintf( cCore, sizeof( cCore ), "%u", ( unsigned ) pxTask->uxCore );
+			snprintf( cResponse, sizeof( cResponse ), "%lu", ( unsigned long ) pxTask->ulAnalysedResponse );
+		}
+
+		printf( "%-20s %4s %4u %9lu %9lu %9lu %9s %9lu %7lu %7lu %9lu %8lu\r\n", pxTask->cName, cCore,
+				( unsigned ) pxTask->uxPriority, ( unsigned long ) pxTask->ulWcet, ( unsigned long ) pxTask->ulPeriod,
+				( unsigned long ) pxTask->ulDeadline, cResponse, ( unsigned long ) pxTask->ulWorstResponse,
+				( unsigned long ) pxTask->ulJobs, ( unsigned long ) pxTask->ulMisses, ( unsigned long ) pxTask->ulPreemptions,
+				( unsigned long ) pxTask->ulMigrations );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvAssignPriorities( MultiCoreTaskSet_t *pxSet )
+{
+UBaseType_t x, y;
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxSet->xTasks[ x ].uxPriority = 0;
+
+		for( y = 0; y < pxSet->uxTaskCount; y++ )
+		{
+			if( ( pxSet->xTasks[ y ].ulDeadline > pxSet->xTasks[ x ].ulDeadline ) ||
+				( ( pxSet->xTasks[ y ].ulDeadline == pxSet->xTasks[ x ].ulDeadline ) && ( y > x ) ) )
+			{
+				pxSet->xTasks[ x ].uxPriority++;
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCoreSchedulable( MultiCoreTaskSet_t *pxSet, UBaseType_t uxCore )
+{
+UBaseType_t x, y;
+uint64_t ullResponse, ullPrevious;
+MultiCoreTask_t *pxTask, *pxOther;
+BaseType_t xSchedulable = pdTRUE;
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxTask = &( pxSet->xTasks[ x ] );
+
+		if( pxTask->uxCore != uxCore )
+		{
+			continue;
+		}
+
+		/* R = C + sum over the higher priority tasks on the same core of
+		ceil( R / Tj ) * Cj, iterated until it stops changing or passes the
+		deadline. */
+		ullResponse = pxTask->ulWcet;
+
+		do
+		{
+			ullPrevious = ullResponse;
+			ullResponse = pxTask->ulWcet;
+
+			for( y = 0; y < pxSet->uxTaskCount; y++ )
+			{
+				pxOther = &( pxSet->xTasks[ y ] );
+
+				if( ( pxOther->uxCore == uxCore ) && ( pxOther->uxPriority > pxTask->uxPriority ) )
+				{
+					ullResponse += ( ( ullPrevious + pxOther->ulPeriod - 1 ) / pxOther->ulPeriod ) * pxOther->ulWcet;
+				}
+			}
+		} while( ( ullResponse != ullPrevious ) && ( ullResponse <= pxTask->ulDeadline ) );
+
+		if( ullResponse <= pxTask->ulDeadline )
+		{
+			pxTask->ulAnalysedResponse = ( uint32_t ) ullResponse;
+		}
+		else
+		{
+			pxTask->ulAnalysedResponse = 0;
+			xSchedulable = pdFALSE;
+		}
+	}
+
+	return xSchedulable;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvCoreLoad( const MultiCoreTaskSet_t *pxSet, UBaseType_t uxCore )
+{
+UBaseType_t x;
+uint64_t ullLoad = 0;
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		if( pxSet->xTasks[ x ].uxCore == uxCore )
+		{
+			ullLoad += ( ( uint64_t ) pxSet->xTasks[ x ].ulWcet * 1000000ULL ) / pxSet->xTasks[ x ].ulPeriod;
+		}
+	}
+
+	return ( uint32_t ) ullLoad;
+}
+/*-----------------------------------------------------------*/
+
+static void prvResetJobs( MultiCoreTaskSet_t *pxSet )
+{
+UBaseType_t x;
+MultiCoreTask_t *pxTask;
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxTask = &( pxSet->xTasks[ x ] );
+		pxTask->ulJobs = 0;
+		pxTask->ulMisses = 0;
+		pxTask->ulPreemptions = 0;
+		pxTask->ulMigrations = 0;
+		pxTask->ulWorstResponse = 0;
+		pxTask->ulNextRelease = 0;
+		pxTask->ulPendingJobs = 0;
+		pxTask->xRanLastQuantum = pdFALSE;
+		pxTask->xSelected = pdFALSE;
+	}
+
+	for( x = 0; x < multicoreMAX_CORES; x++ )
+	{
+		pxSet->ulIdle[ x ] = 0;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvReleaseJobs( MultiCoreTask_t *pxTask, uint32_t ulNow )
+{
+	while( ulNow >= pxTask->ulNextRelease )
+	{
+		if( pxTask->ulPendingJobs == 0 )
+		{
+			pxTask->ulJobRelease = pxTask->ulNextRelease;
+			pxTask->ulRemaining = pxTask->ulWcet;
+			pxTask->xMissCounted = pdFALSE;
+			pxTask->uxLastCore = multicoreNO_CORE;
+		}
+
+		pxTask->ulPendingJobs++;
+		pxTask->ulJobs++;
+		pxTask->ulNextRelease += pxTask->ulPeriod;
+	}
+
+	/* The miss is counted as soon as the job can no longer complete by its
+	deadline.  A late job still runs to completion, but is only counted once. */
+	if( ( pxTask->ulPendingJobs != 0 ) && ( pxTask->xMissCounted == pdFALSE ) &&
+		( ( ulNow + pxTask->ulRemaining ) > ( pxTask->ulJobRelease + pxTask->ulDeadline ) ) )
+	{
+		pxTask->ulMisses++;
+		pxTask->xMissCounted = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvHighestPriorityPending( const MultiCoreTaskSet_t *pxSet, UBaseType_t uxCore )
+{
+UBaseType_t x, uxHighest = multicoreNO_TASK;
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		if( ( pxSet->xTasks[ x ].uxCore == uxCore ) && ( pxSet->xTasks[ x ].ulPendingJobs != 0 ) &&
+			( ( uxHighest == multicoreNO_TASK ) || ( pxSet->xTasks[ x ].uxPriority > pxSet->xTasks[ uxHighest ].uxPriority ) ) )
+		{
+			uxHighest = x;
+		}
+	}
+
+	return uxHighest;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvExecute( MultiCoreTask_t *pxTask, uint32_t ulNow )
+{
+uint32_t ulResponse;
+BaseType_t xCompleted = pdFALSE;
+
+	pxTask->ulRemaining -= multicoreQUANTUM_US;
+
+	if( pxTask->ulRemaining == 0 )
+	{
+		xCompleted = pdTRUE;
+		ulResponse = ( ulNow + multicoreQUANTUM_US ) - pxTask->ulJobRelease;
+
+		if( ulResponse > pxTask->ulWorstResponse )
+		{
+			pxTask->ulWorstResponse = ulResponse;
+		}
+
+		/* Start the next job straight away if it was released while this
+		one was late. */
+		pxTask->ulPendingJobs--;
+
+		if( pxTask->ulPendingJobs != 0 )
+		{
+			pxTask->ulJobRelease += pxTask->ulPeriod;
+			pxTask->ulRemaining = pxTask->ulWcet;
+			pxTask->xMissCounted = pdFALSE;
+			pxTask->uxLastCore = multicoreNO_CORE;
+		}
+	}
+
+	return xCompleted;
+}
+/*-----------------------------------------------------------*/
+
+static DWORD WINAPI prvCoreThread( LPVOID lpParameter )
+{
+MultiCoreCore_t *pxCore = ( MultiCoreCore_t * ) lpParameter;
+MultiCoreTaskSet_t *pxSet = pxCore->pxSet;
+UBaseType_t x, uxRunning, uxPrevious = multicoreNO_TASK;
+uint32_t ulNow;
+
+	for( ulNow = 0; ulNow < pxSet->ulHorizon; ulNow += multicoreQUANTUM_US )
+	{
+		for( x = 0; x < pxSet->uxTaskCount; x++ )
+		{
+			if( pxSet->xTasks[ x ].uxCore == pxCore->uxCore )
+			{
+				prvReleaseJobs( &( pxSet->xTasks[ x ] ), ulNow );
+			}
+		}
+
+		uxRunning = prvHighestPriorityPending( pxSet, pxCore->uxCore );
+
+		/* A job that did not complete in the previous quantum was preempted
+		if another job runs instead. */
+		if( ( uxPrevious != multicoreNO_TASK ) && ( uxPrevious != uxRunning ) )
+		{
+			pxSet->xTasks[ uxPrevious ].ulPreemptions++;
+		}
+
+		uxPrevious = multicoreNO_TASK;
+
+		if( uxRunning == multicoreNO_TASK )
+		{
+			pxSet->ulIdle[ pxCore->uxCore ] += multicoreQUANTUM_US;
+		}
+		else if( prvExecute( &( pxSet->xTasks[ uxRunning ] ), ulNow ) == pdFALSE )
+		{
+			uxPrevious = uxRunning;
+		}
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunCoreThreads( MultiCoreTaskSet_t *pxSet, LPTHREAD_START_ROUTINE pxThreadFunction )
+{
+MultiCoreCore_t xCores[ multicoreMAX_CORES ];
+HANDLE xThreads[ multicoreMAX_CORES ];
+SYSTEM_INFO xSystemInfo;
+UBaseType_t uxCore;
+
+	GetSystemInfo( &xSystemInfo );
+
+	for( uxCore = 0; uxCore < pxSet->uxCores; uxCore++ )
+	{
+		xCores[ uxCore ].pxSet = pxSet;
+		xCores[ uxCore ].uxCore = uxCore;
+
+		/* Created suspended so they can be pinned before they start. */
+		xThreads[ uxCore ] = CreateThread( NULL, 0, pxThreadFunction, &( xCores[ uxCore ] ), CREATE_SUSPENDED, NULL );
+		configASSERT( xThreads[ uxCore ] );
+		SetThreadAffinityMask( xThreads[ uxCore ], ( DWORD_PTR ) 1 << ( uxCore % xSystemInfo.dwNumberOfProcessors ) );
+		ResumeThread( xThreads[ uxCore ] );
+	}
+
+	WaitForMultipleObjects( ( DWORD ) pxSet->uxCores, xThreads, TRUE, INFINITE );
+
+	for( uxCore = 0; uxCore < pxSet->uxCores; uxCore++ )
+	{
+		CloseHandle( xThreads[ uxCore ] );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvMoreUrgent( const MultiCoreTaskSet_t *pxSet, const MultiCoreTask_t *pxA, const MultiCoreTask_t *pxB )
+{
+uint32_t ulDeadlineA, ulDeadlineB;
+
+	if( pxSet->eMode == eMultiCoreGlobalEdf )
+	{
+		ulDeadlineA = pxA->ulJobRelease + pxA->ulDeadline;
+		ulDeadlineB = pxB->ulJobRelease + pxB->ulDeadline;
+
+		/* Equal deadlines are broken by priority, so the order is total. */
+		if( ulDeadlineA != ulDeadlineB )
+		{
+			return ( ulDeadlineA < ulDeadlineB ) ? pdTRUE : pdFALSE;
+		}
+	}
+
+	return ( pxA->uxPriority > pxB->uxPriority ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBuildReadyList( MultiCoreTaskSet_t *pxSet, uint32_t ulNow )
+{
+UBaseType_t x, y;
+MultiCoreTask_t *pxTask;
+
+	uxReadyCount = 0;
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxTask = &( pxSet->xTasks[ x ] );
+		prvReleaseJobs( pxTask, ulNow );
+		lClaimedBy[ x ] = multicoreUNCLAIMED;
+
+		if( pxTask->ulPendingJobs != 0 )
+		{
+			/* Insert keeping the most urgent first. */
+			for( y = uxReadyCount; ( y > 0 ) && ( prvMoreUrgent( pxSet, pxTask, &( pxSet->xTasks[ uxReady[ y - 1 ] ] ) ) != pdFALSE ); y-- )
+			{
+				uxReady[ y ] = uxReady[ y - 1 ];
+			}
+
+			uxReady[ y ] = x;
+			uxReadyCount++;
+		}
+	}
+
+	/* The most urgent jobs, one per core, run in this quantum. */
+	uxSelectedCount = ( uxReadyCount < pxSet->uxCores ) ? uxReadyCount : pxSet->uxCores;
+
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxSet->xTasks[ x ].xSelected = pdFALSE;
+	}
+
+	for( x = 0; x < uxSelectedCount; x++ )
+	{
+		pxSet->xTasks[ uxReady[ x ] ].xSelected = pdTRUE;
+	}
+
+	/* A job that was running and is no longer among the selected ones has
+	been preempted. */
+	for( x = 0; x < pxSet->uxTaskCount; x++ )
+	{
+		pxTask = &( pxSet->xTasks[ x ] );
+
+		if( ( pxTask->xRanLastQuantum != pdFALSE ) && ( pxTask->xSelected == pdFALSE ) )
+		{
+			pxTask->ulPreemptions++;
+		}
+
+		pxTask->xRanLastQuantum = pdFALSE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvClaim( UBaseType_t uxTask, UBaseType_t uxCore )
+{
+	return ( InterlockedCompareExchange( &( lClaimedBy[ uxTask ] ), ( LONG ) uxCore + 1L, multicoreUNCLAIMED ) == multicoreUNCLAIMED ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBarrier( UBaseType_t uxCores )
+{
+LONG lGeneration = lBarrierGeneration;
+
+	if( InterlockedIncrement( &lBarrierCount ) == ( LONG ) uxCores )
+	{
+		/* The last core to arrive releases the others. */
+		lBarrierCount = 0;
+		InterlockedIncrement( &lBarrierGeneration );
+	}
+	else
+	{
+		/* There may be more simulated cores than host processors, so give
+		the processor away while waiting. */
+		while( lBarrierGeneration == lGeneration )
+		{
+			SwitchToThread();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static DWORD WINAPI prvGlobalCoreThread( LPVOID lpParameter )
+{
+MultiCoreCore_t *pxCore = ( MultiCoreCore_t * ) lpParameter;
+MultiCoreTaskSet_t *pxSet = pxCore->pxSet;
+UBaseType_t x, uxCore = pxCore->uxCore, uxRunning;
+MultiCoreTask_t *pxTask;
+uint32_t ulNow;
+
+	for( ulNow = 0; ulNow < pxSet->ulHorizon; ulNow += multicoreQUANTUM_US )
+	{
+		if( uxCore == 0 )
+		{
+			prvBuildReadyList( pxSet, ulNow );
+		}
+
+		prvBarrier( pxSet->uxCores );
+
+		/* First every core keeps the job it was running if that job is still
+		selected.  No other core ran that job, so the claim can not fail. */
+		uxRunning = multicoreNO_TASK;
+
+		if( ( uxPreviousTask[ uxCore ] != multicoreNO_TASK ) && ( pxSet->xTasks[ uxPreviousTask[ uxCore ] ].xSelected != pdFALSE ) )
+		{
+			uxRunning = uxPreviousTask[ uxCore ];
+			prvClaim( uxRunning, uxCore );
+		}
+
+		prvBarrier( pxSet->uxCores );
+
+		/* Then the cores left without a job take the most urgent selected job
+		nobody has claimed.  A core that loses the race for an entry moves on
+		to the next, so between them the cores claim every selected job. */
+		for( x = 0; ( x < uxSelectedCount ) && ( uxRunning == multicoreNO_TASK ); x++ )
+		{
+			if( prvClaim( uxReady[ x ], uxCore ) != pdFALSE )
+			{
+				uxRunning = uxReady[ x ];
+			}
+		}
+
+		uxPreviousTask[ uxCore ] = multicoreNO_TASK;
+
+		if( uxRunning == multicoreNO_TASK )
+		{
+			pxSet->ulIdle[ uxCore ] += multicoreQUANTUM_US;
+		}
+		else
+		{
+			pxTask = &( pxSet->xTasks[ uxRunning ] );
+
+			if( ( pxTask->uxLastCore != multicoreNO_CORE ) && ( pxTask->uxLastCore != uxCore ) )
+			{
+				pxTask->ulMigrations++;
+				pxTask->ulRemaining += pxSet->ulMigrationCost;
+			}
+
+			pxTask->uxLastCore = uxCore;
+
+			if( prvExecute( pxTask, ulNow ) == pdFALSE )
+			{
+				pxTask->xRanLastQuantum = pdTRUE;
+				uxPreviousTask[ uxCore ] = uxRunning;
+			}
+		}
+
+		prvBarrier( pxSet->uxCores );
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,175 @@
+/*
+ * A virtual time simulator of the application's task set on a processor with
+ * several cores, used to evaluate how the workload would scale to a target
+ * with more cores.
+ *
+ * The FreeRTOS kernel has a single scheduler for a single processor, and the
+ * Windows port runs every task on one host thread at a time, so the kernel
+ * itself can not be run once per core.  Instead each task is described by its
+ * worst case execution time, period and relative deadline, and its jobs are
+ * simulated here.  Synthetic tasks can be added to the application's tasks to
+ * see how much more load a given number of cores can take.
+ *
+ * Partitioned scheduling assigns every task to one core offline, by first
+ * fit or worst fit decreasing bin packing by utilisation.  A task is only
+ * accepted on a core if response time analysis shows that every task on that
+ * core, including the new one, still meets its deadline.  Each core is then
+ * simulated by its own instance of a preemptive fixed priority scheduler,
+ * running in its own host thread pinned to one host processor.  The cores
+ * share nothing, so the instances run in parallel without synchronising.
+ *
+ * Global scheduling lets any of the cores run any job.  At every quantum the
+ * cores run the most urgent ready jobs, by deadline monotonic priority (global
+ * fixed priority) or by absolute deadline (global EDF).  Each core is again a
+ * host thread, and the threads advance through virtual time in lock step.
+ * The ready jobs are kept in one structure shared by all the cores, in which
+ * every entry is claimed by a core with an interlocked compare and swap,
+ * rather than the whole structure being locked while a core picks a job.  A
+ * core keeps the job it ran in the previous quantum if that job is still
+ * among the most urgent, so jobs only migrate when they must.  A job that
+ * resumes on a different core from the one it last ran on counts as a
+ * migration and has the migration cost added to its execution time, to model
+ * the cache and context reloading a migration causes.
+ *
+ * Priorities are assigned deadline monotonically (the shorter the relative
+ * deadline the higher the priority), which is optimal for fixed priority
+ * scheduling on each core when deadlines do not exceed periods.  This differs
+ * from the priorities the application gives its own tasks on one core.
+ *
+ * All times are in microseconds.  Every core starts with a synchronous
+ * release of all its tasks, the critical instant, and time advances in steps
+ * of multicoreQUANTUM_US.
+ */
+
+#ifndef MULTI_CORE_H
+#define MULTI_CORE_H
+
+#include "Random.h"
+
+/* The maximum number of tasks in a set, and of simulated cores. */
+#define multicoreMAX_TASKS			( 32 )
+#define multicoreMAX_CORES			( 8 )
+
+/* The virtual time step, in microseconds.  Execution times are rounded up to
+a whole number of steps. */
+#define multicoreQUANTUM_US			( 100UL )
+
+/* The longest task name kept, including the terminator. */
+#define multicoreNAME_LENGTH		( 20 )
+
+/* The core of a task that has not been assigned to one. */
+#define multicoreNO_CORE			( ( UBaseType_t ) multicoreMAX_CORES )
+
+typedef enum
+{
+	eMultiCoreFirstFit = 0,		/* The first core the task fits on. */
+	eMultiCoreWorstFit			/* The least loaded core the task fits on. */
+} MultiCoreHeuristic_t;
+
+typedef enum
+{
+	eMultiCorePartitioned = 0,
+	eMultiCoreGlobalFixedPriority,
+	eMultiCoreGlobalEdf
+} MultiCoreMode_t;
+
+typedef struct xMULTICORE_TASK
+{
+	char cName[ multicoreNAME_LENGTH ];
+	uint32_t ulWcet;
+	uint32_t ulPeriod;
+	uint32_t ulDeadline;
+	UBaseType_t uxPriority;			/* Deadline monotonic, higher is more urgent. */
+	UBaseType_t uxCore;				/* Set by uxMultiCorePartition(). */
+	uint32_t ulAnalysedResponse;	/* 0 if the analysis failed. */
+
+	/* Statistics of the last simulation. */
+	uint32_t ulJobs;
+	uint32_t ulMisses;
+	uint32_t ulPreemptions;
+	uint32_t ulMigrations;
+	uint32_t ulWorstResponse;
+
+	/* The job state used by the simulation. */
+	uint32_t ulNextRelease;
+	uint32_t ulJobRelease;			/* Release time of the oldest pending job. */
+	uint32_t ulRemaining;			/* Execution time left of the oldest pending job. */
+	uint32_t ulPendingJobs;
+	BaseType_t xMissCounted;
+	UBaseType_t uxLastCore;			/* Core the oldest pending job last ran on, or multicoreNO_CORE. */
+	BaseType_t xRanLastQuantum;		/* Ran in the previous quantum without completing. */
+	BaseType_t xSelected;			/* Among the jobs to run in this quantum (global modes). */
+} MultiCoreTask_t;
+
+typedef struct xMULTICORE_TASK_SET
+{
+	MultiCoreTask_t xTasks[ multicoreMAX_TASKS ];
+	UBaseType_t uxTaskCount;
+	UBaseType_t uxCores;
+	MultiCoreMode_t eMode;			/* Of the last partitioning or simulation. */
+	MultiCoreHeuristic_t eHeuristic;
+	uint32_t ulMigrationCost;
+	uint32_t ulHorizon;				/* Of the last simulation. */
+	uint32_t ulIdle[ multicoreMAX_CORES ];
+} MultiCoreTaskSet_t;
+
+/*
+ * Empty pxSet.
+ */
+void vMultiCoreInitialise( MultiCoreTaskSet_t *pxSet );
+
+/*
+ * Add a task to pxSet.  The deadline must not be longer than the period.
+ * Returns pdFAIL if pxSet already holds multicoreMAX_TASKS tasks.
+ */
+BaseType_t xMultiCoreAddTask( MultiCoreTaskSet_t *pxSet, const char *pcName, uint32_t ulWcet, uint32_t ulPeriod, uint32_t ulDeadline );
+
+/*
+ * Add uxCount synthetic tasks with implicit deadlines whose utilisations add
+ * up to ulUtilisationPercent percent of one core.  The utilisations are drawn
+ * with the UUniFast algorithm and the periods are drawn log uniformly between
+ * 10 ms and 1 s, so the set is not biased towards harmonic periods.  A set
+ * in which a task would use more than a whole core is drawn again, so no
+ * task's worst case execution time exceeds its period.  Returns pdFAIL, and
+ * adds no task, if not all of the tasks fit in pxSet or no such set was found,
+ * which is always the case above 100 percent per task.
+ */
+BaseType_t xMultiCoreAddSyntheticTasks( MultiCoreTaskSet_t *pxSet, UBaseType_t uxCount, uint32_t ulUtilisationPercent, Random_t *pxRandom );
+
+/*
+ * Assign every task of pxSet to one of uxCores cores.  Returns the number of
+ * tasks that could not be assigned to any core, which is 0 if the whole set
+ * is schedulable.
+ */
+UBaseType_t uxMultiCorePartition( MultiCoreTaskSet_t *pxSet, UBaseType_t uxCores, MultiCoreHeuristic_t eHeuristic );
+
+/*
+ * The fewest cores, up to multicoreMAX_CORES, onto which eHeuristic can
+ * partition pxSet, or 0 if it needs more.  Leaves pxSet partitioned onto the
+ * number of cores returned.
+ */
+UBaseType_t uxMultiCoreMinimumCores( MultiCoreTaskSet_t *pxSet, MultiCoreHeuristic_t eHeuristic );
+
+/*
+ * Simulate ulHorizon microseconds of the partitioned set, one host thread per
+ * core, and record the statistics of every task.  Tasks that could not be
+ * assigned to a core are not simulated.
+ */
+void vMultiCoreSimulatePartitioned( MultiCoreTaskSet_t *pxSet, uint32_t ulHorizon );
+
+/*
+ * Simulate ulHorizon microseconds of pxSet scheduled globally on uxCores
+ * cores, one host thread per core, with ePolicy set to
+ * eMultiCoreGlobalFixedPriority or eMultiCoreGlobalEdf.  ulMigrationCost is
+ * the execution time added to a job each time it migrates.  Any assignment of
+ * the tasks to cores is discarded.
+ */
+void vMultiCoreSimulateGlobal( MultiCoreTaskSet_t *pxSet, UBaseType_t uxCores, MultiCoreMode_t ePolicy, uint32_t ulMigrationCost, uint32_t ulHorizon );
+
+/*
+ * Print the assignment, analysis and simulation results of every task and
+ * core, for the mode of the last simulation.  Uses printf().
+ */
+void vMultiCorePrintReport( const MultiCoreTaskSet_t *pxSet );
+
+#endif /* MULTI_CORE_H */
@@ -0,0 +1,591 @@
+/*
+ * Periodic jobs backed by a task or by software timers.  See the comments in
+ * PeriodicJob.h.
+ */
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+
+#include "PeriodicJob.h"
+#include "TraceFilter.h"
+#include "Budget.h"
+#include "JobProfiler.h"
+
+/* The job markers are stored in the recorder's separate user event buffer,
+each on its own channel with a fixed format registered once, so storing one
+only copies its arguments.  Without the separate buffer they are stored as
+ordinary user events, whose constant format is still only expanded when the
+trace is read. */
+#if ( TRC_CFG_INCLUDE_USER_EVENTS == 1 ) && ( TRC_CFG_USE_SEPARATE_USER_EVENT_BUFFER == 1 )
+	#define periodicjobMARK( eMarker, ... ) \
+		if( tracefilterENABLED( tracefilterUSER ) ) { vTraceUBData( xMarkerChannels[ eMarker ], __VA_ARGS__ ); }
+#elif ( TRC_CFG_INCLUDE_USER_EVENTS == 1 )
+	#define periodicjobMARK( eMarker, ... ) \
+		if( tracefilterENABLED( tracefilterUSER ) ) { vTracePrintF( xMarkerNames[ eMarker ], pcMarkerFormats[ eMarker ], __VA_ARGS__ ); }
+#else
+	#define periodicjobMARK( eMarker, ... )
+#endif
+
+/* Whether the next release of a job is known and marked.  Only used by task
+backed and external jobs, whose releases are marked by the tick hook. */
+#define periodicjobRELEASE_UNKNOWN		( 0 )	/* Marked when the job starts. */
+#define periodicjobRELEASE_EXPECTED		( 1 )	/* Marked by the tick hook at xNextRelease. */
+#define periodicjobRELEASE_MARKED		( 2 )	/* Marked, the job has not started yet. */
+
+typedef enum
+{
+	ePeriodicJobRelease = 0,		/* Job name, job index, release tick. */
+	ePeriodicJobStart,				/* Job name, job index. */
+	ePeriodicJobEnd,				/* Job name, job index. */
+	ePeriodicJobDeadlineMiss,		/* Job name, job index, lateness in ticks. */
+	ePeriodicJobMarkerCount
+} PeriodicJobMarker_t;
+
+struct xPERIODIC_JOB
+{
+	PeriodicJobStepFunction_t pxStepFunction;
+	void *pvParameters;
+	TickType_t xPeriod;
+	PeriodicJobBacking_t eBacking;
+	TaskHandle_t xTask;					/* Only used by task backed and external jobs. */
+	TimerHandle_t xReleaseTimer;		/* The following are only used by timer backed jobs. */
+	TimerHandle_t xStepTimer;
+	uint32_t ulNextStep;
+	BaseType_t xRunning;				/* The job has steps still to run. */
+	uint32_t ulSkipped;
+	#if ( TRC_CFG_INCLUDE_USER_EVENTS == 1 )
+		traceString xName;				/* Identifies the job in the markers. */
+	#endif
+	uint32_t ulReleaseIndex;			/* The number of the latest release. */
+	uint32_t ulJobIndex;				/* The number of the current job. */
+	TickType_t xRelease;				/* The release instant of the current job. */
+	TickType_t xNextRelease;
+	UBaseType_t uxReleaseState;			/* One of the periodicjobRELEASE_ states. */
+	uint32_t ulDeadlineMisses;
+};
+
+/*
+ * The task of a task backed job.  pvParameters is the PeriodicJob_t.
+ */
+static void prvJobTask( void *pvParameters );
+
+/*
+ * The callbacks of the two timers of a timer backed job.  The timer ID of
+ * both is the PeriodicJob_t.
+ */
+static void prvReleaseTimerCallback( TimerHandle_t xTimer );
+static void prvStepTimerCallback( TimerHandle_t xTimer );
+
+/*
+ * Release a job of a timer backed job, unless the previous one is still
+ * running.  Called by the release timer, and pended to the timer service task
+ * for the first release.  pvParameter1 is the PeriodicJob_t.
+ */
+static void prvRelease( void *pvParameter1, uint32_t ulParameter2 );
+
+/*
+ * Run the next step of a timer backed job, and defer the one after it, if
+ * any, to the step timer.  Only called from the timer service task.
+ */
+static void prvRunTimerStep( PeriodicJob_t *pxJob );
+
+/*
+ * Mark the release of the next job of pxJob, released at xRelease.
+ */
+static void prvMarkRelease( PeriodicJob_t *pxJob, TickType_t xRelease );
+
+/*
+ * Mark the start of the next job of pxJob, and its release if the tick hook
+ * has not marked it yet.  Only for task backed and external jobs.
+ */
+static void prvStartJob( PeriodicJob_t *pxJob );
+
+/*
+ * Have the tick hook mark the next release of pxJob at xRelease, or mark it
+ * now if xRelease has already passed.  Only for task backed and external
+ * jobs.
+ */
+static void prvExpectRelease( PeriodicJob_t *pxJob, TickType_t xRelease );
+
+/*
+ * Count a deadline miss of job ulJobIndex of pxJob, xLateness ticks late.
+ */
+static void prvMissDeadline( PeriodicJob_t *pxJob, uint32_t ulJobIndex, TickType_t xLateness );
+
+/*
+ * Mark the end of the current job of pxJob, and a deadline miss if it ended
+ * after the next release.
+ */
+static void prvEndJob( PeriodicJob_t *pxJob );
+
+/*
+ * The next free job, named pcName in the markers, with every member but the
+ * step function and the backing initialised, or NULL if periodicjobMAX_JOBS
+ * jobs already exist.  The job is only taken once uxJobCount is incremented.
+ */
+static PeriodicJob_t *prvNewJob( const char *pcName, TickType_t xPeriod );
+
+/*
+ * Register the channel and format of every marker with the recorder.
+ */
+static void prvRegisterMarkers( void );
+
+/*-----------------------------------------------------------*/
+
+static PeriodicJob_t xJobs[ periodicjobMAX_JOBS ];
+static UBaseType_t uxJobCount = 0;
+
+#if ( TRC_CFG_INCLUDE_USER_EVENTS == 1 )
+	static const char * const pcMarkerNames[ ePeriodicJobMarkerCount ] =
+	{
+		"Job release", "Job start", "Job end", "Deadline miss"
+	};
+
+	static const char * const pcMarkerFormats[ ePeriodicJobMarkerCount ] =
+	{
+		"%s #%d released at %d", "%s #%d", "%s #%d", "%s #%d late by %d"
+	};
+
+	static traceString xMarkerNames[ ePeriodicJobMarkerCount ];
+
+	#if ( TRC_CFG_USE_SEPARATE_USER_EVENT_BUFFER == 1 )
+		static traceUBChannel xMarkerChannels[ ePeriodicJobMarkerCount ];
+	#endif
+#endif
+
+/*-----------------------------------------------------------*/
+
+PeriodicJob_t *pxPeriodicJobCreate( const char *pcName, PeriodicJobStepFunction_t pxStepFunction, void *pvParameters,
+									TickType_t xPeriod, UBaseType_t uxPriority, uint16_t usStackDepth,
+									PeriodicJobBacking_t eBacking )
+{
+PeriodicJob_t *pxJob;
+BaseType_t xCreated;
+
+	configASSERT( pxStepFunction );
+	configASSERT( eBacking != ePeriodicJobExternal );
+
+	pxJob = prvNewJob( pcName, xPeriod );
+
+	if( pxJob == NULL )
+	{
+		return NULL;
+	}
+
+	pxJob->pxStepFunction = pxStepFunction;
+	pxJob->pvParameters = pvParameters;
+
+	if( eBacking == ePeriodicJobAuto )
+	{
+		eBacking = ( xPeriod >= periodicjobTIMER_MIN_PERIOD ) ? ePeriodicJobTimer : ePeriodicJobTask;
+	}
+
+	pxJob->eBacking = eBacking;
+
+	if( eBacking == ePeriodicJobTask )
+	{
+		xCreated = xTaskCreate( prvJobTask, pcName, usStackDepth, pxJob, uxPriority, &( pxJob->xTask ) );
+	}
+	else
+	{
+		pxJob->xReleaseTimer = xTimerCreate( pcName, xPeriod, pdTRUE, pxJob, prvReleaseTimerCallback );
+		pxJob->xStepTimer = xTimerCreate( pcName, periodicjobSTEP_INTERVAL, pdFALSE, pxJob, prvStepTimerCallback );
+
+		/* The timer command queue exists once a timer has been created, so
+		the release timer can be started before the scheduler.  It first
+		expires xPeriod ticks after the scheduler starts, so the first job is
+		run straight away by hand, as a task backed job's would be. */
+		xCreated = ( pxJob->xReleaseTimer != NULL ) && ( pxJob->xStepTimer != NULL ) &&
+				   ( xTimerStart( pxJob->xReleaseTimer, 0 ) == pdPASS ) &&
+				   ( xTimerPendFunctionCall( prvRelease, pxJob, 0, 0 ) == pdPASS );
+	}
+
+	if( xCreated != pdPASS )
+	{
+		return NULL;
+	}
+
+	uxJobCount++;
+
+	return pxJob;
+}
+/*-----------------------------------------------------------*/
+
+PeriodicJob_t *pxPeriodicJobCreateExternal( TaskHandle_t xTask, TickType_t xPeriod )
+{
+PeriodicJob_t *pxJob;
+
+	configASSERT( xTask );
+
+	pxJob = prvNewJob( pcTaskGetName( xTask ), xPeriod );
+
+	if( pxJob != NULL )
+	{
+		pxJob->eBacking = ePeriodicJobExternal;
+		pxJob->xTask = xTask;
+		uxJobCount++;
+	}
+
+	return pxJob;
+}
+/*-----------------------------------------------------------*/
+
+static PeriodicJob_t *prvNewJob( const char *pcName, TickType_t xPeriod )
+{
+PeriodicJob_t *pxJob;
+
+	configASSERT( xPeriod > 0 );
+	configASSERT( xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED );
+
+	if( uxJobCount >= periodicjobMAX_JOBS )
+	{
+		return NULL;
+	}
+
+	if( uxJobCount == 0 )
+	{
+		prvRegisterMarkers();
+	}
+
+	pxJob = &( xJobs[ uxJobCount ] );
+	pxJob->pxStepFunction = NULL;
+	pxJob->pvParameters = NULL;
+	pxJob->xPeriod = xPeriod;
+	pxJob->xTask = NULL;
+	pxJob->xReleaseTimer = NULL;
+	pxJob->xStepTimer = NULL;
+	pxJob->ulNextStep = 0;
+	pxJob->xRunning = pdFALSE;
+	pxJob->ulSkipped = 0;
+	pxJob->ulReleaseIndex = 0;
+	pxJob->ulJobIndex = 0;
+	pxJob->xRelease = 0;
+	pxJob->xNextRelease = 0;
+	pxJob->uxReleaseState = periodicjobRELEASE_UNKNOWN;
+	pxJob->ulDeadlineMisses = 0;
+
+	#if ( TRC_CFG_INCLUDE_USER_EVENTS == 1 )
+	{
+		/* The markers take the name as a string already in the recorder's
+		symbol table. */
+		pxJob->xName = xTraceRegisterString( pcName );
+	}
+	#else
+	{
+		( void ) pcName;
+	}
+	#endif
+
+	return pxJob;
+}
+/*-----------------------------------------------------------*/
+
+PeriodicJobBacking_t ePeriodicJobGetBacking( const PeriodicJob_t *pxJob )
+{
+	return pxJob->eBacking;
+}
+/*-----------------------------------------------------------*/
+
+TaskHandle_t xPeriodicJobGetTask( const PeriodicJob_t *pxJob )
+{
+TaskHandle_t xTask = pxJob->xTask;
+
+	if( ( pxJob->eBacking == ePeriodicJobTimer ) && ( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED ) )
+	{
+		xTask = xTimerGetTimerDaemonTaskHandle();
+	}
+
+	return xTask;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPeriodicJobGetSkipped( const PeriodicJob_t *pxJob )
+{
+	return pxJob->ulSkipped;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPeriodicJobGetDeadlineMisses( const PeriodicJob_t *pxJob )
+{
+	return pxJob->ulDeadlineMisses;
+}
+/*-----------------------------------------------------------*/
+
+void vPeriodicJobStart( PeriodicJob_t *pxJob )
+{
+	configASSERT( pxJob->eBacking == ePeriodicJobExternal );
+
+	prvStartJob( pxJob );
+}
+/*-----------------------------------------------------------*/
+
+void vPeriodicJobEnd( PeriodicJob_t *pxJob )
+{
+	configASSERT( pxJob->eBacking == ePeriodicJobExternal );
+
+	prvEndJob( pxJob );
+}
+/*-----------------------------------------------------------*/
+
+void vPeriodicJobSetNextRelease( PeriodicJob_t *pxJob, TickType_t xRelease )
+{
+	configASSERT( pxJob->eBacking == ePeriodicJobExternal );
+
+	prvExpectRelease( pxJob, xRelease );
+}
+/*-----------------------------------------------------------*/
+
+void vPeriodicJobDropRelease( PeriodicJob_t *pxJob )
+{
+	configASSERT( pxJob->eBacking == ePeriodicJobExternal );
+
+	/* A release already marked stays in the trace, without a job. */
+	taskENTER_CRITICAL();
+	{
+		pxJob->uxReleaseState = periodicjobRELEASE_UNKNOWN;
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vPeriodicJobReleaseFromISR( PeriodicJob_t *pxJob )
+{
+UBaseType_t uxSavedInterruptStatus;
+
+	configASSERT( pxJob->eBacking == ePeriodicJobExternal );
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		pxJob->xNextRelease = xTaskGetTickCountFromISR();
+		prvMarkRelease( pxJob, pxJob->xNextRelease );
+		pxJob->uxReleaseState = periodicjobRELEASE_MARKED;
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+}
+/*-----------------------------------------------------------*/
+
+void vPeriodicJobTickHook( void )
+{
+TickType_t xNow = xTaskGetTickCountFromISR();
+UBaseType_t x;
+PeriodicJob_t *pxJob;
+
+	for( x = 0; x < uxJobCount; x++ )
+	{
+		pxJob = &( xJobs[ x ] );
+
+		/* The release is due if it is not in the future, allowing for the
+		tick count to overflow. */
+		if( ( pxJob->uxReleaseState == periodicjobRELEASE_EXPECTED ) &&
+			( ( TickType_t ) ( xNow - pxJob->xNextRelease ) < ( portMAX_DELAY >> 1 ) ) )
+		{
+			prvMarkRelease( pxJob, pxJob->xNextRelease );
+			pxJob->uxReleaseState = periodicjobRELEASE_MARKED;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvJobTask( void *pvParameters )
+{
+PeriodicJob_t *pxJob = ( PeriodicJob_t * ) pvParameters;
+TickType_t xLastRelease = xTaskGetTickCount();
+uint32_t ulStep;
+
+	/* The first job is released when the task first runs. */
+	prvExpectRelease( pxJob, xLastRelease );
+
+	for( ;; )
+	{
+		prvStartJob( pxJob );
+		ulStep = 0;
+
+		while( pxJob->pxStepFunction( pxJob->pvParameters, ulStep ) != pdFALSE )
+		{
+			ulStep++;
+		}
+
+		prvEndJob( pxJob );
+
+		/* vTaskDelayUntil() releases the next job one period after this one
+		was released, which can be earlier than now if this job ran late. */
+		prvExpectRelease( pxJob, xLastRelease + pxJob->xPeriod );
+		vTaskDelayUntil( &xLastRelease, pxJob->xPeriod );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvReleaseTimerCallback( TimerHandle_t xTimer )
+{
+	prvRelease( pvTimerGetTimerID( xTimer ), 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRelease( void *pvParameter1, uint32_t ulParameter2 )
+{
+PeriodicJob_t *pxJob = ( PeriodicJob_t * ) pvParameter1;
+TickType_t xNow = xTaskGetTickCount();
+
+	( void ) ulParameter2;
+
+	/* The timer expires at the release instant, so the release is marked
+	here whether or not its job runs. */
+	prvMarkRelease( pxJob, xNow );
+
+	if( pxJob->xRunning != pdFALSE )
+	{
+		/* The job released now will never run, so misses its deadline. */
+		pxJob->ulSkipped++;
+		prvMissDeadline( pxJob, pxJob->ulReleaseIndex, 0 );
+	}
+	else
+	{
+		pxJob->xRunning = pdTRUE;
+		pxJob->ulNextStep = 0;
+		pxJob->ulJobIndex = pxJob->ulReleaseIndex;
+		pxJob->xRelease = xNow;
+		periodicjobMARK( ePeriodicJobStart, pxJob->xName, ( int ) pxJob->ulJobIndex );
+		prvRunTimerStep( pxJob );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvStepTimerCallback( TimerHandle_t xTimer )
+{
+	prvRunTimerStep( ( PeriodicJob_t * ) pvTimerGetTimerID( xTimer ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRunTimerStep( PeriodicJob_t *pxJob )
+{
+BaseType_t xMoreSteps;
+
+	/* Charge the step to the job, not to the timer service task. */
+	vBudgetWorkBegin( pxJob );
+	vProfilerWorkBegin( pxJob );
+	xMoreSteps = pxJob->pxStepFunction( pxJob->pvParameters, pxJob->ulNextStep );
+	vProfilerWorkEnd( pxJob );
+	vBudgetWorkEnd( pxJob );
+
+	if( xMoreSteps != pdFALSE )
+	{
+		pxJob->ulNextStep++;
+
+		/* Timer callbacks must not block, and the step timer is dormant, so
+		there is no reason for the command queue to be full. */
+		if( xTimerReset( pxJob->xStepTimer, 0 ) != pdPASS )
+		{
+			configASSERT( pdFALSE );
+			pxJob->xRunning = pdFALSE;
+			prvEndJob( pxJob );
+		}
+	}
+	else
+	{
+		pxJob->xRunning = pdFALSE;
+		prvEndJob( pxJob );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvMarkRelease( PeriodicJob_t *pxJob, TickType_t xRelease )
+{
+	pxJob->ulReleaseIndex++;
+	periodicjobMARK( ePeriodicJobRelease, pxJob->xName, ( int ) pxJob->ulReleaseIndex, ( int ) xRelease );
+}
+/*-----------------------------------------------------------*/
+
+static void prvStartJob( PeriodicJob_t *pxJob )
+{
+	/* The tick hook marks releases from the tick interrupt. */
+	taskENTER_CRITICAL();
+	{
+		if( pxJob->uxReleaseState == periodicjobRELEASE_UNKNOWN )
+		{
+			/* Released by something other than the expected release, so
+			released now. */
+			pxJob->xNextRelease = xTaskGetTickCount();
+			prvMarkRelease( pxJob, pxJob->xNextRelease );
+		}
+		else if( pxJob->uxReleaseState == periodicjobRELEASE_EXPECTED )
+		{
+			/* Without the tick hook, or before its tick, the release is only
+			marked now. */
+			prvMarkRelease( pxJob, pxJob->xNextRelease );
+		}
+
+		pxJob->uxReleaseState = periodicjobRELEASE_UNKNOWN;
+		pxJob->ulJobIndex = pxJob->ulReleaseIndex;
+		pxJob->xRelease = pxJob->xNextRelease;
+	}
+	taskEXIT_CRITICAL();
+
+	periodicjobMARK( ePeriodicJobStart, pxJob->xName, ( int ) pxJob->ulJobIndex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvExpectRelease( PeriodicJob_t *pxJob, TickType_t xRelease )
+{
+	taskENTER_CRITICAL();
+	{
+		pxJob->xNextRelease = xRelease;
+
+		if( ( TickType_t ) ( xTaskGetTickCount() - xRelease ) < ( portMAX_DELAY >> 1 ) )
+		{
+			/* Already released, while the previous job was running. */
+			prvMarkRelease( pxJob, xRelease );
+			pxJob->uxReleaseState = periodicjobRELEASE_MARKED;
+		}
+		else
+		{
+			pxJob->uxReleaseState = periodicjobRELEASE_EXPECTED;
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static void prvEndJob( PeriodicJob_t *pxJob )
+{
+TickType_t xResponse = xTaskGetTickCount() - pxJob->xRelease;
+
+	periodicjobMARK( ePeriodicJobEnd, pxJob->xName, ( int ) pxJob->ulJobIndex );
+
+	/* The deadline of each job is its next release. */
+	if( xResponse > pxJob->xPeriod )
+	{
+		prvMissDeadline( pxJob, pxJob->ulJobIndex, xResponse - pxJob->xPeriod );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvMissDeadline( PeriodicJob_t *pxJob, uint32_t ulJobIndex, TickType_t xLateness )
+{
+	pxJob->ulDeadlineMisses++;
+	periodicjobMARK( ePeriodicJobDeadlineMiss, pxJob->xName, ( int ) ulJobIndex, ( int ) xLateness );
+	vApplicationDeadlineMissHook( pxJob, ulJobIndex, xLateness );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRegisterMarkers( void )
+{
+	#if ( TRC_CFG_INCLUDE_USER_EVENTS == 1 )
+	{
+	UBaseType_t x;
+
+		for( x = 0; x < ePeriodicJobMarkerCount; x++ )
+		{
+			xMarkerNames[ x ] = xTraceRegisterString( pcMarkerNames[ x ] );
+
+			#if ( TRC_CFG_USE_SEPARATE_USER_EVENT_BUFFER == 1 )
+			{
+				xMarkerChannels[ x ] = xTraceRegisterUBChannel( xMarkerNames[ x ], xTraceRegisterString( pcMarkerFormats[ x ] ) );
+			}
+			#endif
+		}
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,185 @@
+/*
+ * Periodic jobs that can run either in a task of their own or as callbacks
+ * of the timer service (daemon) task, so a job with a long period does not
+ * need its own task and stack.
+ *
+ * A job is written as a sequence of steps.  The step function is called with
+ * ulStep set to 0 at each release, and is called again with the next step
+ * number for as long as it returns pdTRUE.  How the steps are run depends on
+ * the backing:
+ *
+ * ePeriodicJobTask - a task is created for the job.  At each release it runs
+ * all the steps one after the other, then blocks in vTaskDelayUntil() until
+ * the next release.
+ *
+ * ePeriodicJobTimer - the job is released by an auto-reload software timer.
+ * Step 0 runs in the timer's callback and each following step is deferred,
+ * by a one-shot timer, to periodicjobSTEP_INTERVAL ticks after the previous
+ * step finished.  The steps run at the priority of the daemon task, so unless
+ * the application lowers it once the scheduler has started each step delays
+ * even the tasks the job would otherwise have had a lower priority than, and
+ * must be short.  Each step is run between vBudgetWorkBegin() and
+ * vBudgetWorkEnd(), and vProfilerWorkBegin() and vProfilerWorkEnd(), with the
+ * job as the work, so a budget or profile declared for the job with
+ * vBudgetDeclareWork() or vProfilerDeclareWork() is charged with the time of
+ * its steps rather than with that of the daemon task.  Spreading a long job
+ * over many short steps keeps the time the job takes from the other tasks in
+ * each interval bounded, and lets the daemon process other timer commands
+ * between steps.  A release that happens while the previous job still has
+ * steps to run is skipped and counted.
+ *
+ * ePeriodicJobAuto - ePeriodicJobTimer if the period is at least
+ * periodicjobTIMER_MIN_PERIOD, otherwise ePeriodicJobTask.  Jobs released so
+ * rarely gain little from a task of their own, while frequent jobs would
+ * fill the timer command queue and delay every other timer.
+ *
+ * ePeriodicJobExternal - the job runs in a task of the application's own,
+ * which releases itself and calls vPeriodicJobStart() and vPeriodicJobEnd()
+ * around each job, so its jobs are marked and their deadline misses counted
+ * as those of the other jobs.  Created with pxPeriodicJobCreateExternal().
+ *
+ * Each job is marked in the trace with user events on four channels - "Job
+ * release", "Job start", "Job end" and "Deadline miss" - which carry the name
+ * of the job, the index of the job and, for a release, its release tick, or
+ * for a deadline miss, by how many ticks the job ended after its next
+ * release.  The name is the one given to pxPeriodicJobCreate(), which is also
+ * the name of the job's task or timers, or for an external job the name of its
+ * task, so the markers of a job can be told apart from those of the others
+ * and matched with its task in the trace.  A release is marked at the release
+ * instant: by the release timer of a timer backed job, even if the release is
+ * skipped, by vPeriodicJobTickHook() for the other jobs, at the tick their task
+ * is released at, and by vPeriodicJobReleaseFromISR() for an external job
+ * whose task is released by an interrupt.  Without any of these the release is
+ * marked when its job starts.  A skipped release is marked as a deadline miss
+ * by 0 ticks, as its job never runs.  The markers and the job names are
+ * registered with the recorder as the jobs are created, so vTraceEnable() must
+ * be called first, and their formats are fixed, so no string is formatted
+ * while the jobs run.  The response time of every job can therefore be read
+ * from the trace exactly, rather than inferred from the task switches.  The
+ * markers are user events, and are not stored while the user event class is
+ * filtered out - see TraceFilter.h.
+ */
+
+#ifndef PERIODIC_JOB_H
+#define PERIODIC_JOB_H
+
+#include "task.h"
+
+/* The maximum number of periodic jobs that can be created. */
+#define periodicjobMAX_JOBS				( 8 )
+
+/* Periods, in ticks, from which ePeriodicJobAuto uses a timer. */
+#ifndef periodicjobTIMER_MIN_PERIOD
+	#define periodicjobTIMER_MIN_PERIOD		pdMS_TO_TICKS( 1000 )
+#endif
+
+/* Ticks left free between two steps of a timer backed job. */
+#ifndef periodicjobSTEP_INTERVAL
+	#define periodicjobSTEP_INTERVAL		( 2 )
+#endif
+
+typedef enum
+{
+	ePeriodicJobAuto = 0,
+	ePeriodicJobTask,
+	ePeriodicJobTimer,
+	ePeriodicJobExternal
+} PeriodicJobBacking_t;
+
+typedef struct xPERIODIC_JOB PeriodicJob_t;
+
+/*
+ * Run step ulStep of the current job.  Return pdTRUE if the job has more
+ * steps, or pdFALSE when it is complete.
+ */
+typedef BaseType_t ( *PeriodicJobStepFunction_t )( void *pvParameters, uint32_t ulStep );
+
+/*
+ * Create a job released every xPeriod ticks, the first time when the
+ * scheduler starts.  uxPriority and usStackDepth are only used if the job
+ * gets a task of its own.  Returns NULL if periodicjobMAX_JOBS jobs already
+ * exist or the task or timers could not be created.  Must be called before
+ * the scheduler is started.  eBacking must not be ePeriodicJobExternal.
+ */
+PeriodicJob_t *pxPeriodicJobCreate( const char *pcName, PeriodicJobStepFunction_t pxStepFunction, void *pvParameters,
+									TickType_t xPeriod, UBaseType_t uxPriority, uint16_t usStackDepth,
+									PeriodicJobBacking_t eBacking );
+
+/*
+ * Create an external job for the jobs the task xTask runs in its own loop,
+ * each with a deadline xPeriod ticks after its release.  Returns NULL if
+ * periodicjobMAX_JOBS jobs already exist.  Must be called before the
+ * scheduler is started.
+ */
+PeriodicJob_t *pxPeriodicJobCreateExternal( TaskHandle_t xTask, TickType_t xPeriod );
+
+/*
+ * Called by the task of the external job pxJob as each job starts and ends.
+ * A job is released at the tick given to vPeriodicJobSetNextRelease() since
+ * the previous job ended, or, if none was given, when it starts.
+ */
+void vPeriodicJobStart( PeriodicJob_t *pxJob );
+void vPeriodicJobEnd( PeriodicJob_t *pxJob );
+
+/*
+ * Called by the task of the external job pxJob, after vPeriodicJobEnd(), with
+ * the tick its next job is released at, so vPeriodicJobTickHook() marks the
+ * release at that tick.
+ */
+void vPeriodicJobSetNextRelease( PeriodicJob_t *pxJob, TickType_t xRelease );
+
+/*
+ * Called by the task of the external job pxJob when its next job is not
+ * released at the tick given to vPeriodicJobSetNextRelease() after all,
+ * because the task waits for something else first.  The job is then
+ * released when it starts.
+ */
+void vPeriodicJobDropRelease( PeriodicJob_t *pxJob );
+
+/*
+ * Called by the interrupt that releases the task of the external job pxJob,
+ * for example a HiResTimer.h release hook, so the release is marked at the
+ * release instant even when it is not on a tick.  Must only be called from an
+ * interrupt.
+ */
+void vPeriodicJobReleaseFromISR( PeriodicJob_t *pxJob );
+
+/*
+ * Mark the releases due at this tick.  Registered with xTickWorkRegister() to
+ * run every tick.
+ */
+void vPeriodicJobTickHook( void );
+
+/*
+ * The backing chosen for pxJob, which is never ePeriodicJobAuto.
+ */
+PeriodicJobBacking_t ePeriodicJobGetBacking( const PeriodicJob_t *pxJob );
+
+/*
+ * The task the steps of pxJob run in: the job's own task, the task of an
+ * external job, or the timer service task.  The timer service task is only created when the scheduler
+ * starts, so NULL is returned for a timer backed job before then.
+ */
+TaskHandle_t xPeriodicJobGetTask( const PeriodicJob_t *pxJob );
+
+/*
+ * The number of releases of pxJob that were skipped because the previous
+ * job had not completed.  Always 0 for a task backed or external job, which
+ * runs late instead.
+ */
+uint32_t ulPeriodicJobGetSkipped( const PeriodicJob_t *pxJob );
+
+/*
+ * The number of jobs of pxJob that ended after the next release.
+ */
+uint32_t ulPeriodicJobGetDeadlineMisses( const PeriodicJob_t *pxJob );
+
+/*
+ * Defined by the application.  Called when job ulJobIndex of pxJob ends
+ * xLateness ticks after its next release, or with xLateness 0 when its
+ * release is skipped, from the job's task or from the timer service task, so
+ * it must not block.
+ */
+extern void vApplicationDeadlineMissHook( PeriodicJob_t *pxJob, uint32_t ulJobIndex, TickType_t xLateness );
+
+#endif /* PERIODIC_JOB_H */
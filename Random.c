@@ -0,0 +1,70 @@
+/*
+ * PCG32 pseudo random number generator.  See the comments in Random.h.
+ */
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+
+#include "Random.h"
+
+/* The 64 bit LCG multiplier used by PCG. */
+#define randomMULTIPLIER		( 6364136223846793005ULL )
+
+/*
+ * Advance the underlying linear congruential generator one step.
+ */
+static void prvStep( Random_t *pxRandom );
+
+/*-----------------------------------------------------------*/
+
+void vRandomSeed( Random_t *pxRandom, uint64_t ullSeed, uint64_t ullStream )
+{
+	pxRandom->ullState = 0ULL;
+	pxRandom->ullIncrement = ( ullStream << 1 ) | 1ULL;
+	prvStep( pxRandom );
+	pxRandom->ullState += ullSeed;
+	prvStep( pxRandom );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulRandomNext( Random_t *pxRandom )
+{
+uint64_t ullOldState = pxRandom->ullState;
+uint32_t ulXorShifted, ulRotate, ulValue;
+
+	prvStep( pxRandom );
+
+	/* Output function XSH RR: xorshift the high bits, then rotate by the top
+	five bits. */
+	ulXorShifted = ( uint32_t ) ( ( ( ullOldState >> 18U ) ^ ullOldState ) >> 27U );
+	ulRotate = ( uint32_t ) ( ullOldState >> 59U );
+
+	ulValue = ( ulXorShifted >> ulRotate ) | ( ulXorShifted << ( ( 32U - ulRotate ) & 31U ) );
+	traceRANDOM_DRAW( pxRandom, ulValue );
+
+	return ulValue;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulRandomBounded( Random_t *pxRandom, uint32_t ulBound )
+{
+uint32_t ulThreshold, ulValue;
+
+	/* Discard the values below 2^32 % ulBound, so every result is equally
+	likely. */
+	ulThreshold = ( 0U - ulBound ) % ulBound;
+
+	do
+	{
+		ulValue = ulRandomNext( pxRandom );
+	} while( ulValue < ulThreshold );
+
+	return ulValue % ulBound;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStep( Random_t *pxRandom )
+{
+	pxRandom->ullState = ( pxRandom->ullState * randomMULTIPLIER ) + pxRandom->ullIncrement;
+}
+/*-----------------------------------------------------------*/
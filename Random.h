@@ -0,0 +1,44 @@
+/*
+ * A small pseudo random number generator (PCG32, see https://www.pcg-random.org).
+ *
+ * Each generator holds its own 128 bits of state, so every task can own one
+ * and draw numbers without sharing the hidden state behind rand(), which is
+ * not re-entrant.  A generator is fully determined by its seed and its stream,
+ * so a run can be repeated by reusing the seed it was given.  Generators
+ * seeded with the same seed but different streams produce independent
+ * sequences, which allows one session seed to feed several tasks.
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+/* Called with every number drawn, for example to record the draws of a run.
+Can be defined in FreeRTOSConfig.h. */
+#ifndef traceRANDOM_DRAW
+	#define traceRANDOM_DRAW( pxRandom, ulValue )
+#endif
+
+typedef struct xRANDOM
+{
+	uint64_t ullState;
+	uint64_t ullIncrement;		/* Selects the stream, always odd. */
+} Random_t;
+
+/*
+ * Start pxRandom at the beginning of the sequence given by ullSeed and
+ * ullStream.
+ */
+void vRandomSeed( Random_t *pxRandom, uint64_t ullSeed, uint64_t ullStream );
+
+/*
+ * Return the next 32 bit number in the sequence.
+ */
+uint32_t ulRandomNext( Random_t *pxRandom );
+
+/*
+ * Return a number uniformly distributed between 0 and ulBound - 1 inclusive.
+ * ulBound must not be 0.
+ */
+uint32_t ulRandomBounded( Random_t *pxRandom, uint32_t ulBound );
+
+#endif /* RANDOM_H */
@@ -0,0 +1,351 @@
+/*
+ * Record and replay of a run.  See the comments in Replay.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "Replay.h"
+
+/* FNV-1a 64 bit parameters. */
+#define replayFNV_OFFSET_BASIS		( 0xcbf29ce484222325ULL )
+#define replayFNV_PRIME				( 0x100000001b3ULL )
+
+/* Event types, also used as the type field in the file. */
+#define replayEVENT_JOB				( ( uint8_t ) 'J' )
+#define replayEVENT_INPUT			( ( uint8_t ) 'I' )
+#define replayEVENT_DRAW			( ( uint8_t ) 'D' )
+
+/* Marks a recorded event that has no match yet. */
+#define replayNO_DIVERGENCE			( ( uint32_t ) 0xffffffffUL )
+
+typedef struct xREPLAY_EVENT
+{
+	TickType_t xTick;
+	uint32_t ulValue;
+	uint8_t ucType;
+	uint8_t ucId;		/* The task, input source or random stream. */
+} ReplayEvent_t;
+
+/*
+ * Add an event to the hash and, depending on the mode, store it or compare it
+ * with the recorded event in the same position.
+ */
+static void prvReport( uint8_t ucType, uint8_t ucId, uint32_t ulValue );
+
+/*
+ * Return the index of the first recorded input from ucSource at or after
+ * ulFrom, or ulRecordedCount if there are none left.
+ */
+static uint32_t prvFindInput( uint8_t ucSource, uint32_t ulFrom );
+
+/*
+ * Return the next recorded input from ucSource, or NULL if there are none
+ * left, and take it.
+ */
+static const ReplayEvent_t *prvPeekInput( uint8_t ucSource );
+static void prvTakeInput( uint8_t ucSource );
+
+/*-----------------------------------------------------------*/
+
+static ReplayMode_t eMode = eReplayOff;
+static const char *pcReplayFileName = NULL;
+static uint64_t ullSeed = 0ULL;
+
+/* In record mode the events of this run, in replay mode the recorded ones. */
+static ReplayEvent_t xEvents[ replayMAX_EVENTS ];
+static uint32_t ulRecordedCount = 0UL;
+static uint64_t ullRecordedHash = 0ULL;
+
+/* The events of this run. */
+static uint32_t ulEventCount = 0UL;
+static uint64_t ullHash = replayFNV_OFFSET_BASIS;
+
+/* Replay mode only - the first event of this run that differed from the
+recording, and the index of the next recorded input of each source. */
+static uint32_t ulDivergence = replayNO_DIVERGENCE;
+static uint32_t ulNextInput[ replayMAX_SOURCES ];
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xReplayInitialise( ReplayMode_t eNewMode, const char *pcFileName, uint64_t *pullSeed )
+{
+BaseType_t xReturn = pdPASS;
+FILE *pxFile;
+unsigned long ulTick, ulValue;
+unsigned int uxId;
+uint8_t ucSource;
+unsigned long long ullValue;
+char cType;
+
+	pcReplayFileName = pcFileName;
+	eMode = eReplayOff;
+
+	if( eNewMode == eReplayRecord )
+	{
+		ullSeed = *pullSeed;
+		eMode = eReplayRecord;
+	}
+	else if( eNewMode == eReplayPlay )
+	{
+		pxFile = fopen( pcFileName, "r" );
+
+		if( ( pxFile != NULL ) && ( fscanf( pxFile, " S %llu", &ullValue ) == 1 ) )
+		{
+			ullSeed = ( uint64_t ) ullValue;
+
+			while( ( ulRecordedCount < replayMAX_EVENTS ) &&
+				   ( fscanf( pxFile, " E %lu %c %u %lu", &ulTick, &cType, &uxId, &ulValue ) == 4 ) )
+			{
+				xEvents[ ulRecordedCount ].xTick = ( TickType_t ) ulTick;
+				xEvents[ ulRecordedCount ].ucType = ( uint8_t ) cType;
+				xEvents[ ulRecordedCount ].ucId = ( uint8_t ) uxId;
+				xEvents[ ulRecordedCount ].ulValue = ( uint32_t ) ulValue;
+				ulRecordedCount++;
+			}
+
+			if( fscanf( pxFile, " H %llx", &ullValue ) == 1 )
+			{
+				ullRecordedHash = ( uint64_t ) ullValue;
+				*pullSeed = ullSeed;
+				eMode = eReplayPlay;
+
+				for( ucSource = 0; ucSource < replayMAX_SOURCES; ucSource++ )
+				{
+					ulNextInput[ ucSource ] = prvFindInput( ucSource, 0UL );
+				}
+			}
+			else
+			{
+				xReturn = pdFAIL;
+			}
+		}
+		else
+		{
+			xReturn = pdFAIL;
+		}
+
+		if( pxFile != NULL )
+		{
+			fclose( pxFile );
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+ReplayMode_t eReplayGetMode( void )
+{
+	return eMode;
+}
+/*-----------------------------------------------------------*/
+
+void vReplayJobReleased( uint8_t ucTask )
+{
+	prvReport( replayEVENT_JOB, ucTask, 0UL );
+}
+/*-----------------------------------------------------------*/
+
+void vReplayRandomDraw( uint64_t ullStream, uint32_t ulValue )
+{
+	prvReport( replayEVENT_DRAW, ( uint8_t ) ullStream, ulValue );
+}
+/*-----------------------------------------------------------*/
+
+void vReplayInput( uint8_t ucSource, int32_t lValue )
+{
+	if( eMode != eReplayPlay )
+	{
+		prvReport( replayEVENT_INPUT, ucSource, ( uint32_t ) lValue );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xReplayPollInput( uint8_t ucSource, int32_t *plValue )
+{
+const ReplayEvent_t *pxInput;
+BaseType_t xReturn = pdFALSE;
+
+	configASSERT( ucSource < replayMAX_SOURCES );
+
+	pxInput = prvPeekInput( ucSource );
+
+	if( ( pxInput != NULL ) && ( xTaskGetTickCount() >= pxInput->xTick ) )
+	{
+		*plValue = ( int32_t ) pxInput->ulValue;
+		prvTakeInput( ucSource );
+		prvReport( replayEVENT_INPUT, ucSource, pxInput->ulValue );
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+int32_t lReplayWaitInput( uint8_t ucSource, int32_t lDefault )
+{
+const ReplayEvent_t *pxInput;
+TickType_t xNow;
+int32_t lValue = lDefault;
+
+	configASSERT( ucSource < replayMAX_SOURCES );
+
+	pxInput = prvPeekInput( ucSource );
+
+	if( pxInput != NULL )
+	{
+		/* Before the scheduler starts the tick count does not move, so the
+		input is taken straight away. */
+		xNow = xTaskGetTickCount();
+
+		if( ( xTaskGetSchedulerState() == taskSCHEDULER_RUNNING ) && ( xNow < pxInput->xTick ) )
+		{
+			vTaskDelay( pxInput->xTick - xNow );
+		}
+
+		lValue = ( int32_t ) pxInput->ulValue;
+		prvTakeInput( ucSource );
+		prvReport( replayEVENT_INPUT, ucSource, pxInput->ulValue );
+	}
+
+	return lValue;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullReplayGetHash( void )
+{
+	return ullHash;
+}
+/*-----------------------------------------------------------*/
+
+void vReplayFinish( void )
+{
+FILE *pxFile;
+uint32_t x;
+
+	if( eMode == eReplayRecord )
+	{
+		pxFile = fopen( pcReplayFileName, "w" );
+
+		if( pxFile != NULL )
+		{
+			fprintf( pxFile, "S %llu\n", ( unsigned long long ) ullSeed );
+
+			for( x = 0; x < ulRecordedCount; x++ )
+			{
+				fprintf( pxFile, "E %lu %c %u %lu\n", ( unsigned long ) xEvents[ x ].xTick, ( char ) xEvents[ x ].ucType,
+						 ( unsigned int ) xEvents[ x ].ucId, ( unsigned long ) xEvents[ x ].ulValue );
+			}
+
+			fprintf( pxFile, "H %016llx\n", ( unsigned long long ) ullHash );
+			fclose( pxFile );
+		}
+
+		printf( "\r\nRecorded %lu events to %s, hash %016llx%s\r\n", ( unsigned long ) ulEventCount, pcReplayFileName,
+				( unsigned long long ) ullHash, ( ulEventCount > ulRecordedCount ) ? " (events past the limit not saved)" : "" );
+	}
+	else if( eMode == eReplayPlay )
+	{
+		/* A shorter run than the recording also differs from it. */
+		if( ( ulDivergence == replayNO_DIVERGENCE ) && ( ulEventCount < ulRecordedCount ) )
+		{
+			ulDivergence = ulEventCount;
+		}
+
+		printf( "\r\nReplayed %lu of %lu events, hash %016llx, recorded %016llx: %s\r\n", ( unsigned long ) ulEventCount,
+				( unsigned long ) ulRecordedCount, ( unsigned long long ) ullHash, ( unsigned long long ) ullRecordedHash,
+				( ullHash == ullRecordedHash ) ? "IDENTICAL" : "DIFFERENT" );
+
+		if( ( ulDivergence != replayNO_DIVERGENCE ) && ( ulDivergence < ulRecordedCount ) )
+		{
+			printf( "First difference at event %lu, recorded as %c %u at tick %lu\r\n", ( unsigned long ) ulDivergence,
+					( char ) xEvents[ ulDivergence ].ucType, ( unsigned int ) xEvents[ ulDivergence ].ucId,
+					( unsigned long ) xEvents[ ulDivergence ].xTick );
+		}
+	}
+
+	eMode = eReplayOff;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReport( uint8_t ucType, uint8_t ucId, uint32_t ulValue )
+{
+ReplayEvent_t xEvent;
+const uint8_t *pucByte = ( const uint8_t * ) &xEvent;
+size_t x;
+
+	if( eMode != eReplayOff )
+	{
+		/* Zeroed first so any padding hashes the same on every run. */
+		memset( &xEvent, 0x00, sizeof( xEvent ) );
+		xEvent.xTick = xTaskGetTickCount();
+		xEvent.ucType = ucType;
+		xEvent.ucId = ucId;
+		xEvent.ulValue = ulValue;
+
+		taskENTER_CRITICAL();
+		{
+			for( x = 0; x < sizeof( xEvent ); x++ )
+			{
+				ullHash ^= ( uint64_t ) pucByte[ x ];
+				ullHash *= replayFNV_PRIME;
+			}
+
+			if( ulEventCount < replayMAX_EVENTS )
+			{
+				if( eMode == eReplayRecord )
+				{
+					xEvents[ ulEventCount ] = xEvent;
+					ulRecordedCount = ulEventCount + 1UL;
+				}
+				else if( ( ulDivergence == replayNO_DIVERGENCE ) &&
+						 ( ( ulEventCount >= ulRecordedCount ) || ( memcmp( &xEvents[ ulEventCount ], &xEvent, sizeof( xEvent ) ) != 0 ) ) )
+				{
+					ulDivergence = ulEventCount;
+				}
+			}
+
+			ulEventCount++;
+		}
+		taskEXIT_CRITICAL();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvFindInput( uint8_t ucSource, uint32_t ulFrom )
+{
+uint32_t x = ulFrom;
+
+	while( ( x < ulRecordedCount ) && ( ( xEvents[ x ].ucType != replayEVENT_INPUT ) || ( xEvents[ x ].ucId != ucSource ) ) )
+	{
+		x++;
+	}
+
+	return x;
+}
+/*-----------------------------------------------------------*/
+
+static const ReplayEvent_t *prvPeekInput( uint8_t ucSource )
+{
+const ReplayEvent_t *pxInput = NULL;
+
+	if( ulNextInput[ ucSource ] < ulRecordedCount )
+	{
+		pxInput = &( xEvents[ ulNextInput[ ucSource ] ] );
+	}
+
+	return pxInput;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTakeInput( uint8_t ucSource )
+{
+	ulNextInput[ ucSource ] = prvFindInput( ucSource, ulNextInput[ ucSource ] + 1UL );
+}
+/*-----------------------------------------------------------*/
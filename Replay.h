@@ -0,0 +1,94 @@
+/*
+ * Record and replay of a run.
+ *
+ * In record mode every event that can make one run differ from another is
+ * kept, stamped with the tick count at which it happened:
+ *
+ *  - each release of a job, reported by the task at the start of the job;
+ *  - each external input, such as a key press or a menu choice;
+ *  - each number drawn from a Random_t generator (see Random.h).
+ *
+ * A 64 bit FNV-1a hash of the whole sequence is kept as it grows.  When the
+ * run ends the events, the seed of the run and the hash are written to a
+ * file.
+ *
+ * In replay mode the file is loaded, the recorded seed is used, and inputs
+ * are delivered at the ticks at which they were recorded instead of being
+ * read from the console.  Every event of the new run is compared with the
+ * recorded one, and at the end the two hashes are compared.  Equal hashes mean
+ * the run released the same jobs, in the same order, at the same ticks, and
+ * made the same decisions, so a run that missed a deadline can be repeated
+ * under a debugger or a profiler.  If they differ, the first event that did
+ * not match is reported.
+ *
+ * The Win32 port runs each task in a host thread, so host load can still
+ * change the timing of a replayed run.  The hash comparison shows whether
+ * that happened.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+/* The maximum number of events kept.  Events past this limit are still
+hashed, but are not written to, or compared with, the file. */
+#define replayMAX_EVENTS			( 262144UL )
+
+/* Input sources are numbered by the application, from 0 up to
+replayMAX_SOURCES - 1. */
+#define replayMAX_SOURCES			( 8 )
+
+typedef enum
+{
+	eReplayOff = 0,
+	eReplayRecord,
+	eReplayPlay
+} ReplayMode_t;
+
+/*
+ * Select the mode.  In record mode *pullSeed is the seed of the run and is
+ * saved with the events in pcFileName when the run ends.  In replay mode the
+ * events are loaded from pcFileName and *pullSeed is set to the recorded
+ * seed.  Returns pdFAIL, and leaves the mode off, if the file can not be
+ * loaded.  Must be called before the scheduler is started.
+ */
+BaseType_t xReplayInitialise( ReplayMode_t eMode, const char *pcFileName, uint64_t *pullSeed );
+
+ReplayMode_t eReplayGetMode( void );
+
+/*
+ * Report the events of the run.  ucTask is any number that identifies the
+ * task.  vReplayRandomDraw() is called by the traceRANDOM_DRAW() macro.
+ */
+void vReplayJobReleased( uint8_t ucTask );
+void vReplayRandomDraw( uint64_t ullStream, uint32_t ulValue );
+
+/*
+ * Report an input read from ucSource while not replaying.  Does nothing in
+ * replay mode, as the input then comes from the functions below.
+ */
+void vReplayInput( uint8_t ucSource, int32_t lValue );
+
+/*
+ * Replay mode only.  xReplayPollInput() returns pdTRUE and the value of the
+ * next recorded input from ucSource if the tick count has reached the tick
+ * at which it was recorded, or pdFALSE if no input is due.
+ * lReplayWaitInput() delays the calling task until the next recorded input
+ * from ucSource is due, then returns it.  It returns lDefault if no input
+ * from ucSource is left.
+ */
+BaseType_t xReplayPollInput( uint8_t ucSource, int32_t *plValue );
+int32_t lReplayWaitInput( uint8_t ucSource, int32_t lDefault );
+
+/*
+ * The hash of the events reported so far.
+ */
+uint64_t ullReplayGetHash( void );
+
+/*
+ * End the run.  In record mode the events are written to the file.  In
+ * replay mode the result of the comparison is printed with printf(), so this
+ * must only be called when no other task is writing to the console.
+ */
+void vReplayFinish( void );
+
+#endif /* REPLAY_H */
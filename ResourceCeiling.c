@@ -0,0 +1,441 @@
+/*
+ * Immediate priority ceiling and stack resource policy resources, with
+ * blocking time accounting and response time analysis.  See the comments in
+ * ResourceCeiling.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "ResourceCeiling.h"
+
+/* Convert a time in ticks to run time stats counter units. */
+#define ceilingTICKS_TO_RUN_TIME( xTicks ) ( ( uint32_t ) ( xTicks ) * portTICK_PERIOD_MS * ceilingRUN_TIME_UNITS_PER_MS )
+
+/* Returned when a task handle has not been declared. */
+#define ceilingUNKNOWN_TASK			( ( UBaseType_t ) ceilingMAX_TASKS )
+
+typedef struct xCEILING_TASK
+{
+	TaskHandle_t xHandle;
+	UBaseType_t uxPriority;			/* Read by vCeilingComputeCeilings(). */
+	UBaseType_t uxPreemptionLevel;	/* 1 for the longest relative deadline, higher for shorter deadlines. */
+	uint32_t ulWcet;				/* The following are in run time stats counter units. */
+	uint32_t ulPeriod;
+	uint32_t ulDeadline;
+} CeilingTask_t;
+
+struct xCEILING_RESOURCE
+{
+	const char *pcName;
+	CeilingPolicy_t ePolicy;
+	uint32_t ulUsers;					/* Bit n is set if xTasks[ n ] uses the resource. */
+	UBaseType_t uxPriorityCeiling;		/* The priority the holder runs at. */
+	UBaseType_t uxPreemptionCeiling;	/* The highest preemption level of any user. */
+	TaskHandle_t xHolder;
+	UBaseType_t uxHolderIndex;
+	UBaseType_t uxHolderPriority;		/* The holder's priority before it took the resource. */
+	uint32_t ulTakenAt;
+	uint32_t ulLongestHold[ ceilingMAX_TASKS ];	/* Longest measured critical section of each user. */
+};
+
+/*
+ * Return the index into xTasks[] of xTask, or ceilingUNKNOWN_TASK if xTask
+ * was not declared.
+ */
+static UBaseType_t prvTaskIndex( TaskHandle_t xTask );
+
+/*-----------------------------------------------------------*/
+
+static CeilingTask_t xTasks[ ceilingMAX_TASKS ];
+static UBaseType_t uxTaskCount = 0;
+
+static CeilingResource_t xResources[ ceilingMAX_RESOURCES ];
+static UBaseType_t uxResourceCount = 0;
+
+/* The resources currently held, in the order they were taken.  The top of
+the stack sets the system ceiling. */
+static CeilingResource_t *pxHeld[ ceilingMAX_RESOURCES ];
+static volatile UBaseType_t uxHeldCount = 0;
+
+/*-----------------------------------------------------------*/
+
+void vCeilingDeclareTask( TaskHandle_t xTask, TickType_t xWcet, TickType_t xPeriod, TickType_t xDeadline )
+{
+	configASSERT( xTask );
+	configASSERT( uxTaskCount < ceilingMAX_TASKS );
+	configASSERT( prvTaskIndex( xTask ) == ceilingUNKNOWN_TASK );
+
+	xTasks[ uxTaskCount ].xHandle = xTask;
+	xTasks[ uxTaskCount ].ulWcet = ceilingTICKS_TO_RUN_TIME( xWcet );
+	xTasks[ uxTaskCount ].ulPeriod = ceilingTICKS_TO_RUN_TIME( xPeriod );
+	xTasks[ uxTaskCount ].ulDeadline = ceilingTICKS_TO_RUN_TIME( xDeadline );
+	uxTaskCount++;
+}
+/*-----------------------------------------------------------*/
+
+CeilingResource_t *pxCeilingResourceCreate( const char *pcName, CeilingPolicy_t ePolicy )
+{
+CeilingResource_t *pxResource = NULL;
+
+	if( uxResourceCount < ceilingMAX_RESOURCES )
+	{
+		pxResource = &( xResources[ uxResourceCount ] );
+		uxResourceCount++;
+
+		pxResource->pcName = pcName;
+		pxResource->ePolicy = ePolicy;
+		pxResource->ulUsers = 0;
+		pxResource->uxPriorityCeiling = tskIDLE_PRIORITY;
+		pxResource->uxPreemptionCeiling = 0;
+		pxResource->xHolder = NULL;
+	}
+
+	return pxResource;
+}
+/*-----------------------------------------------------------*/
+
+void vCeilingDeclareUse( CeilingResource_t *pxResource, TaskHandle_t xTask )
+{
+UBaseType_t uxIndex = prvTaskIndex( xTask );
+
+	configASSERT( pxResource );
+	configASSERT( uxIndex != ceilingUNKNOWN_TASK );
+
+	pxResource->ulUsers |= ( 1UL << uxIndex );
+}
+/*-----------------------------------------------------------*/
+
+void vCeilingComputeCeilings( void )
+{
+UBaseType_t x, y;
+CeilingResource_t *pxResource;
+
+	/* Priorities can be changed after a task is declared, so read them now. */
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		xTasks[ x ].uxPriority = uxTaskPriorityGet( xTasks[ x ].xHandle );
+	}
+
+	/* A task's preemption level is one more than the number of tasks that
+	have a strictly longer relative deadline. */
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		xTasks[ x ].uxPreemptionLevel = 1;
+
+		for( y = 0; y < uxTaskCount; y++ )
+		{
+			if( xTasks[ y ].ulDeadline > xTasks[ x ].ulDeadline )
+			{
+				xTasks[ x ].uxPreemptionLevel++;
+			}
+		}
+	}
+
+	for( x = 0; x < uxResourceCount; x++ )
+	{
+		pxResource = &( xResources[ x ] );
+		pxResource->uxPriorityCeiling = tskIDLE_PRIORITY;
+		pxResource->uxPreemptionCeiling = 0;
+
+		for( y = 0; y < uxTaskCount; y++ )
+		{
+			if( ( pxResource->ulUsers & ( 1UL << y ) ) != 0 )
+			{
+				if( xTasks[ y ].uxPriority > pxResource->uxPriorityCeiling )
+				{
+					pxResource->uxPriorityCeiling = xTasks[ y ].uxPriority;
+				}
+
+				if( xTasks[ y ].uxPreemptionLevel > pxResource->uxPreemptionCeiling )
+				{
+					pxResource->uxPreemptionCeiling = xTasks[ y ].uxPreemptionLevel;
+				}
+			}
+		}
+
+		if( pxResource->ePolicy == eCeilingStackResource )
+		{
+			/* No task whose preemption level is at or below the ceiling may
+			preempt the holder, whether or not it uses the resource itself. */
+			for( y = 0; y < uxTaskCount; y++ )
+			{
+				if( ( xTasks[ y ].uxPreemptionLevel <= pxResource->uxPreemptionCeiling ) &&
+					( xTasks[ y ].uxPriority > pxResource->uxPriorityCeiling ) )
+				{
+					pxResource->uxPriorityCeiling = xTasks[ y ].uxPriority;
+				}
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vCeilingResourceTake( CeilingResource_t *pxResource )
+{
+TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
+UBaseType_t uxIndex = prvTaskIndex( xCurrentTask );
+UBaseType_t uxPriority;
+
+	/* Only declared users may take the resource, otherwise the ceiling would
+	not be high enough to keep the other users out. */
+	configASSERT( uxIndex != ceilingUNKNOWN_TASK );
+	configASSERT( ( pxResource->ulUsers & ( 1UL << uxIndex ) ) != 0 );
+
+	uxPriority = uxTaskPriorityGet( NULL );
+
+	if( uxPriority < pxResource->uxPriorityCeiling )
+	{
+		vTaskPrioritySet( NULL, pxResource->uxPriorityCeiling );
+	}
+
+	/* Running at the ceiling means no other user can be running, and users
+	may not block while holding the resource, so it must be free. */
+	configASSERT( pxResource->xHolder == NULL );
+
+	pxResource->xHolder = xCurrentTask;
+	pxResource->uxHolderIndex = uxIndex;
+	pxResource->uxHolderPriority = uxPriority;
+
+	taskENTER_CRITICAL();
+	{
+		configASSERT( uxHeldCount < ceilingMAX_RESOURCES );
+		pxHeld[ uxHeldCount ] = pxResource;
+		uxHeldCount++;
+	}
+	taskEXIT_CRITICAL();
+
+	pxResource->ulTakenAt = portGET_RUN_TIME_COUNTER_VALUE();
+}
+/*-----------------------------------------------------------*/
+
+void vCeilingResourceGive( CeilingResource_t *pxResource )
+{
+uint32_t ulHeldFor = portGET_RUN_TIME_COUNTER_VALUE() - pxResource->ulTakenAt;
+UBaseType_t uxPriority = pxResource->uxHolderPriority;
+
+	configASSERT( pxResource->xHolder == xTaskGetCurrentTaskHandle() );
+
+	if( ulHeldFor > pxResource->ulLongestHold[ pxResource->uxHolderIndex ] )
+	{
+		pxResource->ulLongestHold[ pxResource->uxHolderIndex ] = ulHeldFor;
+	}
+
+	taskENTER_CRITICAL();
+	{
+		/* Resources must be given back in the reverse order to which they
+		were taken. */
+		configASSERT( uxHeldCount > 0 );
+		configASSERT( pxHeld[ uxHeldCount - 1 ] == pxResource );
+		uxHeldCount--;
+	}
+	taskEXIT_CRITICAL();
+
+	pxResource->xHolder = NULL;
+
+	if( uxPriority < pxResource->uxPriorityCeiling )
+	{
+		vTaskPrioritySet( NULL, uxPriority );
+	}
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxCeilingGetSystemCeiling( void )
+{
+UBaseType_t uxCeiling = 0, x;
+
+	taskENTER_CRITICAL();
+	{
+		for( x = 0; x < uxHeldCount; x++ )
+		{
+			if( pxHeld[ x ]->uxPreemptionCeiling > uxCeiling )
+			{
+				uxCeiling = pxHeld[ x ]->uxPreemptionCeiling;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	return uxCeiling;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xCeilingMayPreempt( TaskHandle_t xTask )
+{
+UBaseType_t uxIndex = prvTaskIndex( xTask );
+BaseType_t xReturn = pdFALSE;
+
+	if( ( uxIndex != ceilingUNKNOWN_TASK ) && ( xTasks[ uxIndex ].uxPreemptionLevel > uxCeilingGetSystemCeiling() ) )
+	{
+		xReturn = pdTRUE;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulCeilingGetBlockingTime( TaskHandle_t xTask )
+{
+UBaseType_t uxIndex = prvTaskIndex( xTask ), x, y;
+CeilingResource_t *pxResource;
+BaseType_t xCanBlock, xIsLower;
+uint32_t ulBlocking = 0;
+
+	configASSERT( uxIndex != ceilingUNKNOWN_TASK );
+
+	for( x = 0; x < uxResourceCount; x++ )
+	{
+		pxResource = &( xResources[ x ] );
+
+		/* Only a resource whose ceiling is at or above the task can block it. */
+		if( pxResource->ePolicy == eCeilingStackResource )
+		{
+			xCanBlock = ( pxResource->uxPreemptionCeiling >= xTasks[ uxIndex ].uxPreemptionLevel );
+		}
+		else
+		{
+			xCanBlock = ( pxResource->uxPriorityCeiling >= xTasks[ uxIndex ].uxPriority );
+		}
+
+		if( xCanBlock == pdFALSE )
+		{
+			continue;
+		}
+
+		/* ...and only while it is held by a lower priority (or, under the
+		stack resource policy, lower preemption level) task. */
+		for( y = 0; y < uxTaskCount; y++ )
+		{
+			if( ( pxResource->ulUsers & ( 1UL << y ) ) == 0 )
+			{
+				continue;
+			}
+
+			if( pxResource->ePolicy == eCeilingStackResource )
+			{
+				xIsLower = ( xTasks[ y ].uxPreemptionLevel < xTasks[ uxIndex ].uxPreemptionLevel );
+			}
+			else
+			{
+				xIsLower = ( xTasks[ y ].uxPriority < xTasks[ uxIndex ].uxPriority );
+			}
+
+			if( ( xIsLower != pdFALSE ) && ( pxResource->ulLongestHold[ y ] > ulBlocking ) )
+			{
+				ulBlocking = pxResource->ulLongestHold[ y ];
+			}
+		}
+	}
+
+	return ulBlocking;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulCeilingGetResponseTime( TaskHandle_t xTask )
+{
+UBaseType_t uxIndex = prvTaskIndex( xTask ), x;
+uint32_t ulResponse, ulPrevious = 0, ulBase;
+
+	configASSERT( uxIndex != ceilingUNKNOWN_TASK );
+
+	/* R = C + B + sum over higher (or equal, as equal priority tasks share
+	time slices) priority tasks of ceil( R / Tj ) * Cj, iterated to a fixed
+	point. */
+	ulBase = xTasks[ uxIndex ].ulWcet + ulCeilingGetBlockingTime( xTask );
+	ulResponse = ulBase;
+
+	while( ( ulResponse != ulPrevious ) && ( ulResponse <= xTasks[ uxIndex ].ulDeadline ) )
+	{
+		ulPrevious = ulResponse;
+		ulResponse = ulBase;
+
+		for( x = 0; x < uxTaskCount; x++ )
+		{
+			if( ( x != uxIndex ) && ( xTasks[ x ].uxPriority >= xTasks[ uxIndex ].uxPriority ) && ( xTasks[ x ].ulPeriod != 0 ) )
+			{
+				ulResponse += ( ( ulPrevious + xTasks[ x ].ulPeriod - 1 ) / xTasks[ x ].ulPeriod ) * xTasks[ x ].ulWcet;
+			}
+		}
+	}
+
+	if( ulResponse > xTasks[ uxIndex ].ulDeadline )
+	{
+		ulResponse = 0;
+	}
+
+	return ulResponse;
+}
+/*-----------------------------------------------------------*/
+
+void vCeilingPrintAnalysis( void )
+{
+UBaseType_t x, y;
+CeilingResource_t *pxResource;
+uint32_t ulResponse;
+
+	printf( "\r\nResource          Policy  Ceiling  Level  Longest critical section (ms) per user\r\n" );
+
+	for( x = 0; x < uxResourceCount; x++ )
+	{
+		pxResource = &( xResources[ x ] );
+		printf( "%-16s  %-6s  %7u  %5u ", pxResource->pcName,
+										 ( pxResource->ePolicy == eCeilingStackResource ) ? "SRP" : "IPCP",
+										 ( unsigned ) pxResource->uxPriorityCeiling,
+										 ( unsigned ) pxResource->uxPreemptionCeiling );
+
+		for( y = 0; y < uxTaskCount; y++ )
+		{
+			if( ( pxResource->ulUsers & ( 1UL << y ) ) != 0 )
+			{
+				printf( " %s=%.2f", pcTaskGetName( xTasks[ y ].xHandle ), ( double ) pxResource->ulLongestHold[ y ] / ceilingRUN_TIME_UNITS_PER_MS );
+			}
+		}
+
+		printf( "\r\n" );
+	}
+
+	printf( "\r\nTask          Prio  Level     C     T     D     B (ms)      R (ms)\r\n" );
+
+	for( x = 0; x < uxTaskCount; x++ )
+	{
+		ulResponse = ulCeilingGetResponseTime( xTasks[ x ].xHandle );
+
+		printf( "%-12s  %4u  %5u  %4lu  %4lu  %4lu  %9.2f  ", pcTaskGetName( xTasks[ x ].xHandle ),
+															  ( unsigned ) xTasks[ x ].uxPriority,
+															  ( unsigned ) xTasks[ x ].uxPreemptionLevel,
+															  ( unsigned long ) ( xTasks[ x ].ulWcet / ceilingRUN_TIME_UNITS_PER_MS ),
+															  ( unsigned long ) ( xTasks[ x ].ulPeriod / ceilingRUN_TIME_UNITS_PER_MS ),
+															  ( unsigned long ) ( xTasks[ x ].ulDeadline / ceilingRUN_TIME_UNITS_PER_MS ),
+															  ( double ) ulCeilingGetBlockingTime( xTasks[ x ].xHandle ) / ceilingRUN_TIME_UNITS_PER_MS );
+
+		if( ulResponse == 0 )
+		{
+			printf( "DEADLINE MISS\r\n" );
+		}
+		else
+		{
+			printf( "%10.2f\r\n", ( double ) ulResponse / ceilingRUN_TIME_UNITS_PER_MS );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static UBaseType_t prvTaskIndex( TaskHandle_t xTask )
+{
+UBaseType_t x, uxReturn = ceilingUNKNOWN_TASK;
+
+	for( x = 0; ( x < uxTaskCount ) && ( uxReturn == ceilingUNKNOWN_TASK ); x++ )
+	{
+		if( xTasks[ x ].xHandle == xTask )
+		{
+			uxReturn = x;
+		}
+	}
+
+	return uxReturn;
+}
+/*-----------------------------------------------------------*/
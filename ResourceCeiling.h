@@ -0,0 +1,116 @@
+/*
+ * Shared resources protected by a ceiling protocol, with the blocking time
+ * accounting and response time analysis needed to show that every task is
+ * blocked at most once, for at most one critical section.
+ *
+ * Two policies are provided:
+ *
+ * eCeilingImmediate - the immediate priority ceiling protocol.  A resource's
+ * ceiling is the highest priority of any task that declared it uses the
+ * resource.  Taking the resource raises the caller to the ceiling straight
+ * away, so no other user can run until the resource is given back.
+ *
+ * eCeilingStackResource - the stack resource policy.  Each task is given a
+ * preemption level from its relative deadline (the shorter the deadline the
+ * higher the level), and the resource's ceiling is the highest preemption
+ * level of its users.  The ceilings of the resources currently held form the
+ * system ceiling, which an earliest deadline first scheduler uses to decide if
+ * a job may start.  This kernel schedules by fixed priority, so the policy is
+ * enforced by raising the caller to the highest priority of any task whose
+ * preemption level does not exceed the resource's ceiling.
+ *
+ * Ceilings are computed automatically by vCeilingComputeCeilings() from the
+ * declarations made with vCeilingDeclareTask() and vCeilingDeclareUse(), so
+ * they can not get out of step with the code.  Tasks must not block while
+ * holding a resource.
+ */
+
+#ifndef RESOURCE_CEILING_H
+#define RESOURCE_CEILING_H
+
+#include "task.h"
+
+/* The maximum number of tasks and resources that can be declared. */
+#define ceilingMAX_TASKS			( 10 )
+#define ceilingMAX_RESOURCES		( 8 )
+
+/* The run time stats counter counts in 1/100ths of a millisecond - see
+Run-time-stats-utils.c. */
+#define ceilingRUN_TIME_UNITS_PER_MS	( 100UL )
+
+typedef enum
+{
+	eCeilingImmediate = 0,
+	eCeilingStackResource
+} CeilingPolicy_t;
+
+typedef struct xCEILING_RESOURCE CeilingResource_t;
+
+/*
+ * Declare a task that uses, or may be blocked by, resources created with this
+ * module.  The worst case execution time, period (minimum inter-arrival time
+ * for sporadic tasks) and relative deadline are in ticks and are used by the
+ * response time analysis.  The task's priority is read when the ceilings are
+ * computed.
+ */
+void vCeilingDeclareTask( TaskHandle_t xTask, TickType_t xWcet, TickType_t xPeriod, TickType_t xDeadline );
+
+/*
+ * Create a resource using the given policy.  Returns NULL if
+ * ceilingMAX_RESOURCES resources already exist.
+ */
+CeilingResource_t *pxCeilingResourceCreate( const char *pcName, CeilingPolicy_t ePolicy );
+
+/*
+ * Declare that xTask accesses pxResource.  xTask must already have been
+ * declared with vCeilingDeclareTask().
+ */
+void vCeilingDeclareUse( CeilingResource_t *pxResource, TaskHandle_t xTask );
+
+/*
+ * Compute every resource ceiling from the declarations.  Must be called after
+ * all the declarations have been made and before any resource is taken.
+ */
+void vCeilingComputeCeilings( void );
+
+/*
+ * Enter and leave the critical section guarded by pxResource.  Only declared
+ * users may take a resource, and resources must be given back in the reverse
+ * order to which they were taken.
+ */
+void vCeilingResourceTake( CeilingResource_t *pxResource );
+void vCeilingResourceGive( CeilingResource_t *pxResource );
+
+/*
+ * The system ceiling used by the stack resource policy - the highest
+ * preemption level ceiling of any resource currently held, or 0 if none are
+ * held.  xCeilingMayPreempt() returns pdTRUE if a job of xTask is allowed to
+ * start under the stack resource policy.
+ */
+UBaseType_t uxCeilingGetSystemCeiling( void );
+BaseType_t xCeilingMayPreempt( TaskHandle_t xTask );
+
+/*
+ * The worst case blocking time of xTask, in run time stats counter units.
+ * Under both policies a task can be blocked by at most one critical section
+ * of a lower priority task, so this is the longest measured critical section
+ * of any lower priority task on any resource whose ceiling is at least the
+ * priority of xTask.
+ */
+uint32_t ulCeilingGetBlockingTime( TaskHandle_t xTask );
+
+/*
+ * The worst case response time of xTask, in run time stats counter units,
+ * including the measured blocking time.  Returns 0 if the response time
+ * exceeds the task's deadline.
+ */
+uint32_t ulCeilingGetResponseTime( TaskHandle_t xTask );
+
+/*
+ * Print the ceilings, the measured critical section lengths and the response
+ * time analysis of every declared task.  Uses printf() so must only be called
+ * when no other task is writing to the console.
+ */
+void vCeilingPrintAnalysis( void );
+
+#endif /* RESOURCE_CEILING_H */
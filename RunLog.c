@@ -0,0 +1,63 @@
+/*
+ * Run log.  See the comments in RunLog.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdarg.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "RunLog.h"
+
+static FILE *pxLogFile = NULL;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xRunLogOpen( const char *pcFileName )
+{
+BaseType_t xReturn = pdFAIL;
+
+	vRunLogClose();
+	pxLogFile = fopen( pcFileName, "w" );
+
+	if( pxLogFile != NULL )
+	{
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vRunLogPrintf( const char *pcFormat, ... )
+{
+va_list xArguments;
+
+	if( pxLogFile != NULL )
+	{
+		fprintf( pxLogFile, "%10lu ", ( unsigned long ) xTaskGetTickCount() );
+
+		va_start( xArguments, pcFormat );
+		vfprintf( pxLogFile, pcFormat, xArguments );
+		va_end( xArguments );
+
+		/* Flushed line by line so the log survives the process being closed
+		while the scheduler is running. */
+		fputc( '\n', pxLogFile );
+		fflush( pxLogFile );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vRunLogClose( void )
+{
+	if( pxLogFile != NULL )
+	{
+		fclose( pxLogFile );
+		pxLogFile = NULL;
+	}
+}
+/*-----------------------------------------------------------*/
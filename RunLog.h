@@ -0,0 +1,32 @@
+/*
+ * A plain text log of a run, kept in a file next to the executable.
+ *
+ * Each line starts with the tick count at which it was written, so the log
+ * can be lined up with the trace.  It records what is needed to repeat a run,
+ * such as the seeds given to the random number generators.
+ *
+ * None of the functions are thread safe.  Lines written after the scheduler
+ * has started must be serialised by the caller, for example by holding the
+ * resource used for the console.
+ */
+
+#ifndef RUN_LOG_H
+#define RUN_LOG_H
+
+/*
+ * Create, or truncate, pcFileName and direct the log to it.  Returns pdFAIL
+ * if the file could not be created, in which case the log is discarded.
+ */
+BaseType_t xRunLogOpen( const char *pcFileName );
+
+/*
+ * Write a formatted line to the log.  The line ending is added.
+ */
+void vRunLogPrintf( const char *pcFormat, ... );
+
+/*
+ * Flush and close the log file.
+ */
+void vRunLogClose( void );
+
+#endif /* RUN_LOG_H */
@@ -0,0 +1,279 @@
+/*
+ * Timed and budgeted tick hook work.  See the comments in TickWork.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "TickWork.h"
+
+typedef struct xTICK_WORK_TIMES
+{
+	uint32_t ulRuns;
+	uint64_t ullTotal;			/* In performance counter counts. */
+	uint32_t ulMaximum;
+	uint32_t ulHistogram[ tickworkHISTOGRAM_BUCKETS ];
+} TickWorkTimes_t;
+
+typedef struct xTICK_WORK_CALLBACK
+{
+	const char *pcName;
+	TickWorkFunction_t pxFunction;
+	BaseType_t xEveryTick;
+	BaseType_t xHasRun;
+	TickType_t xLastRun;
+	TickType_t xLongestGap;
+	TickWorkTimes_t xTimes;
+} TickWorkCallback_t;
+
+/*
+ * Run pxCallback, record its time and the gap since its previous run, and
+ * return its time in performance counter counts.
+ */
+static uint32_t prvRunCallback( TickWorkCallback_t *pxCallback, TickType_t xNow );
+
+/*
+ * Add one time, in performance counter counts, to pxTimes.
+ */
+static void prvRecordTime( TickWorkTimes_t *pxTimes, uint32_t ulCounts );
+
+/*
+ * Convert performance counter counts to microseconds.
+ */
+static uint64_t prvCountsToMicroseconds( uint64_t ullCounts );
+
+/*
+ * Print one row of the report.
+ */
+static void prvPrintTimes( const char *pcName, const TickWorkTimes_t *pxTimes, const char *pcLongestGap );
+
+/*-----------------------------------------------------------*/
+
+static TickWorkCallback_t xCallbacks[ tickworkMAX_CALLBACKS ];
+static UBaseType_t uxCallbackCount = 0;
+
+/* The callback the round robin of deferrable callbacks resumes from. */
+static UBaseType_t uxNextCallback = 0;
+
+/* The budget of each tick in performance counter counts, or 0 if there is
+none. */
+static uint32_t ulBudgetUs = 0;
+static uint32_t ulBudgetCounts = 0;
+static uint32_t ulTicksOverBudget = 0;
+
+static TickWorkTimes_t xTickTimes;
+static LONGLONG llCountsPerSecond = 0;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xTickWorkRegister( const char *pcName, TickWorkFunction_t pxFunction, BaseType_t xEveryTick )
+{
+TickWorkCallback_t *pxCallback;
+LARGE_INTEGER liFrequency;
+
+	configASSERT( pxFunction );
+
+	if( uxCallbackCount >= tickworkMAX_CALLBACKS )
+	{
+		return pdFAIL;
+	}
+
+	if( llCountsPerSecond == 0 )
+	{
+		QueryPerformanceFrequency( &liFrequency );
+		llCountsPerSecond = liFrequency.QuadPart;
+	}
+
+	pxCallback = &( xCallbacks[ uxCallbackCount ] );
+	pxCallback->pcName = pcName;
+	pxCallback->pxFunction = pxFunction;
+	pxCallback->xEveryTick = xEveryTick;
+	uxCallbackCount++;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vTickWorkSetBudget( uint32_t ulNewBudgetUs )
+{
+LARGE_INTEGER liFrequency;
+
+	if( llCountsPerSecond == 0 )
+	{
+		QueryPerformanceFrequency( &liFrequency );
+		llCountsPerSecond = liFrequency.QuadPart;
+	}
+
+	ulBudgetUs = ulNewBudgetUs;
+	ulBudgetCounts = ( uint32_t ) ( ( ( uint64_t ) ulNewBudgetUs * ( uint64_t ) llCountsPerSecond ) / 1000000ULL );
+
+	/* A budget too short to be measured is still a budget. */
+	if( ( ulNewBudgetUs > 0UL ) && ( ulBudgetCounts == 0UL ) )
+	{
+		ulBudgetCounts = 1UL;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vTickWorkRun( void )
+{
+TickType_t xNow = xTaskGetTickCountFromISR();
+TickWorkCallback_t *pxCallback;
+uint32_t ulTickCounts = 0;
+UBaseType_t x, uxVisited;
+BaseType_t xRanDeferrable = pdFALSE;
+
+	/* The callbacks that must run every tick come first, whatever the
+	budget. */
+	for( x = 0; x < uxCallbackCount; x++ )
+	{
+		if( xCallbacks[ x ].xEveryTick != pdFALSE )
+		{
+			ulTickCounts += prvRunCallback( &( xCallbacks[ x ] ), xNow );
+		}
+	}
+
+	/* Then the deferrable ones, round robin, while they fit in the budget.
+	Without a budget this visits, and runs, every one of them. */
+	for( uxVisited = 0; uxVisited < uxCallbackCount; uxVisited++ )
+	{
+		pxCallback = &( xCallbacks[ uxNextCallback ] );
+
+		if( pxCallback->xEveryTick == pdFALSE )
+		{
+			if( ( ulBudgetCounts != 0UL ) && ( xRanDeferrable != pdFALSE ) &&
+				( ( ulTickCounts + pxCallback->xTimes.ulMaximum ) > ulBudgetCounts ) )
+			{
+				/* This callback is the first to run next tick. */
+				break;
+			}
+
+			ulTickCounts += prvRunCallback( pxCallback, xNow );
+			xRanDeferrable = pdTRUE;
+		}
+
+		uxNextCallback = ( uxNextCallback + 1 ) % uxCallbackCount;
+	}
+
+	prvRecordTime( &xTickTimes, ulTickCounts );
+
+	if( ( ulBudgetCounts != 0UL ) && ( ulTickCounts > ulBudgetCounts ) )
+	{
+		ulTicksOverBudget++;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vTickWorkPrintReport( void )
+{
+char cLongestGap[ 12 ];
+UBaseType_t x;
+
+	printf( "\r\nTick work        Runs  Gap (ticks)  Mean (us)  Max (us)  Histogram (<1 <2 <4 ... us)\r\n" );
+
+	for( x = 0; x < uxCallbackCount; x++ )
+	{
+		if( xCallbacks[ x ].xEveryTick != pdFALSE )
+		{
+			snprintf( cLongestGap, sizeof( cLongestGap ), "every" );
+		}
+		else
+		{
+			snprintf( cLongestGap, sizeof( cLongestGap ), "%lu", ( unsigned long ) xCallbacks[ x ].xLongestGap );
+		}
+
+		prvPrintTimes( xCallbacks[ x ].pcName, &( xCallbacks[ x ].xTimes ), cLongestGap );
+	}
+
+	prvPrintTimes( "Whole tick", &xTickTimes, "-" );
+
+	if( ulBudgetUs != 0UL )
+	{
+		printf( "Budget %lu us per tick, exceeded in %lu of %lu ticks\r\n", ( unsigned long ) ulBudgetUs,
+				( unsigned long ) ulTicksOverBudget, ( unsigned long ) xTickTimes.ulRuns );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvRunCallback( TickWorkCallback_t *pxCallback, TickType_t xNow )
+{
+LARGE_INTEGER liStart, liEnd;
+uint32_t ulCounts;
+
+	QueryPerformanceCounter( &liStart );
+	pxCallback->pxFunction();
+	QueryPerformanceCounter( &liEnd );
+
+	ulCounts = ( uint32_t ) ( liEnd.QuadPart - liStart.QuadPart );
+	prvRecordTime( &( pxCallback->xTimes ), ulCounts );
+
+	if( pxCallback->xHasRun != pdFALSE )
+	{
+		if( ( xNow - pxCallback->xLastRun ) > pxCallback->xLongestGap )
+		{
+			pxCallback->xLongestGap = xNow - pxCallback->xLastRun;
+		}
+	}
+
+	pxCallback->xHasRun = pdTRUE;
+	pxCallback->xLastRun = xNow;
+
+	return ulCounts;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRecordTime( TickWorkTimes_t *pxTimes, uint32_t ulCounts )
+{
+uint64_t ullMicroseconds = prvCountsToMicroseconds( ulCounts );
+UBaseType_t uxBucket = 0;
+
+	pxTimes->ulRuns++;
+	pxTimes->ullTotal += ulCounts;
+
+	if( ulCounts > pxTimes->ulMaximum )
+	{
+		pxTimes->ulMaximum = ulCounts;
+	}
+
+	/* Bucket n holds times below 2^n microseconds. */
+	while( ( ullMicroseconds > 0ULL ) && ( uxBucket < ( tickworkHISTOGRAM_BUCKETS - 1 ) ) )
+	{
+		ullMicroseconds >>= 1;
+		uxBucket++;
+	}
+
+	pxTimes->ulHistogram[ uxBucket ]++;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvCountsToMicroseconds( uint64_t ullCounts )
+{
+	return ( llCountsPerSecond > 0 ) ? ( ( ullCounts * 1000000ULL ) / ( uint64_t ) llCountsPerSecond ) : 0ULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintTimes( const char *pcName, const TickWorkTimes_t *pxTimes, const char *pcLongestGap )
+{
+double dMean = 0.0, dCountsPerMicrosecond = ( double ) llCountsPerSecond / 1000000.0;
+UBaseType_t uxBucket;
+
+	if( pxTimes->ulRuns > 0UL )
+	{
+		dMean = ( ( double ) pxTimes->ullTotal / ( double ) pxTimes->ulRuns ) / dCountsPerMicrosecond;
+	}
+
+	printf( "%-14s  %8lu  %11s  %9.2f  %8.2f ", pcName, ( unsigned long ) pxTimes->ulRuns, pcLongestGap, dMean,
+			( double ) pxTimes->ulMaximum / dCountsPerMicrosecond );
+
+	for( uxBucket = 0; uxBucket < tickworkHISTOGRAM_BUCKETS; uxBucket++ )
+	{
+		printf( " %lu", ( unsigned long ) pxTimes->ulHistogram[ uxBucket ] );
+	}
+
+	printf( "\r\n" );
+}
+/*-----------------------------------------------------------*/
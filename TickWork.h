@@ -0,0 +1,63 @@
+/*
+ * A registry of the work done from the tick hook, which times every piece of
+ * work and can spread it across ticks to bound the time spent in each tick.
+ *
+ * Everything the tick hook does delays every task, as it runs from the tick
+ * interrupt, so it is registered here rather than called directly.  The tick
+ * hook calls vTickWorkRun(), which times each callback with the host
+ * performance counter and keeps a histogram of its execution times, and of
+ * the total time of each tick, so the interference the tick hook causes can
+ * be measured.
+ *
+ * A callback registered to run every tick always runs.  Any other callback is
+ * deferrable: it runs every tick while there is no budget, but with a budget
+ * set by vTickWorkSetBudget() the deferrable callbacks take turns, round
+ * robin.  Each tick runs them from where the previous tick stopped, and stops
+ * before a callback whose longest measured time would take the tick over the
+ * budget.  At least one deferrable callback runs each tick, so each one still
+ * runs at least once every as many ticks as there are deferrable callbacks,
+ * even if the budget is too small for any of them.  The longest gap between
+ * two runs of each callback is recorded so the added latency is known.
+ */
+
+#ifndef TICK_WORK_H
+#define TICK_WORK_H
+
+/* The maximum number of callbacks. */
+#define tickworkMAX_CALLBACKS			( 16 )
+
+/* The execution time histograms have power of two buckets: bucket 0 counts
+times below 1 microsecond, bucket n times from 2^(n-1) up to 2^n
+microseconds, and the last bucket every longer time. */
+#define tickworkHISTOGRAM_BUCKETS		( 12 )
+
+typedef void ( *TickWorkFunction_t )( void );
+
+/*
+ * Register pxFunction to be called from the tick hook, every tick if
+ * xEveryTick is pdTRUE, otherwise as deferrable work.  pcName is only used in
+ * the report.  Must be called before the scheduler is started.  Returns
+ * pdFAIL if tickworkMAX_CALLBACKS callbacks are already registered.
+ */
+BaseType_t xTickWorkRegister( const char *pcName, TickWorkFunction_t pxFunction, BaseType_t xEveryTick );
+
+/*
+ * Limit the time of each tick's callbacks to ulBudgetUs microseconds, or run
+ * every callback every tick if ulBudgetUs is 0, which is the default.
+ */
+void vTickWorkSetBudget( uint32_t ulBudgetUs );
+
+/*
+ * Run the callbacks due this tick.  Called from vApplicationTickHook().
+ */
+void vTickWorkRun( void );
+
+/*
+ * Print the number of runs, the longest gap between runs and the mean,
+ * maximum and histogram of the execution times of every callback, and of the
+ * whole tick.  Uses printf() so must only be called when no other task is
+ * writing to the console.
+ */
+void vTickWorkPrintReport( void );
+
+#endif /* TICK_WORK_H */
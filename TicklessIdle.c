@@ -0,0 +1,92 @@
+/*
+ * Tickless idle for the Win32 simulator.  See the comments in TicklessIdle.h.
+ */
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "TicklessIdle.h"
+
+/* Set to end a sleep early.  Auto reset, so a wake up that arrives while the
+idle task is not sleeping ends the next sleep straight away instead of being
+lost. */
+static HANDLE xWakeEvent = NULL;
+
+/* pdTRUE while the idle task sleeps, or is about to. */
+static volatile BaseType_t xSleeping = pdFALSE;
+
+/* Only written by the idle task. */
+static volatile uint32_t ulSleeps = 0UL;
+static volatile uint32_t ulSleptTicks = 0UL;
+
+/*-----------------------------------------------------------*/
+
+void vTicklessIdleSleep( TickType_t xExpectedIdleTime )
+{
+LARGE_INTEGER liFrequency, liStart, liEnd;
+DWORD ulTimeout;
+
+	if( xWakeEvent == NULL )
+	{
+		xWakeEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+	}
+
+	/* Set before the check below, so a task readied from the tick hook after
+	the check still ends the sleep. */
+	xSleeping = pdTRUE;
+
+	/* A task may have been readied by an interrupt since the kernel decided
+	to sleep. */
+	if( ( xWakeEvent != NULL ) && ( eTaskConfirmSleepModeStatus() != eAbortSleep ) )
+	{
+		/* Wake one tick early, so the tick at which the next task is due is
+		processed with the scheduler running and the task is not released
+		late. */
+		ulTimeout = ( DWORD ) ( ( xExpectedIdleTime - 1UL ) * portTICK_PERIOD_MS );
+
+		QueryPerformanceFrequency( &liFrequency );
+		QueryPerformanceCounter( &liStart );
+		WaitForSingleObject( xWakeEvent, ulTimeout );
+		QueryPerformanceCounter( &liEnd );
+
+		ulSleeps++;
+		ulSleptTicks += ( uint32_t ) ( ( ( liEnd.QuadPart - liStart.QuadPart ) * configTICK_RATE_HZ ) / liFrequency.QuadPart );
+	}
+
+	xSleeping = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vTicklessIdleWake( void )
+{
+	if( xWakeEvent != NULL )
+	{
+		SetEvent( xWakeEvent );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vTicklessIdleWakeIfReady( void )
+{
+	/* While the idle task sleeps the scheduler is suspended, so a task readied
+	from an interrupt is held on the pending ready list, which
+	eTaskConfirmSleepModeStatus() checks. */
+	if( ( xSleeping != pdFALSE ) && ( eTaskConfirmSleepModeStatus() == eAbortSleep ) )
+	{
+		vTicklessIdleWake();
+	}
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTicklessIdleGetSleeps( void )
+{
+	return ulSleeps;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTicklessIdleGetSleptTicks( void )
+{
+	return ulSleptTicks;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,59 @@
+/*
+ * Tickless idle for the Win32 simulator (configUSE_TICKLESS_IDLE = 2).
+ *
+ * Without it the idle task runs continuously whenever no other task is
+ * ready, keeping a host processor busy even while every task is blocked for
+ * seconds.  With it the kernel calls vTicklessIdleSleep() from the idle task,
+ * with the scheduler suspended, when no task is due to unblock for at least
+ * configEXPECTED_IDLE_TIME_BEFORE_SLEEP ticks.  The idle thread then sleeps
+ * on a host event until one tick before the next task is due, until an
+ * interrupt handler calls vTicklessIdleWake(), or until the tick hook calls
+ * vTicklessIdleWakeIfReady() after work that readied a task.
+ *
+ * Only the idle thread sleeps.  The simulated tick interrupt is generated by
+ * a thread inside port.c, which wakes every tick and can not be slowed down or
+ * stopped from the application, so the tick interrupt, and the tick hook, are
+ * still processed every tick while the idle thread sleeps.  Because the
+ * scheduler is suspended the kernel only counts the ticks as pending, and
+ * adds them all to the tick count when the scheduler is resumed, so the tick
+ * count is correct when the idle task wakes.  What is saved is the host
+ * processor time the idle task would spend running between the ticks, not the
+ * ticks themselves.
+ *
+ * The idle thread is never switched out while the scheduler is suspended, so
+ * it is safe for it to block on a Windows object here.
+ */
+
+#ifndef TICKLESS_IDLE_H
+#define TICKLESS_IDLE_H
+
+/*
+ * Called by the kernel through portSUPPRESS_TICKS_AND_SLEEP(), see
+ * FreeRTOSConfig.h.
+ */
+void vTicklessIdleSleep( TickType_t xExpectedIdleTime );
+
+/*
+ * End the current sleep, if any.  Must be called by simulated interrupt
+ * handlers that can unblock a task, as the sleep only ends by itself when the
+ * next blocked task is due.
+ */
+void vTicklessIdleWake( void );
+
+/*
+ * End the current sleep, if any, if a task has been readied since it started.
+ * Called from the tick hook after the work that can ready a task, such as the
+ * callbacks run by vTickWorkRun(), which therefore need not call
+ * vTicklessIdleWake() themselves.
+ */
+void vTicklessIdleWakeIfReady( void );
+
+/*
+ * The number of times the idle task slept, and the number of ticks that
+ * passed while it did.  Those ticks were still processed, with the scheduler
+ * suspended.
+ */
+uint32_t ulTicklessIdleGetSleeps( void );
+uint32_t ulTicklessIdleGetSleptTicks( void );
+
+#endif /* TICKLESS_IDLE_H */
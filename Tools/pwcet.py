@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""Probabilistic WCET estimation from the job times recorded by JobProfiler.c.
+
+Reads the CSV written at the end of a ZigZag session (task,job,cpu_us), splits
+each task's job times into blocks, fits a Gumbel distribution to the block
+maxima by maximum likelihood, and reports the execution time that a job
+exceeds with each of the given probabilities, next to the observed maximum and,
+optionally, the execution time assumed in main.c.  Exits with 1 if an observed
+maximum exceeds the time assumed for its task, or with 2 if a task given with
+--assumed is not in the CSV.
+
+    python Tools/pwcet.py ZigZag_jobs.csv
+    python Tools/pwcet.py ZigZag_jobs.csv --block 50 -p 1e-3 -p 1e-9 \
+        --assumed "Atualiza Display=3" --assumed "Cria Caminho=3"
+
+Only the standard library is used.
+"""
+
+import argparse
+import csv
+import math
+import sys
+from collections import OrderedDict
+
+# Fewer block maxima than this give a fit that is not worth reporting.
+MINIMUM_BLOCKS = 10
+
+
+def read_jobs(path):
+    """Return an ordered mapping of task name to its job times in microseconds."""
+    jobs = OrderedDict()
+    with open(path, newline="") as file:
+        for row in csv.DictReader(file):
+            jobs.setdefault(row["task"], []).append(float(row["cpu_us"]))
+    return jobs
+
+
+def block_maxima(times, block):
+    """Maxima of consecutive blocks of jobs, dropping an incomplete last block."""
+    return [max(times[i:i + block]) for i in range(0, len(times) - block + 1, block)]
+
+
+def fit_gumbel(maxima):
+    """Maximum likelihood location and scale of a Gumbel distribution.
+
+    The scale is the fixed point of
+        beta = mean(x) - sum(x exp(-x / beta)) / sum(exp(-x / beta)),
+    started from the method of moments estimate.  The data are centred and
+    scaled first so the exponentials do not overflow.
+    """
+    n = len(maxima)
+    mean = sum(maxima) / n
+    variance = sum((x - mean) ** 2 for x in maxima) / (n - 1)
+    if variance <= 0.0:
+        return mean, 0.0
+
+    spread = math.sqrt(variance)
+    z = [(x - mean) / spread for x in maxima]
+    beta = math.sqrt(6.0) / math.pi
+
+    for _ in range(200):
+        weights = [math.exp(-v / beta) for v in z]
+        total = sum(weights)
+        next_beta = -sum(v * w for v, w in zip(z, weights)) / total
+        if next_beta <= 0.0:
+            break
+        converged = abs(next_beta - beta) < 1e-10
+        beta = next_beta
+        if converged:
+            break
+
+    weights = [math.exp(-v / beta) for v in z]
+    mu = -beta * math.log(sum(weights) / n)
+    return mean + mu * spread, beta * spread
+
+
+def gumbel_quantile(mu, beta, block_exceedance):
+    """The value a block maximum exceeds with probability block_exceedance."""
+    return mu - beta * math.log(-math.log1p(-block_exceedance))
+
+
+def block_probability(job_exceedance, block):
+    """Probability that at least one of block jobs exceeds a value that each
+    job exceeds with probability job_exceedance."""
+    return -math.expm1(block * math.log1p(-job_exceedance))
+
+
+def parse_assumed(values):
+    assumed = {}
+    for value in values:
+        name, _, milliseconds = value.rpartition("=")
+        if not name:
+            raise argparse.ArgumentTypeError("--assumed expects TASK=MS, got %r" % value)
+        assumed[name] = float(milliseconds)
+    return assumed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("csv", help="job times written by the ZigZag session")
+    parser.add_argument("--block", type=int, default=50,
+                        help="jobs per block for the block maxima (default 50)")
+    parser.add_argument("-p", "--probability", type=float, action="append",
+                        help="per job exceedance probability, may be repeated "
+                             "(default 1e-3, 1e-6, 1e-9)")
+    parser.add_argument("--assumed", action="append", default=[],
+                        help="execution time assumed for a task, as TASK=MS")
+    args = parser.parse_args()
+
+    probabilities = args.probability or [1e-3, 1e-6, 1e-9]
+    assumed = parse_assumed(args.assumed)
+    jobs = read_jobs(args.csv)
+
+    # A name that matches no task would otherwise skip its comparison silently.
+    unknown = [task for task in assumed if task not in jobs]
+    for task in unknown:
+        print("--assumed task %r is not in %s, which has: %s" % (task, args.csv, ", ".join(jobs)),
+              file=sys.stderr)
+    if unknown:
+        return 2
+
+    header = "%-20s %7s %10s %10s" % ("Task", "Jobs", "Mean (ms)", "Max (ms)")
+    header += "".join(" %12s" % ("p=%g" % p) for p in probabilities)
+    header += " %12s" % "Assumed (ms)"
+    print(header)
+
+    status = 0
+    for task, times in jobs.items():
+        line = "%-20s %7d %10.3f %10.3f" % (task, len(times), sum(times) / len(times) / 1000.0,
+                                             max(times) / 1000.0)
+        maxima = block_maxima(times, args.block)
+
+        if len(maxima) < MINIMUM_BLOCKS:
+            line += "".join(" %12s" % "too few" for _ in probabilities)
+        else:
+            mu, beta = fit_gumbel(maxima)
+            for p in probabilities:
+                pwcet = gumbel_quantile(mu, beta, block_probability(p, args.block))
+                # The fit can not be trusted below what was actually observed.
+                line += " %12.3f" % (max(pwcet, max(times)) / 1000.0)
+
+        if task in assumed:
+            line += " %12.3f" % assumed[task]
+            if max(times) / 1000.0 > assumed[task]:
+                line += "  OBSERVED MAX EXCEEDS ASSUMED"
+                status = 1
+        print(line)
+
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Decode the compressed trace snapshots written by TraceSnapshot.c.
+
+Each .trcz file, in the format described in TraceCompress.h, is decoded back
+into the recorder data it was made from, checked against the length and hash
+in its header, and written next to it with the extension .dump, which opens in
+Tracealyzer like the dump written on an assertion.
+
+    python Tools/trcz.py ZigZag_trace_20260101_120000_000_prazo.trcz
+    python Tools/trcz.py ZigZag_trace_*.trcz
+    python Tools/trcz.py snapshot.trcz -o snapshot.dump
+
+Only the standard library is used.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"TRCZ"
+VERSION = 1
+HEADER = struct.Struct("<4sB3xII")
+
+LITERALS = 0x00
+ZEROS = 0x01
+MATCH = 0x02
+
+
+class FormatError(Exception):
+    """The file is not a valid compressed dump."""
+
+
+def fnv1a(data):
+    """The 32 bit FNV-1a hash of data, as the recorder computes it."""
+    value = 2166136261
+    for byte in data:
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def read_length(data, position):
+    """Return a LEB128 length starting at position and the position after it."""
+    value = 0
+    shift = 0
+    while True:
+        if position >= len(data):
+            raise FormatError("truncated length")
+        byte = data[position]
+        position += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, position
+
+
+def decode(data):
+    """Return the recorder data coded in the contents of a .trcz file."""
+    if len(data) < HEADER.size:
+        raise FormatError("too short for the header")
+    magic, version, length, expected_hash = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise FormatError("not a compressed trace dump")
+    if version != VERSION:
+        raise FormatError("format version %d is not supported" % version)
+
+    output = bytearray()
+    position = HEADER.size
+    while position < len(data):
+        tag = data[position]
+        count, position = read_length(data, position + 1)
+        if tag == LITERALS:
+            if position + count > len(data):
+                raise FormatError("truncated literal run")
+            output += data[position:position + count]
+            position += count
+        elif tag == ZEROS:
+            output += bytes(count)
+        elif tag == MATCH:
+            offset, position = read_length(data, position)
+            if offset == 0 or offset > len(output):
+                raise FormatError("match offset %d outside the data" % offset)
+            start = len(output) - offset
+            # A match can overlap the bytes it produces, so is copied a byte at
+            # a time when it does.
+            if offset >= count:
+                output += output[start:start + count]
+            else:
+                for index in range(count):
+                    output.append(output[start + index])
+        else:
+            raise FormatError("unknown item 0x%02x" % tag)
+        if len(output) > length:
+            raise FormatError("longer than the %d bytes in the header" % length)
+
+    if len(output) != length:
+        raise FormatError("%d bytes decoded, the header gives %d" % (len(output), length))
+    if fnv1a(output) != expected_hash:
+        raise FormatError("hash does not match, the file is corrupt")
+    return bytes(output)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("files", nargs="+", help=".trcz files written by TraceSnapshot.c")
+    parser.add_argument("-o", "--output",
+                        help="file to write, only with a single input "
+                             "(default: the input with the extension .dump)")
+    args = parser.parse_args()
+
+    if args.output and len(args.files) > 1:
+        parser.error("--output can only be given with a single file")
+
+    status = 0
+    for path in args.files:
+        with open(path, "rb") as file:
+            data = file.read()
+        try:
+            dump = decode(data)
+        except FormatError as error:
+            print("%s: %s" % (path, error), file=sys.stderr)
+            status = 1
+            continue
+
+        output = args.output or os.path.splitext(path)[0] + ".dump"
+        with open(output, "wb") as file:
+            file.write(dump)
+        print("%s -> %s  %d -> %d bytes (%.1f%%)" % (path, output, len(data), len(dump),
+                                                     100.0 * len(data) / max(len(dump), 1)))
+
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
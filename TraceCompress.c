@@ -0,0 +1,247 @@
+/*
+ * Compact trace recorder dumps.  See the comments in TraceCompress.h.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+
+#include "TraceCompress.h"
+
+/* The item tags. */
+#define tracecompressLITERALS			( 0x00 )
+#define tracecompressZEROS				( 0x01 )
+#define tracecompressMATCH				( 0x02 )
+
+/* Shorter zero runs and matches cost more to code than the literals they
+replace, so are left as literals. */
+#define tracecompressMIN_ZEROS			( 8 )
+#define tracecompressMIN_MATCH			( 8 )
+
+/* The hash table holds the last position of 2^tracecompressHASH_BITS hashes
+of four bytes. */
+#define tracecompressHASH_BITS			( 12 )
+#define tracecompressHASH_SIZE			( 1UL << tracecompressHASH_BITS )
+
+typedef struct xTRACE_COMPRESS_OUTPUT
+{
+	uint8_t *pucData;
+	size_t xLength;
+	size_t xCapacity;
+	BaseType_t xOverflow;				/* Set once a byte did not fit. */
+} TraceCompressOutput_t;
+
+/*
+ * Append ucByte, xCount bytes, or a LEB128 coded length to pxOutput.
+ */
+static void prvPutByte( TraceCompressOutput_t *pxOutput, uint8_t ucByte );
+static void prvPutBytes( TraceCompressOutput_t *pxOutput, const uint8_t *pucBytes, size_t xCount );
+static void prvPutLength( TraceCompressOutput_t *pxOutput, size_t xLength );
+
+/*
+ * Append a literal run of the xCount bytes at pucBytes, if there are any.
+ */
+static void prvPutLiterals( TraceCompressOutput_t *pxOutput, const uint8_t *pucBytes, size_t xCount );
+
+/*
+ * Append the header, then either the coded items of the xLength bytes at
+ * pucSource, or, if xUseMatches is pdFALSE, a single literal run of them.
+ */
+static void prvCompress( TraceCompressOutput_t *pxOutput, const uint8_t *pucSource, size_t xLength, BaseType_t xUseMatches );
+
+/*
+ * The hash of the four bytes at pucBytes, and the FNV-1a hash of xLength
+ * bytes, which the decoder checks.
+ */
+static uint32_t prvHashFour( const uint8_t *pucBytes );
+static uint32_t prvFnv1a( const uint8_t *pucBytes, size_t xLength );
+
+/*-----------------------------------------------------------*/
+
+size_t xTraceCompress( const uint8_t *pucSource, size_t xLength, uint8_t *pucDestination, size_t xCapacity )
+{
+TraceCompressOutput_t xOutput;
+
+	configASSERT( pucSource );
+	configASSERT( pucDestination );
+
+	xOutput.pucData = pucDestination;
+	xOutput.xCapacity = xCapacity;
+	prvCompress( &xOutput, pucSource, xLength, pdTRUE );
+
+	if( xOutput.xOverflow != pdFALSE )
+	{
+		/* Splitting the literals around the zero runs and matches can cost
+		a few bytes more than it saves on data that hardly repeats, so fall
+		back to the size tracecompressBOUND() allows for. */
+		prvCompress( &xOutput, pucSource, xLength, pdFALSE );
+	}
+
+	return ( xOutput.xOverflow != pdFALSE ) ? 0 : xOutput.xLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvCompress( TraceCompressOutput_t *pxOutput, const uint8_t *pucSource, size_t xLength, BaseType_t xUseMatches )
+{
+uint32_t ulTable[ tracecompressHASH_SIZE ];	/* Position + 1, or 0 if none. */
+uint32_t ulHash, ulValue;
+size_t x = 0, xLiterals = 0, xRun, xCandidate;
+UBaseType_t uxByte;
+
+	pxOutput->xLength = 0;
+	pxOutput->xOverflow = pdFALSE;
+
+	/* The header. */
+	prvPutBytes( pxOutput, ( const uint8_t * ) "TRCZ", 4 );
+	prvPutByte( pxOutput, tracecompressVERSION );
+	prvPutBytes( pxOutput, ( const uint8_t * ) "\0\0\0", 3 );
+
+	for( uxByte = 0; uxByte < 2; uxByte++ )
+	{
+		ulValue = ( uxByte == 0 ) ? ( uint32_t ) xLength : prvFnv1a( pucSource, xLength );
+		prvPutByte( pxOutput, ( uint8_t ) ulValue );
+		prvPutByte( pxOutput, ( uint8_t ) ( ulValue >> 8 ) );
+		prvPutByte( pxOutput, ( uint8_t ) ( ulValue >> 16 ) );
+		prvPutByte( pxOutput, ( uint8_t ) ( ulValue >> 24 ) );
+	}
+
+	if( xUseMatches == pdFALSE )
+	{
+		prvPutLiterals( pxOutput, pucSource, xLength );
+		return;
+	}
+
+	memset( ulTable, 0, sizeof( ulTable ) );
+
+	while( ( x < xLength ) && ( pxOutput->xOverflow == pdFALSE ) )
+	{
+		if( pucSource[ x ] == 0U )
+		{
+			for( xRun = 1; ( ( x + xRun ) < xLength ) && ( pucSource[ x + xRun ] == 0U ); xRun++ )
+			{
+			}
+
+			if( xRun >= tracecompressMIN_ZEROS )
+			{
+				prvPutLiterals( pxOutput, &( pucSource[ xLiterals ] ), x - xLiterals );
+				prvPutByte( pxOutput, tracecompressZEROS );
+				prvPutLength( pxOutput, xRun );
+				x += xRun;
+				xLiterals = x;
+				continue;
+			}
+		}
+
+		if( ( x + 4 ) <= xLength )
+		{
+			ulHash = prvHashFour( &( pucSource[ x ] ) );
+			xCandidate = ( size_t ) ulTable[ ulHash ];
+			ulTable[ ulHash ] = ( uint32_t ) ( x + 1 );
+
+			if( ( xCandidate != 0 ) && ( ( x - ( xCandidate - 1 ) ) <= tracecompressWINDOW ) )
+			{
+				xCandidate--;
+
+				for( xRun = 0; ( ( x + xRun ) < xLength ) && ( pucSource[ xCandidate + xRun ] == pucSource[ x + xRun ] ); xRun++ )
+				{
+				}
+
+				if( xRun >= tracecompressMIN_MATCH )
+				{
+					prvPutLiterals( pxOutput, &( pucSource[ xLiterals ] ), x - xLiterals );
+					prvPutByte( pxOutput, tracecompressMATCH );
+					prvPutLength( pxOutput, xRun );
+					prvPutLength( pxOutput, x - xCandidate );
+					x += xRun;
+					xLiterals = x;
+					continue;
+				}
+			}
+		}
+
+		x++;
+	}
+
+	prvPutLiterals( pxOutput, &( pucSource[ xLiterals ] ), xLength - xLiterals );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutByte( TraceCompressOutput_t *pxOutput, uint8_t ucByte )
+{
+	if( pxOutput->xLength < pxOutput->xCapacity )
+	{
+		pxOutput->pucData[ pxOutput->xLength ] = ucByte;
+		pxOutput->xLength++;
+	}
+	else
+	{
+		pxOutput->xOverflow = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutBytes( TraceCompressOutput_t *pxOutput, const uint8_t *pucBytes, size_t xCount )
+{
+	if( ( pxOutput->xCapacity - pxOutput->xLength ) >= xCount )
+	{
+		memcpy( &( pxOutput->pucData[ pxOutput->xLength ] ), pucBytes, xCount );
+		pxOutput->xLength += xCount;
+	}
+	else
+	{
+		pxOutput->xOverflow = pdTRUE;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutLength( TraceCompressOutput_t *pxOutput, size_t xLength )
+{
+	while( xLength >= 0x80U )
+	{
+		prvPutByte( pxOutput, ( uint8_t ) ( ( xLength & 0x7FU ) | 0x80U ) );
+		xLength >>= 7;
+	}
+
+	prvPutByte( pxOutput, ( uint8_t ) xLength );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutLiterals( TraceCompressOutput_t *pxOutput, const uint8_t *pucBytes, size_t xCount )
+{
+	if( xCount > 0 )
+	{
+		prvPutByte( pxOutput, tracecompressLITERALS );
+		prvPutLength( pxOutput, xCount );
+		prvPutBytes( pxOutput, pucBytes, xCount );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvHashFour( const uint8_t *pucBytes )
+{
+uint32_t ulValue;
+
+	ulValue = ( uint32_t ) pucBytes[ 0 ] | ( ( uint32_t ) pucBytes[ 1 ] << 8 ) |
+			  ( ( uint32_t ) pucBytes[ 2 ] << 16 ) | ( ( uint32_t ) pucBytes[ 3 ] << 24 );
+
+	/* Knuth's multiplicative hash. */
+	return ( uint32_t ) ( ulValue * 2654435761UL ) >> ( 32 - tracecompressHASH_BITS );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvFnv1a( const uint8_t *pucBytes, size_t xLength )
+{
+uint32_t ulHash = 2166136261UL;
+size_t x;
+
+	for( x = 0; x < xLength; x++ )
+	{
+		ulHash ^= pucBytes[ x ];
+		ulHash = ( uint32_t ) ( ulHash * 16777619UL );
+	}
+
+	return ulHash;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,55 @@
+/*
+ * A compact, lossless format for trace recorder dumps.
+ *
+ * The recorder data is sized for the worst case - 15000 events, a symbol
+ * table of 5000 bytes and object tables for 150 tasks and 250 timers - and a
+ * dump holds all of it, although most of the tables, and the events not yet
+ * written, are zero.  This format codes the dump as a sequence of:
+ *
+ * - zero runs, so the empty object entries, symbol table and events cost a
+ *   few bytes each whatever their size;
+ * - matches, which repeat bytes found up to tracecompressWINDOW bytes
+ *   earlier, so the events of a task that runs in a loop, which repeat with
+ *   the same delta timestamps, are stored once;
+ * - literals, for everything else.
+ *
+ * Matches are found with a single hash table lookup per position, as in LZ4,
+ * so compressing a dump takes about as long as copying it a few times.
+ *
+ * The file starts with a header of tracecompressHEADER_SIZE bytes: the
+ * characters "TRCZ", the format version, three reserved bytes, then the
+ * length of the original dump and its 32 bit FNV-1a hash, both little endian.
+ * Each item after the header is a tag byte followed by lengths coded in
+ * LEB128, 7 bits per byte, least significant first:
+ *
+ *   0x00 length bytes	- a literal run, followed by its bytes;
+ *   0x01 length		- a zero run;
+ *   0x02 length offset	- a match of length bytes starting offset bytes back.
+ *
+ * Tools/trcz.py decodes the files back into the original dump, which opens in
+ * Tracealyzer.
+ */
+
+#ifndef TRACE_COMPRESS_H
+#define TRACE_COMPRESS_H
+
+#define tracecompressVERSION			( 1 )
+#define tracecompressHEADER_SIZE		( 16 )
+
+/* The furthest back a match can start. */
+#define tracecompressWINDOW				( 65536UL )
+
+/* The largest a dump of xLength bytes can become, when nothing in it repeats:
+the header and the tag and length of a single literal run. */
+#define tracecompressBOUND( xLength )	( ( xLength ) + tracecompressHEADER_SIZE + 6 )
+
+/*
+ * Compress the xLength bytes at pucSource into pucDestination, which has
+ * room for xCapacity bytes.  Returns the length of the compressed data, or 0
+ * if it did not fit, which can not happen if xCapacity is at least
+ * tracecompressBOUND( xLength ).  Uses about 16 KB of stack for its hash
+ * table, so is meant to be called from a host thread rather than a task.
+ */
+size_t xTraceCompress( const uint8_t *pucSource, size_t xLength, uint8_t *pucDestination, size_t xCapacity );
+
+#endif /* TRACE_COMPRESS_H */
@@ -0,0 +1,102 @@
+/*
+ * Runtime filtering of the trace recorder's events.  See the comments in
+ * TraceFilter.h.
+ */
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+
+#include "TraceFilter.h"
+
+/*
+ * Move every task to tracefilterGROUP_SCHEDULING.
+ */
+static void prvMoveTasksToSchedulingGroup( void );
+
+/*-----------------------------------------------------------*/
+
+volatile uint32_t ulTraceFilterClasses = tracefilterALL_CLASSES;
+
+volatile BaseType_t xTraceFilterSchedulingOnly = pdFALSE;
+static TaskStatus_t xTaskStatus[ tracefilterMAX_TASKS ];
+
+/*-----------------------------------------------------------*/
+
+void vTraceFilterSetClasses( uint32_t ulClasses )
+{
+	ulTraceFilterClasses = ulClasses & tracefilterALL_CLASSES;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTraceFilterGetClasses( void )
+{
+	return ulTraceFilterClasses;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceFilterSetTaskGroup( void *xTask, uint16_t usGroup )
+{
+	configASSERT( xTask );
+
+	taskENTER_CRITICAL();
+	{
+		vTaskSetTaskNumber( ( TaskHandle_t ) xTask, ( uxTaskGetTaskNumber( ( TaskHandle_t ) xTask ) & tracefilterHANDLE_MASK ) |
+							( ( UBaseType_t ) usGroup << tracefilterGROUP_SHIFT ) );
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vTraceFilterSetQueueGroup( void *xQueue, uint16_t usGroup )
+{
+	configASSERT( xQueue );
+
+	taskENTER_CRITICAL();
+	{
+		vQueueSetQueueNumber( ( QueueHandle_t ) xQueue, ( uxQueueGetQueueNumber( ( QueueHandle_t ) xQueue ) & tracefilterHANDLE_MASK ) |
+							  ( ( UBaseType_t ) usGroup << tracefilterGROUP_SHIFT ) );
+	}
+	taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+void vTraceFilterSetGroups( uint16_t usGroups )
+{
+	vTraceSetFilterMask( usGroups );
+}
+/*-----------------------------------------------------------*/
+
+void vTraceFilterSchedulingOnly( void )
+{
+	vTraceFilterSetClasses( 0UL );
+	prvMoveTasksToSchedulingGroup();
+	vTraceFilterSetGroups( tracefilterGROUP_SCHEDULING );
+	xTraceFilterSchedulingOnly = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceFilterAll( void )
+{
+	xTraceFilterSchedulingOnly = pdFALSE;
+	vTraceFilterSetGroups( tracefilterALL_GROUPS );
+	vTraceFilterSetClasses( tracefilterALL_CLASSES );
+}
+/*-----------------------------------------------------------*/
+
+static void prvMoveTasksToSchedulingGroup( void )
+{
+UBaseType_t x, uxTasks;
+
+	uxTasks = uxTaskGetSystemState( xTaskStatus, tracefilterMAX_TASKS, NULL );
+
+	/* uxTaskGetSystemState() returns 0 if there are more tasks than fit. */
+	configASSERT( uxTasks > 0 );
+
+	for( x = 0; x < uxTasks; x++ )
+	{
+		vTraceFilterSetTaskGroup( xTaskStatus[ x ].xHandle, tracefilterGROUP_SCHEDULING );
+	}
+}
+/*-----------------------------------------------------------*/
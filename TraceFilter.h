@@ -0,0 +1,118 @@
+/*
+ * Runtime filtering of the events the trace recorder stores.
+ *
+ * trcSnapshotConfig.h compiles every class of event into the recorder, and
+ * storing an event takes a critical section and a slot of the event buffer,
+ * so a trace left running costs processor time and fills the buffer with
+ * events that may not be of interest.  This filter turns the classes on and
+ * off at runtime instead, without rebuilding.
+ *
+ * The OS tick, ready and memory management events are stored by the kernel's
+ * trace macros, which FreeRTOSConfig.h redefines to test the enabled classes
+ * before calling into the recorder.  The test is one load and one branch.
+ * ISR and user events are stored by the application, which must use the
+ * tracefilter macros below rather than call the recorder directly - the
+ * simulated interrupt handlers of HiResTimer.c, IrqLatency.c and
+ * TraceSnapshot.c do.  The classes must only be changed from a task, so an
+ * ISR event is never begun with the class enabled and ended with it disabled.
+ *
+ * Task switches and kernel calls are filtered by the recorder itself, with
+ * its filter groups: each task and kernel object belongs to a group, and
+ * their events are only stored while the group is in the filter mask.  The
+ * recorder puts objects in a group when they are created, and this module
+ * moves them at runtime.  vTraceFilterSchedulingOnly() moves every task to
+ * tracefilterGROUP_SCHEDULING, a group no object is created in, and keeps only
+ * that group in the mask, so only scheduling events are stored.  Tasks
+ * created afterwards are moved as the kernel makes them ready for the first
+ * time, which it does when it creates them, by tracefilterTASK_READY().
+ */
+
+#ifndef TRACE_FILTER_H
+#define TRACE_FILTER_H
+
+/* The event classes. */
+#define tracefilterOS_TICK				( 0x01UL )
+#define tracefilterREADY				( 0x02UL )
+#define tracefilterMEMORY				( 0x04UL )
+#define tracefilterISR					( 0x08UL )
+#define tracefilterUSER					( 0x10UL )
+#define tracefilterALL_CLASSES			( 0x1FUL )
+
+/* The recorder's filter groups are bits of a 16 bit mask.  Objects are
+created in tracefilterGROUP_DEFAULT unless vTraceSetFilterGroup() was called
+with another group. */
+#define tracefilterGROUP_DEFAULT		( ( uint16_t ) 0x0001 )
+#define tracefilterGROUP_SCHEDULING		( ( uint16_t ) 0x8000 )
+#define tracefilterALL_GROUPS			( ( uint16_t ) 0xFFFF )
+
+/* The recorder keeps the handle of a task or queue in the low 16 bits of its
+task or queue number, and its filter group in the high 16 bits. */
+#define tracefilterHANDLE_MASK			( ( UBaseType_t ) 0xFFFF )
+#define tracefilterGROUP_SHIFT			( 16 )
+
+/* The most tasks vTraceFilterSchedulingOnly() can move. */
+#define tracefilterMAX_TASKS			( 128 )
+
+/* The enabled classes.  Only read through tracefilterENABLED(). */
+extern volatile uint32_t ulTraceFilterClasses;
+
+/* pdTRUE while only scheduling events are stored.  Only read through
+tracefilterTASK_READY(). */
+extern volatile BaseType_t xTraceFilterSchedulingOnly;
+
+/* pdTRUE if the events of ulClass are stored. */
+#define tracefilterENABLED( ulClass )	( ( ulTraceFilterClasses & ( ulClass ) ) != 0UL )
+
+/* The recorder's user event and ISR functions, behind the filter. */
+#define tracefilterPRINT( xChannel, pcString )	if( tracefilterENABLED( tracefilterUSER ) ) { vTracePrint( ( xChannel ), ( pcString ) ); }
+#define tracefilterPRINTF( xChannel, ... )		if( tracefilterENABLED( tracefilterUSER ) ) { vTracePrintF( ( xChannel ), __VA_ARGS__ ); }
+#define tracefilterISR_BEGIN( xHandle )			if( tracefilterENABLED( tracefilterISR ) ) { vTraceStoreISRBegin( ( xHandle ) ); }
+#define tracefilterISR_END( xPendingSwitch )	if( tracefilterENABLED( tracefilterISR ) ) { vTraceStoreISREnd( ( xPendingSwitch ) ); }
+
+/* Move the task pxTCB to tracefilterGROUP_SCHEDULING, if it is not in it yet
+while only scheduling events are stored.  Expanded by traceMOVED_TASK_TO_
+READY_STATE() in tasks.c, where the TCB is in scope and the ready lists are
+locked, so a new task is moved before it can first run. */
+#define tracefilterTASK_READY( pxTCB )																\
+	if( ( xTraceFilterSchedulingOnly != pdFALSE ) &&												\
+		( ( ( pxTCB )->uxTaskNumber >> tracefilterGROUP_SHIFT ) != tracefilterGROUP_SCHEDULING ) )	\
+	{																								\
+		( pxTCB )->uxTaskNumber = ( ( pxTCB )->uxTaskNumber & tracefilterHANDLE_MASK ) |			\
+								  ( ( UBaseType_t ) tracefilterGROUP_SCHEDULING << tracefilterGROUP_SHIFT );	\
+	}
+
+/*
+ * Store only the events of the classes in ulClasses, a combination of the
+ * tracefilter class bits.  All of them are stored until this is called.
+ */
+void vTraceFilterSetClasses( uint32_t ulClasses );
+uint32_t ulTraceFilterGetClasses( void );
+
+/*
+ * Move the task xTask, or the queue, semaphore or mutex xQueue, to usGroup,
+ * one of the recorder's filter group bits.  This header is included from
+ * FreeRTOSConfig.h, before the handle types are defined, so the handles are
+ * passed as void pointers, as they are defined in this version.
+ */
+void vTraceFilterSetTaskGroup( void *xTask, uint16_t usGroup );
+void vTraceFilterSetQueueGroup( void *xQueue, uint16_t usGroup );
+
+/*
+ * Store only the task switches and kernel calls of the objects in the groups
+ * of usGroups.  All of them are stored until this is called.
+ */
+void vTraceFilterSetGroups( uint16_t usGroups );
+
+/*
+ * Store only scheduling events: no event class, and only the task switches
+ * and task calls of tracefilterGROUP_SCHEDULING, which every task is moved to.
+ */
+void vTraceFilterSchedulingOnly( void );
+
+/*
+ * Store every event of every object again.  Tasks stay in
+ * tracefilterGROUP_SCHEDULING.
+ */
+void vTraceFilterAll( void );
+
+#endif /* TRACE_FILTER_H */
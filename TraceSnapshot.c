@@ -0,0 +1,402 @@
+/*
+ * Snapshots of the trace recorder's buffer.  See the comments in
+ * TraceSnapshot.h.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "TraceSnapshot.h"
+#include "TraceCompress.h"
+#include "TraceFilter.h"
+
+/* The reason given to snapshots requested with Ctrl+Break. */
+#define tracesnapshotBREAK_REASON			"break"
+
+/*
+ * The host thread that writes each snapshot to a file.
+ */
+static DWORD WINAPI prvWriterThread( LPVOID lpParameter );
+
+/*
+ * Called by Windows, in a thread of its own, when a console control event
+ * such as Ctrl+Break is received.
+ */
+static BOOL WINAPI prvConsoleHandler( DWORD dwCtrlType );
+
+/*
+ * The simulated interrupt handler that takes the snapshots requested with
+ * Ctrl+Break.
+ */
+static uint32_t prvBreakInterruptHandler( void );
+
+/*
+ * Copy the recorder data into the snapshot buffer, if it is free, and wake
+ * the writer.  Must be called with interrupts masked.
+ */
+static BaseType_t prvTakeSnapshot( const char *pcReason );
+
+/*
+ * Add the files left with the same base name by earlier runs to the files
+ * kept, in order, deleting the oldest of them if there are too many.
+ */
+static void prvAddExistingFiles( void );
+
+/*-----------------------------------------------------------*/
+
+/* The copy of the recorder data, and what is known about it. */
+static RecorderDataType xSnapshot;
+static const char *pcSnapshotReason = NULL;
+static SYSTEMTIME xSnapshotTime;
+
+#if( tracesnapshotCOMPRESS == 1 )
+	/* The compressed copy, only used by the writer. */
+	static uint8_t ucCompressed[ tracecompressBOUND( sizeof( RecorderDataType ) ) ];
+#endif
+
+/* 1 from the moment a snapshot is copied until it has been written.  Shared
+with the writer, which is not a FreeRTOS task and can not enter a critical
+section, so accessed with interlocked functions. */
+static volatile LONG lSnapshotHeld = 0;
+
+/* Signalled when a snapshot is ready to be written. */
+static HANDLE xSnapshotEvent = NULL;
+
+/* The files kept, oldest first.  The names start with the local time, so
+that is also their order by name. */
+static char cBaseName[ tracesnapshotMAX_NAME_LENGTH ];
+static char cFileNames[ tracesnapshotMAX_FILES ][ tracesnapshotMAX_NAME_LENGTH ];
+static UBaseType_t uxMaxFiles = 0, uxFileCount = 0;
+
+static volatile uint32_t ulWritten = 0;
+
+/* Counted by both the tasks and the writer. */
+static volatile LONG lDropped = 0;
+
+/* The longest copy of the recorder data, in performance counter counts, and
+the frequency of the counter. */
+static uint32_t ulLongestCopy = 0;
+static LARGE_INTEGER liCounterFrequency;
+
+/* The Ctrl+Break interrupt, as the trace recorder knows it. */
+static traceHandle xTraceISR;
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xTraceSnapshotInitialise( const char *pcBaseName, UBaseType_t uxFiles )
+{
+HANDLE xThread;
+
+	configASSERT( pcBaseName );
+	configASSERT( ( uxFiles > 0 ) && ( uxFiles <= tracesnapshotMAX_FILES ) );
+
+	snprintf( cBaseName, sizeof( cBaseName ), "%s", pcBaseName );
+	uxMaxFiles = uxFiles;
+	prvAddExistingFiles();
+
+	QueryPerformanceFrequency( &liCounterFrequency );
+
+	xSnapshotEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+
+	if( xSnapshotEvent == NULL )
+	{
+		return pdFAIL;
+	}
+
+	xThread = CreateThread( NULL, 0, prvWriterThread, NULL, 0, NULL );
+
+	if( xThread == NULL )
+	{
+		return pdFAIL;
+	}
+
+	/* The writer is background work.  port.c runs the threads of the tasks
+	at THREAD_PRIORITY_IDLE, the lowest priority, so the writer can not run
+	below them, but at the same priority it only takes turns with the running
+	task rather than preempting it. */
+	SetThreadPriority( xThread, THREAD_PRIORITY_IDLE );
+
+	xTraceISR = xTraceSetISRProperties( "SnapshotBreak", tracesnapshotINTERRUPT_NUMBER );
+	vPortSetInterruptHandler( tracesnapshotINTERRUPT_NUMBER, prvBreakInterruptHandler );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vTraceSnapshotEnableBreak( void )
+{
+	/* The console handler generates a simulated interrupt, which port.c only
+	accepts once the scheduler is running. */
+	configASSERT( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED );
+
+	SetConsoleCtrlHandler( prvConsoleHandler, TRUE );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTraceSnapshotRequest( const char *pcReason )
+{
+BaseType_t xReturn;
+
+	taskENTER_CRITICAL();
+	{
+		xReturn = prvTakeSnapshot( pcReason );
+	}
+	taskEXIT_CRITICAL();
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTraceSnapshotRequestFromISR( const char *pcReason )
+{
+BaseType_t xReturn;
+UBaseType_t uxSavedInterruptStatus;
+
+	uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	{
+		xReturn = prvTakeSnapshot( pcReason );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTraceSnapshotGetWritten( void )
+{
+	return ulWritten;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTraceSnapshotGetDropped( void )
+{
+	return ( uint32_t ) lDropped;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulTraceSnapshotGetLongestCopyUs( void )
+{
+	if( liCounterFrequency.QuadPart == 0 )
+	{
+		return 0;
+	}
+
+	return ( uint32_t ) ( ( ( uint64_t ) ulLongestCopy * 1000000ULL ) / ( uint64_t ) liCounterFrequency.QuadPart );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvTakeSnapshot( const char *pcReason )
+{
+LARGE_INTEGER liStart, liEnd;
+
+	if( ( RecorderDataPtr == NULL ) || ( xSnapshotEvent == NULL ) ||
+		( InterlockedCompareExchange( &lSnapshotHeld, 1, 0 ) != 0 ) )
+	{
+		InterlockedIncrement( &lDropped );
+		return pdFAIL;
+	}
+
+	/* The recorder only stores events with interrupts masked, so the copy is
+	consistent.  It is timed, as it is the time the snapshot keeps them
+	masked. */
+	QueryPerformanceCounter( &liStart );
+	memcpy( &xSnapshot, RecorderDataPtr, sizeof( xSnapshot ) );
+	QueryPerformanceCounter( &liEnd );
+
+	if( ( uint32_t ) ( liEnd.QuadPart - liStart.QuadPart ) > ulLongestCopy )
+	{
+		ulLongestCopy = ( uint32_t ) ( liEnd.QuadPart - liStart.QuadPart );
+	}
+
+	pcSnapshotReason = pcReason;
+	GetLocalTime( &xSnapshotTime );
+	SetEvent( xSnapshotEvent );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static DWORD WINAPI prvWriterThread( LPVOID lpParameter )
+{
+HANDLE xFile;
+DWORD dwWritten, dwLength;
+BOOL xSuccess;
+UBaseType_t x;
+char *pcName;
+const void *pvData;
+
+	( void ) lpParameter;
+
+	for( ;; )
+	{
+		WaitForSingleObject( xSnapshotEvent, INFINITE );
+
+		/* Make room for the new file by deleting the oldest. */
+		if( uxFileCount == uxMaxFiles )
+		{
+			DeleteFileA( cFileNames[ 0 ] );
+
+			for( x = 1; x < uxFileCount; x++ )
+			{
+				memcpy( cFileNames[ x - 1 ], cFileNames[ x ], tracesnapshotMAX_NAME_LENGTH );
+			}
+
+			uxFileCount--;
+		}
+
+		pcName = cFileNames[ uxFileCount ];
+		snprintf( pcName, tracesnapshotMAX_NAME_LENGTH, "%s_%04u%02u%02u_%02u%02u%02u_%03u_%s." tracesnapshotEXTENSION, cBaseName,
+				  ( unsigned ) xSnapshotTime.wYear, ( unsigned ) xSnapshotTime.wMonth, ( unsigned ) xSnapshotTime.wDay,
+				  ( unsigned ) xSnapshotTime.wHour, ( unsigned ) xSnapshotTime.wMinute, ( unsigned ) xSnapshotTime.wSecond,
+				  ( unsigned ) xSnapshotTime.wMilliseconds, pcSnapshotReason );
+
+		#if( tracesnapshotCOMPRESS == 1 )
+		{
+			/* The buffer is big enough for any data, so this can not fail. */
+			pvData = ucCompressed;
+			dwLength = ( DWORD ) xTraceCompress( ( const uint8_t * ) &xSnapshot, sizeof( xSnapshot ), ucCompressed, sizeof( ucCompressed ) );
+			configASSERT( dwLength != 0 );
+		}
+		#else
+		{
+			pvData = &xSnapshot;
+			dwLength = ( DWORD ) sizeof( xSnapshot );
+		}
+		#endif
+
+		/* Windows calls are used rather than the C library, whose locks may be
+		held by a task the scheduler has suspended. */
+		xSuccess = FALSE;
+		xFile = CreateFileA( pcName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+
+		if( xFile != INVALID_HANDLE_VALUE )
+		{
+			xSuccess = WriteFile( xFile, pvData, dwLength, &dwWritten, NULL ) && ( dwWritten == dwLength );
+			CloseHandle( xFile );
+		}
+
+		if( xSuccess != FALSE )
+		{
+			uxFileCount++;
+			ulWritten++;
+		}
+		else
+		{
+			DeleteFileA( pcName );
+			InterlockedIncrement( &lDropped );
+		}
+
+		/* The buffer can take the next snapshot. */
+		InterlockedExchange( &lSnapshotHeld, 0 );
+	}
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static BOOL WINAPI prvConsoleHandler( DWORD dwCtrlType )
+{
+	if( dwCtrlType == CTRL_BREAK_EVENT )
+	{
+		/* This thread is not a FreeRTOS task, so the snapshot is taken by a
+		simulated interrupt, as the tick is generated by port.c.  Returning
+		TRUE stops Windows from ending the process. */
+		vPortGenerateSimulatedInterrupt( tracesnapshotINTERRUPT_NUMBER );
+		return TRUE;
+	}
+
+	/* Anything else, such as Ctrl+C, is left to the next handler. */
+	return FALSE;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBreakInterruptHandler( void )
+{
+	tracefilterISR_BEGIN( xTraceISR );
+	xTraceSnapshotRequestFromISR( tracesnapshotBREAK_REASON );
+
+	/* No task was woken. */
+	tracefilterISR_END( pdFALSE );
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddExistingFiles( void )
+{
+WIN32_FIND_DATAA xFound;
+HANDLE xFind;
+char cName[ tracesnapshotMAX_NAME_LENGTH ];
+const char *pcSeparator, *pcSlash;
+int iDirectoryLength;
+UBaseType_t x, uxPosition;
+
+	/* The names found do not include the directory, which is the part of the
+	base name up to the last separator. */
+	pcSeparator = strrchr( cBaseName, '\\' );
+	pcSlash = strrchr( cBaseName, '/' );
+
+	if( ( pcSlash != NULL ) && ( ( pcSeparator == NULL ) || ( pcSlash > pcSeparator ) ) )
+	{
+		pcSeparator = pcSlash;
+	}
+
+	iDirectoryLength = ( pcSeparator == NULL ) ? 0 : ( int ) ( pcSeparator - cBaseName ) + 1;
+
+	snprintf( cName, sizeof( cName ), "%s_*." tracesnapshotEXTENSION, cBaseName );
+	xFind = FindFirstFileA( cName, &xFound );
+
+	if( xFind == INVALID_HANDLE_VALUE )
+	{
+		return;
+	}
+
+	do
+	{
+		if( ( xFound.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) == 0 )
+		{
+			snprintf( cName, sizeof( cName ), "%.*s%s", iDirectoryLength, cBaseName, xFound.cFileName );
+
+			/* The position of the file among those kept so far. */
+			for( uxPosition = uxFileCount; ( uxPosition > 0 ) && ( strcmp( cFileNames[ uxPosition - 1 ], cName ) > 0 ); uxPosition-- )
+			{
+			}
+
+			if( uxFileCount < uxMaxFiles )
+			{
+				for( x = uxFileCount; x > uxPosition; x-- )
+				{
+					memcpy( cFileNames[ x ], cFileNames[ x - 1 ], tracesnapshotMAX_NAME_LENGTH );
+				}
+
+				memcpy( cFileNames[ uxPosition ], cName, tracesnapshotMAX_NAME_LENGTH );
+				uxFileCount++;
+			}
+			else if( uxPosition == 0 )
+			{
+				/* Older than all the files kept. */
+				DeleteFileA( cName );
+			}
+			else
+			{
+				/* Delete the oldest to make room, which moves the position of
+				the file down by one. */
+				DeleteFileA( cFileNames[ 0 ] );
+
+				for( x = 1; x < uxPosition; x++ )
+				{
+					memcpy( cFileNames[ x - 1 ], cFileNames[ x ], tracesnapshotMAX_NAME_LENGTH );
+				}
+
+				memcpy( cFileNames[ uxPosition - 1 ], cName, tracesnapshotMAX_NAME_LENGTH );
+			}
+		}
+	} while( FindNextFileA( xFind, &xFound ) != FALSE );
+
+	FindClose( xFind );
+}
+/*-----------------------------------------------------------*/
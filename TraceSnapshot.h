@@ -0,0 +1,99 @@
+/*
+ * Snapshots of the trace recorder's buffer, taken while it keeps recording.
+ *
+ * Saving the trace used to mean stopping the recorder, so the events that
+ * followed an incident were lost and the system had to be restarted to trace
+ * it again.  A snapshot instead copies the whole recorder data, which holds
+ * the ring buffer of events and the tables needed to read it, into a second
+ * buffer.  The copy is made with interrupts masked, so the recorder can not
+ * store an event half way through it.  The whole recorder data is copied,
+ * not just the events stored, so the time the copy takes grows with the size
+ * of the recorder buffer; the longest copy measured is returned by
+ * ulTraceSnapshotGetLongestCopyUs().  A host thread then writes the copy to a
+ * file in the background, while the recorder carries on.
+ *
+ * The files are named after the base name given to xTraceSnapshotInitialise(),
+ * the local time of the snapshot and its reason, and only the most recent
+ * ones are kept, counting those left by earlier runs with the same base name:
+ * once there are as many as requested, each new file replaces the oldest.  Unless tracesnapshotCOMPRESS is 0, the files are written in the
+ * compact format of TraceCompress.h, with the extension .trcz, and are a small
+ * fraction of the size of the recorder data; Tools/trcz.py decodes them.
+ * Otherwise, and after decoding, every file has the same format as the dump
+ * vAssertCalled() writes, so it opens in Tracealyzer in the same way.
+ *
+ * A snapshot can be requested by the application, from a task or an
+ * interrupt, or by pressing Ctrl+Break in the console, which generates a
+ * simulated interrupt that takes it.  Only one snapshot is held at a time, so
+ * a request made while the previous snapshot is still being written is
+ * dropped and counted.
+ */
+
+#ifndef TRACE_SNAPSHOT_H
+#define TRACE_SNAPSHOT_H
+
+/* The simulated interrupt Ctrl+Break generates.  HiResTimer.c uses 3 and
+IrqLatency.c 4. */
+#ifndef tracesnapshotINTERRUPT_NUMBER
+	#define tracesnapshotINTERRUPT_NUMBER	( 5 )
+#endif
+
+/* Set to 0 to write the recorder data as it is, with the extension .dump. */
+#ifndef tracesnapshotCOMPRESS
+	#define tracesnapshotCOMPRESS			( 1 )
+#endif
+
+/* The extension of the files written, without the dot. */
+#if( tracesnapshotCOMPRESS == 1 )
+	#define tracesnapshotEXTENSION			"trcz"
+#else
+	#define tracesnapshotEXTENSION			"dump"
+#endif
+
+/* The most files kept. */
+#define tracesnapshotMAX_FILES				( 16 )
+
+/* The longest file name, including the directory in the base name. */
+#define tracesnapshotMAX_NAME_LENGTH		( 260 )
+
+/*
+ * Start the thread that writes the snapshots.  Snapshots are written to files
+ * whose names start with pcBaseName, keeping the uxFiles most recent, up to
+ * tracesnapshotMAX_FILES.  Files already on disk with the same base name and
+ * extension count as the oldest, and the oldest of them are deleted if there
+ * are more than uxFiles.  Must be called after vTraceEnable() and before the
+ * scheduler is started.  Returns pdFAIL if the thread could not be created.
+ */
+BaseType_t xTraceSnapshotInitialise( const char *pcBaseName, UBaseType_t uxFiles );
+
+/*
+ * Take Ctrl+Break as a request for a snapshot.  The simulated interrupt it
+ * generates can only be taken once the scheduler is running, so this must be
+ * called from a task, for example from vApplicationDaemonTaskStartupHook(),
+ * and Ctrl+Break ends the process as usual until then.
+ */
+void vTraceSnapshotEnableBreak( void );
+
+/*
+ * Take a snapshot and have it written, naming it after pcReason, which must
+ * be a string constant with no characters that can not be in a file name.
+ * Returns pdFAIL if the request was dropped because the previous snapshot is
+ * still being written.  The FromISR version must be called from an
+ * interrupt.
+ */
+BaseType_t xTraceSnapshotRequest( const char *pcReason );
+BaseType_t xTraceSnapshotRequestFromISR( const char *pcReason );
+
+/*
+ * The number of snapshots written, and of requests dropped or snapshots that
+ * could not be written.
+ */
+uint32_t ulTraceSnapshotGetWritten( void );
+uint32_t ulTraceSnapshotGetDropped( void );
+
+/*
+ * The longest time a snapshot has kept interrupts masked while copying the
+ * recorder data, in microseconds.
+ */
+uint32_t ulTraceSnapshotGetLongestCopyUs( void );
+
+#endif /* TRACE_SNAPSHOT_H */
@@ -0,0 +1,76 @@
+/*
+ * Wait-free single producer, single consumer triple buffer.  See the comments
+ * in TripleBuffer.h.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+
+#include "TripleBuffer.h"
+
+/* Set in lShared when the shared slot holds an item the consumer has not yet
+acquired.  The low two bits of lShared hold the slot index. */
+#define tbFRESH_BIT			( ( LONG ) 0x04 )
+#define tbINDEX_MASK		( ( LONG ) 0x03 )
+
+/*-----------------------------------------------------------*/
+
+void vTripleBufferInitialise( TripleBuffer_t *pxBuffer, void *pvStorage, size_t xItemSize )
+{
+	configASSERT( pxBuffer );
+	configASSERT( pvStorage );
+
+	pxBuffer->pucStorage = ( uint8_t * ) pvStorage;
+	pxBuffer->xItemSize = xItemSize;
+
+	/* The producer starts with slot 0, the buffer holds slot 1 and the
+	consumer starts with slot 2.  Nothing has been published yet. */
+	pxBuffer->lWriteIndex = 0;
+	pxBuffer->lShared = 1;
+	pxBuffer->lReadIndex = 2;
+
+	memset( pvStorage, 0x00, 3 * xItemSize );
+}
+/*-----------------------------------------------------------*/
+
+void *pvTripleBufferGetWriteBuffer( TripleBuffer_t *pxBuffer )
+{
+	return pxBuffer->pucStorage + ( ( size_t ) pxBuffer->lWriteIndex * pxBuffer->xItemSize );
+}
+/*-----------------------------------------------------------*/
+
+void vTripleBufferPublish( TripleBuffer_t *pxBuffer )
+{
+LONG lPrevious;
+
+	/* Hand the freshly written slot to the buffer and take back whichever
+	slot the buffer held.  If the consumer never acquired that slot its
+	contents are stale and can be overwritten. */
+	lPrevious = tbATOMIC_EXCHANGE( &( pxBuffer->lShared ), pxBuffer->lWriteIndex | tbFRESH_BIT );
+	pxBuffer->lWriteIndex = lPrevious & tbINDEX_MASK;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTripleBufferAcquire( TripleBuffer_t *pxBuffer, const void **ppvItem )
+{
+LONG lPrevious;
+BaseType_t xReturn = pdFALSE;
+
+	/* Only the producer can set the fresh bit and only the consumer can clear
+	it, so if it is not set now there is nothing new and the exchange can be
+	skipped. */
+	if( ( pxBuffer->lShared & tbFRESH_BIT ) != 0 )
+	{
+		lPrevious = tbATOMIC_EXCHANGE( &( pxBuffer->lShared ), pxBuffer->lReadIndex );
+		pxBuffer->lReadIndex = lPrevious & tbINDEX_MASK;
+		xReturn = pdTRUE;
+	}
+
+	*ppvItem = pxBuffer->pucStorage + ( ( size_t ) pxBuffer->lReadIndex * pxBuffer->xItemSize );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
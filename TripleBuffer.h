@@ -0,0 +1,61 @@
+/*
+ * A wait-free triple buffer for passing the latest complete item from exactly
+ * one producer task to exactly one consumer task.
+ *
+ * The three slots are owned at any moment by the producer (the slot being
+ * written), the consumer (the slot being read) and the buffer itself (the
+ * slot most recently published).  Publishing and acquiring both swap the
+ * caller's slot with the shared slot using a single atomic exchange, so
+ * neither side ever blocks on, or waits for, the other.  The consumer always
+ * sees the most recently published item; intermediate items published while
+ * the consumer is busy are simply overwritten.
+ *
+ * Because no lock is ever held no priority inversion can occur between the
+ * producer and the consumer, whatever their relative priorities.
+ */
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+/* The atomic exchange used to swap slot ownership.  The Win32 simulator maps
+this onto InterlockedExchange(), which portmacro.h brings in via windows.h. */
+#ifndef tbATOMIC_EXCHANGE
+	#define tbATOMIC_EXCHANGE( plTarget, lValue ) InterlockedExchange( ( plTarget ), ( lValue ) )
+#endif
+
+typedef struct xTRIPLE_BUFFER
+{
+	uint8_t *pucStorage;		/* Three consecutive items of xItemSize bytes each. */
+	size_t xItemSize;
+	volatile LONG lShared;		/* Index of the shared slot, plus tbFRESH_BIT if it holds an item not yet acquired. */
+	LONG lWriteIndex;			/* Only accessed by the producer. */
+	LONG lReadIndex;			/* Only accessed by the consumer. */
+} TripleBuffer_t;
+
+/*
+ * Prepare xBuffer to use pvStorage, which must be at least 3 * xItemSize bytes
+ * and remain valid for the lifetime of the buffer.  Must be called before
+ * either the producer or the consumer task starts using the buffer.
+ */
+void vTripleBufferInitialise( TripleBuffer_t *pxBuffer, void *pvStorage, size_t xItemSize );
+
+/*
+ * Producer side.  pvTripleBufferGetWriteBuffer() returns the slot the producer
+ * may fill, vTripleBufferPublish() makes that slot the latest item and hands
+ * the producer a new slot to fill.  The pointer returned before the publish
+ * must not be used after it.
+ */
+void *pvTripleBufferGetWriteBuffer( TripleBuffer_t *pxBuffer );
+void vTripleBufferPublish( TripleBuffer_t *pxBuffer );
+
+/*
+ * Consumer side.  Returns pdTRUE and takes ownership of the most recently
+ * published item if one has been published since the last call, otherwise
+ * returns pdFALSE and leaves the consumer with the item it already had.  In
+ * both cases *ppvItem is set to the item the consumer now owns, which stays
+ * valid until the next call.  Before the first publish the returned item is
+ * zero filled.
+ */
+BaseType_t xTripleBufferAcquire( TripleBuffer_t *pxBuffer, const void **ppvItem );
+
+#endif /* TRIPLE_BUFFER_H */
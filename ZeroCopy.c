@@ -0,0 +1,180 @@
+/*
+ * Zero copy message passing with reference counted pooled buffers.  See the
+ * comments in ZeroCopy.h.
+ */
+
+/* FreeRTOS includes. */
+#include <FreeRTOS.h>
+#include <queue.h>
+
+#include "ZeroCopy.h"
+
+/* The header that precedes every buffer. */
+typedef struct xZEROCOPY_HEADER
+{
+	ZeroCopyPool_t *pxPool;
+	volatile LONG lReferences;
+} ZeroCopyHeader_t;
+
+/*
+ * The header of pvBuffer.
+ */
+static ZeroCopyHeader_t *prvGetHeader( void *pvBuffer );
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xZeroCopyPoolCreate( ZeroCopyPool_t *pxPool, void *pvStorage, size_t xBufferSize, UBaseType_t uxCount )
+{
+ZeroCopyHeader_t *pxHeader;
+void *pvBuffer;
+UBaseType_t x;
+
+	configASSERT( pxPool );
+	configASSERT( pvStorage );
+	configASSERT( ( ( size_t ) pvStorage & ( zerocopyALIGNMENT - 1 ) ) == 0 );
+	configASSERT( sizeof( ZeroCopyHeader_t ) <= zerocopyHEADER_SIZE );
+	configASSERT( uxCount > 0 );
+
+	pxPool->pucStorage = ( uint8_t * ) pvStorage;
+	pxPool->xBufferSize = xBufferSize;
+	pxPool->xStride = zerocopyHEADER_SIZE + zerocopyALIGN( xBufferSize );
+	pxPool->uxCount = uxCount;
+	pxPool->xFreeBuffers = xQueueCreate( uxCount, sizeof( void * ) );
+
+	if( pxPool->xFreeBuffers == NULL )
+	{
+		return pdFAIL;
+	}
+
+	/* Every buffer starts free.  The queue has room for all of them, so the
+	sends do not fail. */
+	for( x = 0; x < uxCount; x++ )
+	{
+		pxHeader = ( ZeroCopyHeader_t * ) ( pxPool->pucStorage + ( ( size_t ) x * pxPool->xStride ) );
+		pxHeader->pxPool = pxPool;
+		pxHeader->lReferences = 0;
+
+		pvBuffer = ( uint8_t * ) pxHeader + zerocopyHEADER_SIZE;
+		xQueueSend( pxPool->xFreeBuffers, &pvBuffer, 0 );
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vZeroCopyPoolDelete( ZeroCopyPool_t *pxPool )
+{
+	if( pxPool->xFreeBuffers != NULL )
+	{
+		vQueueDelete( pxPool->xFreeBuffers );
+		pxPool->xFreeBuffers = NULL;
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvZeroCopyAllocate( ZeroCopyPool_t *pxPool, TickType_t xTicksToWait )
+{
+void *pvBuffer = NULL;
+
+	if( xQueueReceive( pxPool->xFreeBuffers, &pvBuffer, xTicksToWait ) == pdPASS )
+	{
+		/* No other task can hold a reference to a free buffer. */
+		prvGetHeader( pvBuffer )->lReferences = 1;
+	}
+
+	return pvBuffer;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxZeroCopyGetFreeCount( const ZeroCopyPool_t *pxPool )
+{
+	return uxQueueMessagesWaiting( pxPool->xFreeBuffers );
+}
+/*-----------------------------------------------------------*/
+
+void vZeroCopyRetain( void *pvBuffer )
+{
+LONG lReferences;
+
+	lReferences = zerocopyATOMIC_INCREMENT( &( prvGetHeader( pvBuffer )->lReferences ) );
+
+	/* The caller must already hold a reference. */
+	configASSERT( lReferences > 1 );
+	( void ) lReferences;
+}
+/*-----------------------------------------------------------*/
+
+void vZeroCopyRelease( void *pvBuffer )
+{
+ZeroCopyHeader_t *pxHeader = prvGetHeader( pvBuffer );
+LONG lReferences;
+
+	lReferences = zerocopyATOMIC_DECREMENT( &( pxHeader->lReferences ) );
+	configASSERT( lReferences >= 0 );
+
+	if( lReferences == 0 )
+	{
+		/* The free queue has room for every buffer of the pool, so there is
+		no need to block. */
+		xQueueSend( pxHeader->pxPool->xFreeBuffers, &pvBuffer, 0 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vZeroCopyReleaseFromISR( void *pvBuffer, BaseType_t *pxHigherPriorityTaskWoken )
+{
+ZeroCopyHeader_t *pxHeader = prvGetHeader( pvBuffer );
+LONG lReferences;
+
+	lReferences = zerocopyATOMIC_DECREMENT( &( pxHeader->lReferences ) );
+	configASSERT( lReferences >= 0 );
+
+	if( lReferences == 0 )
+	{
+		xQueueSendFromISR( pxHeader->pxPool->xFreeBuffers, &pvBuffer, pxHigherPriorityTaskWoken );
+	}
+}
+/*-----------------------------------------------------------*/
+
+ZeroCopyChannel_t xZeroCopyChannelCreate( UBaseType_t uxLength )
+{
+	return xQueueCreate( uxLength, sizeof( void * ) );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xZeroCopySend( ZeroCopyChannel_t xChannel, void *pvBuffer, TickType_t xTicksToWait )
+{
+	configASSERT( prvGetHeader( pvBuffer )->lReferences > 0 );
+
+	return xQueueSend( xChannel, &pvBuffer, xTicksToWait );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xZeroCopySendFromISR( ZeroCopyChannel_t xChannel, void *pvBuffer, BaseType_t *pxHigherPriorityTaskWoken )
+{
+	configASSERT( prvGetHeader( pvBuffer )->lReferences > 0 );
+
+	return xQueueSendFromISR( xChannel, &pvBuffer, pxHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+void *pvZeroCopyReceive( ZeroCopyChannel_t xChannel, TickType_t xTicksToWait )
+{
+void *pvBuffer = NULL;
+
+	if( xQueueReceive( xChannel, &pvBuffer, xTicksToWait ) != pdPASS )
+	{
+		pvBuffer = NULL;
+	}
+
+	return pvBuffer;
+}
+/*-----------------------------------------------------------*/
+
+static ZeroCopyHeader_t *prvGetHeader( void *pvBuffer )
+{
+	configASSERT( pvBuffer );
+
+	return ( ZeroCopyHeader_t * ) ( ( uint8_t * ) pvBuffer - zerocopyHEADER_SIZE );
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,127 @@
+/*
+ * Zero copy message passing with reference counted buffers from a fixed pool.
+ *
+ * A queue copies every item into its storage on send and out again on
+ * receive, inside a critical section, so the cost of passing a large item
+ * grows with its size.  Here a sender instead allocates a buffer from a pool,
+ * fills it in place and sends only a pointer to it through a channel.  The
+ * receiver reads the buffer in place and releases it when it is done, which
+ * returns the buffer to its pool.  Only the pointer is ever copied, whatever
+ * the size of the buffer.
+ *
+ * A buffer is allocated with one reference, owned by the allocating task.
+ * Sending a buffer through a channel passes that reference to the receiver,
+ * so the sender must not touch the buffer once it has been sent.  To pass the
+ * same buffer to several receivers, for example to send it through several
+ * channels, take one more reference for each extra receiver with
+ * vZeroCopyRetain() before sending it.  Every reference is given up with
+ * vZeroCopyRelease(), and the buffer goes back to its pool when the last one
+ * is.  Reference counts are updated with interlocked operations, so releasing
+ * a buffer never enters a critical section unless it is the last reference.
+ *
+ * The pool keeps its free buffers in a queue of pointers, so a task that
+ * allocates from an empty pool can block until a buffer is released, which
+ * also limits how far a fast sender can get ahead of a slow receiver.
+ */
+
+#ifndef ZERO_COPY_H
+#define ZERO_COPY_H
+
+#include "queue.h"
+
+/* The interlocked operations used to count references.  The Win32 simulator
+maps these onto the Interlocked functions, which portmacro.h brings in via
+windows.h.  Both return the new count. */
+#ifndef zerocopyATOMIC_INCREMENT
+	#define zerocopyATOMIC_INCREMENT( plTarget ) InterlockedIncrement( ( plTarget ) )
+#endif
+
+#ifndef zerocopyATOMIC_DECREMENT
+	#define zerocopyATOMIC_DECREMENT( plTarget ) InterlockedDecrement( ( plTarget ) )
+#endif
+
+/* Every buffer is preceded by a header holding its pool and reference count,
+and both are rounded up to zerocopyALIGNMENT bytes. */
+#define zerocopyALIGNMENT				( 8 )
+#define zerocopyALIGN( xSize )			( ( ( xSize ) + ( zerocopyALIGNMENT - 1 ) ) & ~( ( size_t ) zerocopyALIGNMENT - 1 ) )
+#define zerocopyHEADER_SIZE				( 16 )
+
+/* The number of bytes of storage a pool of uxCount buffers of xBufferSize
+bytes needs. */
+#define zerocopySTORAGE_SIZE( uxCount, xBufferSize ) ( ( uxCount ) * ( zerocopyHEADER_SIZE + zerocopyALIGN( xBufferSize ) ) )
+
+typedef struct xZEROCOPY_POOL
+{
+	uint8_t *pucStorage;			/* uxCount buffers, each after its header. */
+	size_t xBufferSize;
+	size_t xStride;					/* Bytes from one header to the next. */
+	UBaseType_t uxCount;
+	QueueHandle_t xFreeBuffers;		/* Pointers to the buffers not in use. */
+} ZeroCopyPool_t;
+
+/* A channel is a queue of buffer pointers. */
+typedef QueueHandle_t ZeroCopyChannel_t;
+
+/*
+ * Prepare pxPool to hand out uxCount buffers of xBufferSize bytes from
+ * pvStorage, which must be at least zerocopySTORAGE_SIZE( uxCount,
+ * xBufferSize ) bytes, aligned to zerocopyALIGNMENT, and remain valid until
+ * the pool is deleted.  Returns pdFAIL if the queue of free buffers could not
+ * be created.
+ */
+BaseType_t xZeroCopyPoolCreate( ZeroCopyPool_t *pxPool, void *pvStorage, size_t xBufferSize, UBaseType_t uxCount );
+
+/*
+ * Delete the queue of free buffers.  No buffer of the pool must be used
+ * afterwards.
+ */
+void vZeroCopyPoolDelete( ZeroCopyPool_t *pxPool );
+
+/*
+ * Take a buffer from pxPool, blocking for up to xTicksToWait ticks if all of
+ * them are in use.  Returns the buffer, with one reference owned by the
+ * caller, or NULL if none was released in time.
+ */
+void *pvZeroCopyAllocate( ZeroCopyPool_t *pxPool, TickType_t xTicksToWait );
+
+/*
+ * The number of buffers of pxPool not in use.
+ */
+UBaseType_t uxZeroCopyGetFreeCount( const ZeroCopyPool_t *pxPool );
+
+/*
+ * Add a reference to pvBuffer, for a further receiver.
+ */
+void vZeroCopyRetain( void *pvBuffer );
+
+/*
+ * Give up a reference to pvBuffer, returning it to its pool if it was the last
+ * one.  The FromISR version can be called from an interrupt, and sets
+ * *pxHigherPriorityTaskWoken as xQueueSendFromISR() does.
+ */
+void vZeroCopyRelease( void *pvBuffer );
+void vZeroCopyReleaseFromISR( void *pvBuffer, BaseType_t *pxHigherPriorityTaskWoken );
+
+/*
+ * Create a channel that can hold uxLength buffers.  Returns NULL if it could
+ * not be created.  Delete it with vQueueDelete().
+ */
+ZeroCopyChannel_t xZeroCopyChannelCreate( UBaseType_t uxLength );
+
+/*
+ * Pass the caller's reference to pvBuffer through xChannel, blocking for up to
+ * xTicksToWait ticks if the channel is full.  Returns pdPASS if the buffer was
+ * sent, after which the caller must not use it, or errQUEUE_FULL if it was
+ * not, in which case the caller still owns its reference.
+ */
+BaseType_t xZeroCopySend( ZeroCopyChannel_t xChannel, void *pvBuffer, TickType_t xTicksToWait );
+BaseType_t xZeroCopySendFromISR( ZeroCopyChannel_t xChannel, void *pvBuffer, BaseType_t *pxHigherPriorityTaskWoken );
+
+/*
+ * Take the next buffer from xChannel, blocking for up to xTicksToWait ticks if
+ * it is empty.  Returns the buffer, whose reference is now owned by the
+ * caller, or NULL if none arrived in time.
+ */
+void *pvZeroCopyReceive( ZeroCopyChannel_t xChannel, TickType_t xTicksToWait );
+
+#endif /* ZERO_COPY_H */
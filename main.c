@@ -26,12 +26,12 @@
  */
 
 /******************************************************************************
- * This project provides two demo applications.  A simple blinky style project,
- * and a more comprehensive test and demo application.  The
- * mainCREATE_SIMPLE_BLINKY_DEMO_ONLY setting is used to select between the two.
- * The simply blinky demo is implemented and described in main_blinky.c.  The
- * more comprehensive test and demo application is implemented and described in
- * main_full.c.
+ * This project provides the ZigZag game and two demo applications.  A simple
+ * blinky style project, and a more comprehensive test and demo application.
+ * The environment variable named by mainDEMO_VARIABLE is used to select
+ * between them.  The simply blinky demo is implemented and described in
+ * main_blinky.c.  The more comprehensive test and demo application is
+ * implemented and described in main_full.c.
  *
  * This file implements the code that is not demo specific, including the
  * hardware setup and FreeRTOS hook functions.
@@ -57,21 +57,49 @@
 /* FreeRTOS kernel includes. */
 #include "FreeRTOS.h"
 #include "task.h"
+#include "timers.h"
 #include <time.h>
 #include <math.h>
 #include <string.h>
 
-/* This project provides two demo applications.  A simple blinky style demo
-application, and a more comprehensive test and demo application.  The
-mainCREATE_SIMPLE_BLINKY_DEMO_ONLY setting is used to select between the two.
-
-If mainCREATE_SIMPLE_BLINKY_DEMO_ONLY is 1 then the blinky demo will be built.
-The blinky demo is implemented and described in main_blinky.c.
-
-If mainCREATE_SIMPLE_BLINKY_DEMO_ONLY is not 1 then the comprehensive test and
-demo application will be built.  The comprehensive test and demo application is
-implemented and described in main_full.c. */
-#define mainCREATE_SIMPLE_BLINKY_DEMO_ONLY 1
+/* Demo application includes. */
+#include "TripleBuffer.h"
+#include "ResourceCeiling.h"
+#include "AnsiRenderer.h"
+#include "Fisica.h"
+#include "Caminho.h"
+#include "Diamantes.h"
+#include "Random.h"
+#include "RunLog.h"
+#include "Replay.h"
+#include "Budget.h"
+#include "JobProfiler.h"
+#include "TicklessIdle.h"
+#include "HiResTimer.h"
+#include "PeriodicJob.h"
+#include "EstadoJogo.h"
+#include "MultiCore.h"
+#include "TickWork.h"
+#include "TraceFilter.h"
+#include "TraceSnapshot.h"
+
+/* Besides the game, this project provides two demo applications.  A simple
+blinky style demo application, and a more comprehensive test and demo
+application.  Both are always built, and the environment variable named by
+mainDEMO_VARIABLE selects what runs.
+
+If mainDEMO_VARIABLE is set to mainDEMO_BLINKY then the blinky demo runs in
+place of the game.  The blinky demo is implemented and described in
+main_blinky.c.
+
+If mainDEMO_VARIABLE is set to mainDEMO_FULL then the comprehensive test and
+demo application runs in place of the game.  The comprehensive test and demo
+application is implemented and described in main_full.c.
+
+If mainDEMO_VARIABLE is not set then the game runs. */
+#define mainDEMO_VARIABLE "ZIGZAG_DEMO"
+#define mainDEMO_BLINKY "blinky"
+#define mainDEMO_FULL "full"
 
 /* This demo uses heap_5.c, and these constants define the sizes of the regions
 that make up the total heap.  heap_5 is only used for test and example purposes
@@ -85,18 +113,23 @@ choice.  See http://www.freertos.org/a00111.html for an explanation. */
 /*-----------------------------------------------------------*/
 
 /*
- * main_blinky() is used when mainCREATE_SIMPLE_BLINKY_DEMO_ONLY is set to 1.
- * main_full() is used when mainCREATE_SIMPLE_BLINKY_DEMO_ONLY is set to 0.
+ * main_blinky() is used when mainDEMO_VARIABLE is set to mainDEMO_BLINKY.
+ * main_full() is used when mainDEMO_VARIABLE is set to mainDEMO_FULL.
  */
-//extern void main_blinky( void );
-//extern void main_full( void );
+extern void main_blinky( void );
+extern int main_full( void );
 
 /*
  * Only the comprehensive demo uses application hook (callback) functions.  See
  * http://www.freertos.org/a00016.html for more information.
  */
-//void vFullDemoTickHookFunction( void );
-//void vFullDemoIdleFunction( void );
+void vFullDemoIdleFunction( void );
+
+/*
+ * Run the demo application selected by mainDEMO_VARIABLE in place of the game.
+ * Returns pdFALSE, having run nothing, if no demo is selected.
+ */
+static BaseType_t prvRunSelectedDemo( void );
 
 /*
  * This demo uses heap_5.c, so start by defining some heap regions.  It is not
@@ -135,6 +168,11 @@ StackType_t uxTimerTaskStack[configTIMER_TASK_STACK_DEPTH];
 /* Notes if the trace is running or not. */
 static BaseType_t xTraceRunning = pdTRUE;
 
+/* Note if a demo application is running in place of the game, and if it is the
+comprehensive one. */
+static BaseType_t xDemoRunning = pdFALSE;
+static BaseType_t xFullDemoRunning = pdFALSE;
+
 /*############################ Implementação do jogo ZigZag ############################*/
 
 /*  # Disciplina: Sistemas em Tempo Real
@@ -167,9 +205,6 @@ int P_CRIA_CAMINHO = 20;
 int P_ADICIONA_DIAMANTE = 5000;
 int P_CHECA_FIM_DO_JOGO = 5;
 
-/* Inicializando variável que indica fim da partida */
-BOOL fim_de_jogo = FALSE;
-
 /* Variável que acompanha o tempo de execução das tarefas sendo executadas */
 int tempo_de_execucao = 0;
 
@@ -182,10 +217,384 @@ int contador_T2 = 0;
 int contador_T3 = 0;
 int contador_T5 = 0;
 
+/* Buffers triplos da janela do caminho, produzida por T2, e a memória dos seus quadros:
+	-> buffer_caminho: T2 -> T1 (desenho)
+	-> buffer_caminho_fisica: T2 -> T5 (teste de queda e coleta de diamantes)
+	-> buffer_caminho_diamantes: T2 -> T4 (posição dos novos diamantes)
+   Nenhuma tarefa bloqueia a outra, então não há inversão de prioridade entre elas. */
+static TripleBuffer_t buffer_caminho;
+static QuadroCaminho quadros_caminho[3];
+static TripleBuffer_t buffer_caminho_fisica;
+static QuadroCaminho quadros_caminho_fisica[3];
+static TripleBuffer_t buffer_caminho_diamantes;
+static QuadroCaminho quadros_caminho_diamantes[3];
+
+/* Estado da bolinha publicado por T5 para T1 a cada job */
+typedef struct
+{
+	Bola bola;
+	int linhas_ate_queda;
+} EstadoBola;
+
+static TripleBuffer_t buffer_bola;
+static EstadoBola estados_bola[3];
+
+/* A bolinha, acessada apenas por T5 */
+static Bola bola;
+
+/* Linha em que a bolinha está. Escrita por T5 e lida por T2 para posicionar a janela do caminho */
+static volatile LONG linha_da_bola = 0;
+
+/* Quantas linhas do caminho ficam atrás da bolinha na janela */
+#define LINHAS_ATRAS_DA_BOLA 3
+
+/* Segmentos do caminho gerados à frente da bolinha, acessados apenas por T2 */
+static Caminho caminho;
+static uint32_t sequencia_caminho = 0;
+
+/* Ligada por reinicia_partida() para que T2 recomece a numeração das janelas na nova partida.
+   A numeração é só de T2, então é T2 quem a zera, no próximo quadro que publica. */
+static volatile LONG recomeca_sequencia_caminho = 0;
+
+/* Semente da sessão. Cada tarefa que sorteia valores tem o seu próprio gerador, iniciado
+   com essa semente e um fluxo diferente, então a sessão pode ser repetida a partir dela
+   definindo a variável de ambiente ZIGZAG_SEMENTE. */
+#define FLUXO_CAMINHO 2
+#define FLUXO_DIAMANTES 4
+#define FLUXO_MULTICORE 6
+static uint64_t semente_da_sessao;
+
+/* Gravação e repetição da execução (veja Replay.h), escolhidas pela variável de ambiente
+   ZIGZAG_REPLAY ("gravar" ou "repetir"). Os eventos ficam no arquivo ARQUIVO_REPLAY e as
+   entradas do jogador são identificadas pela origem. */
+#define ARQUIVO_REPLAY "ZigZag.replay"
+#define ENTRADA_MENU 0
+#define ENTRADA_TECLADO 1
+/* Opção devolvida pelos menus quando a repetição não tem mais opções gravadas */
+#define OPCAO_FIM_DA_REPETICAO -1
+
+/* Cópias do trace tiradas sem parar o gravador (veja TraceSnapshot.h), quando um job perde o
+   prazo ou com Ctrl+Break. Só as SNAPSHOTS_GUARDADOS mais recentes ficam em disco. */
+#define ARQUIVOS_DE_SNAPSHOT "ZigZag_trace"
+#define SNAPSHOTS_GUARDADOS 8
+
+/* Arquivo CSV com o tempo de processador medido de cada job das tarefas (veja JobProfiler.h) */
+#define ARQUIVO_TEMPOS_DOS_JOBS "ZigZag_jobs.csv"
+
+/* Orçamentos de execução por job (veja Budget.h): o tempo de execução da tarefa mais uma
+   folga, em ms, e o que fazer quando um job passa do orçamento. T1 e T2 apenas registram
+   o estouro. T4 é uma tarefa soft longa, então o job que estoura é abortado e rebaixado
+   e o job seguinte é pulado, para que ela não tome a folga de T1 e T5. */
+#define FOLGA_ORCAMENTO 2
+#define ACOES_ORCAMENTO_T1 eBudgetLog
+#define ACOES_ORCAMENTO_T2 eBudgetLog
+#define ACOES_ORCAMENTO_T4 (eBudgetLog | eBudgetAbort | eBudgetDemote | eBudgetSkipNext)
+
+/* Com 1, T5 é liberada pelo timer de alta resolução (veja HiResTimer.h) exatamente a cada
+   ESPERA_T5 ms, sem o atraso de até um tick de vTaskDelayUntil().
+   Com 0, T5 volta a ser liberada pelo tick. */
+#define LIBERA_T5_EM_ALTA_RESOLUCAO 1
+
+/* Intervalo entre as liberações de T5, em ms. Como T1 e T2, T5 espera metade do período,
+   e o mesmo intervalo é usado pelos dois caminhos para que a física da bolinha não mude de
+   velocidade com LIBERA_T5_EM_ALTA_RESOLUCAO. */
+#define ESPERA_T5 (P_CHECA_FIM_DO_JOGO / 2)
+
+/* Como T4 é executada (veja PeriodicJob.h). Com ePeriodicJobAuto, por ter período longo, T4
+   é executada pela tarefa de serviço dos timers, sem uma tarefa e uma pilha próprias, com o
+   tempo de execução dividido em fatias de FATIA_ADICIONA_DIAMANTE ms. Assim que o escalonador
+   começa, a tarefa de serviço passa para PRIORIDADE_T4, abaixo de todas as outras tarefas do
+   jogo (veja vApplicationDaemonTaskStartupHook()), e o orçamento e os tempos de cada job são
+   os do job de T4, e não os da tarefa de serviço. Com ePeriodicJobTask, T4 tem uma tarefa
+   própria com PRIORIDADE_T4. */
+#define SUPORTE_T4 ePeriodicJobAuto
+#define FATIA_ADICIONA_DIAMANTE 1
+#define PRIORIDADE_T4 1
+
+/* O job periódico de T4, e os jobs de T1, T2 e T5, que se liberam sozinhas, mas marcam os
+   seus jobs no trace e contam os prazos perdidos da mesma forma (veja PeriodicJob.h) */
+static PeriodicJob_t *job_T4;
+static PeriodicJob_t *job_T1;
+static PeriodicJob_t *job_T2;
+static PeriodicJob_t *job_T5;
+
+/* Simulação das tarefas em um processador com vários núcleos (veja MultiCore.h), pedida pela
+   variável de ambiente ZIGZAG_MULTICORE no formato "modo:nucleos:sinteticas:utilizacao:migracao",
+   por exemplo "wfd:4:10:150" ou "gedf:4:10:150:50":
+	-> modo: escalonamento particionado, com as tarefas distribuídas por ffd (first fit
+	   decreasing) ou wfd (worst fit decreasing), ou global, por prioridade fixa (gfp) ou EDF (gedf)
+	-> nucleos: quantos núcleos simular
+	-> sinteticas: quantas tarefas sintéticas somar a T1 - T5 (opcional)
+	-> utilizacao: a utilização total das tarefas sintéticas, em % de um núcleo (opcional)
+	-> migracao: o custo de cada migração no escalonamento global, em us (opcional)
+   A simulação é feita no lugar do jogo, por HORIZONTE_MULTICORE us de tempo virtual. Os modos
+   globais são comparados com o particionado por wfd no mesmo número de núcleos. */
+#define HORIZONTE_MULTICORE 10000000UL
+#define CUSTO_MIGRACAO_PADRAO 50
+static MultiCoreTaskSet_t conjunto_multicore;
+
+/* Gerador de T4, para a coluna dos diamantes */
+static Random_t aleatorio_T4;
+
+/* Diamantes colocados no caminho por T4, coletados por T5 e desenhados por T1 */
+static Diamantes diamantes;
+
+/* Quantas vezes T1 redesenhou um quadro porque T2 ainda não tinha publicado um novo */
+int quadros_repetidos = 0;
+
+/* Protocolo usado nos recursos compartilhados entre as tarefas.
+	-> eCeilingImmediate: teto de prioridade imediato (escalonamento por prioridade fixa)
+	-> eCeilingStackResource: Stack Resource Policy (para o caso EDF)
+   Os tetos são calculados a partir das tarefas que declaram usar cada recurso. */
+#define POLITICA_RECURSOS eCeilingImmediate
+
+/* Recursos compartilhados entre T1 - T5:
+	-> recurso_console: a saída padrão (stdout) e as mensagens do renderizador
+	-> recurso_contadores: os contadores das tarefas e os diamantes coletados
+	-> recurso_diamantes: os diamantes que estão no caminho */
+static CeilingResource_t *recurso_console;
+static CeilingResource_t *recurso_contadores;
+static CeilingResource_t *recurso_diamantes;
+
 
 /* --------------- Funções Auxiliares --------------- */
 
 
+uint64_t escolhe_semente()
+{
+	/* Essa função retorna a semente definida em ZIGZAG_SEMENTE ou, se não houver, uma nova */
+
+	const char *texto = getenv("ZIGZAG_SEMENTE");
+
+	if (texto != NULL)
+	{
+		return strtoull(texto, NULL, 0);
+	}
+
+	return ((uint64_t)time(NULL) << 32) ^ GetTickCount();
+}
+
+void inicializa_replay(uint64_t *semente)
+{
+	/* Essa função liga a gravação ou a repetição pedida em ZIGZAG_REPLAY.
+	   Na repetição a semente passa a ser a da execução gravada. */
+
+	const char *modo = getenv("ZIGZAG_REPLAY");
+
+	if (modo == NULL)
+	{
+		return;
+	}
+
+	if (strcmp(modo, "gravar") == 0)
+	{
+		xReplayInitialise(eReplayRecord, ARQUIVO_REPLAY, semente);
+		vRunLogPrintf("gravando a execucao em %s", ARQUIVO_REPLAY);
+	}
+	else if (strcmp(modo, "repetir") == 0)
+	{
+		if (xReplayInitialise(eReplayPlay, ARQUIVO_REPLAY, semente) == pdPASS)
+		{
+			vRunLogPrintf("repetindo a execucao de %s", ARQUIVO_REPLAY);
+		}
+		else
+		{
+			vRunLogPrintf("nao foi possivel ler %s", ARQUIVO_REPLAY);
+		}
+	}
+}
+
+void inicializa_filtro_do_trace()
+{
+	/* Essa função escolhe os eventos que o trace grava, pedidos em ZIGZAG_TRACE:
+	   "escalonamento" grava só as trocas de tarefa, e um número escolhe as classes
+	   de eventos gravadas (veja TraceFilter.h). Sem ZIGZAG_TRACE tudo é gravado. */
+
+	const char *modo = getenv("ZIGZAG_TRACE");
+
+	if (modo == NULL)
+	{
+		return;
+	}
+
+	if (strcmp(modo, "escalonamento") == 0)
+	{
+		vTraceFilterSchedulingOnly();
+	}
+	else
+	{
+		vTraceFilterSetClasses((uint32_t)strtoul(modo, NULL, 0));
+	}
+
+	vRunLogPrintf("trace %s: classes 0x%02lx", modo, (unsigned long)ulTraceFilterGetClasses());
+}
+
+int le_opcao()
+{
+	/* Essa função lê uma opção dos menus. Na repetição a opção gravada é usada no tick em que
+	   foi lida e, quando não há mais opções gravadas, devolve OPCAO_FIM_DA_REPETICAO para que
+	   o menu encerre a repetição. */
+
+	int opcao = 0;
+
+	if (eReplayGetMode() == eReplayPlay)
+	{
+		opcao = lReplayWaitInput(ENTRADA_MENU, OPCAO_FIM_DA_REPETICAO);
+		if (opcao == OPCAO_FIM_DA_REPETICAO) {
+			printf("\n-> Fim das opcoes gravadas\n");
+		}
+		else {
+			printf("%d\n", opcao);
+		}
+	}
+	else
+	{
+		scanf("%d", &opcao);
+		vReplayInput(ENTRADA_MENU, opcao);
+	}
+
+	return opcao;
+}
+
+int le_tecla(int *tecla)
+{
+	/* Essa função retorna 1 e a tecla em *tecla se o jogador pressionou alguma tecla.
+	   Na repetição as teclas gravadas são entregues nos ticks em que foram lidas. */
+
+	int32_t valor;
+
+	if (eReplayGetMode() == eReplayPlay)
+	{
+		if (xReplayPollInput(ENTRADA_TECLADO, &valor) == pdTRUE)
+		{
+			*tecla = valor;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	if (_kbhit() != 0)
+	{
+		*tecla = getch();
+		vReplayInput(ENTRADA_TECLADO, *tecla);
+		return 1;
+	}
+
+	return 0;
+}
+
+int simula_multicore()
+{
+	/* Essa função faz a simulação com vários núcleos pedida em ZIGZAG_MULTICORE e retorna 1,
+	   ou retorna 0 se ela não foi pedida */
+
+	const char *texto = getenv("ZIGZAG_MULTICORE");
+	char modo[5] = "wfd";
+	unsigned nucleos = 2, sinteticas = 0, utilizacao = 0, migracao = CUSTO_MIGRACAO_PADRAO;
+	MultiCoreHeuristic_t escolhida;
+	MultiCoreMode_t global = eMultiCorePartitioned;
+	UBaseType_t necessarios, sem_nucleo;
+	Random_t aleatorio;
+
+	if (texto == NULL)
+	{
+		return 0;
+	}
+
+	sscanf(texto, "%4[^:]:%u:%u:%u:%u", modo, &nucleos, &sinteticas, &utilizacao, &migracao);
+	escolhida = (strcmp(modo, "ffd") == 0) ? eMultiCoreFirstFit : eMultiCoreWorstFit;
+
+	if (strcmp(modo, "gfp") == 0)
+	{
+		global = eMultiCoreGlobalFixedPriority;
+	}
+	else if (strcmp(modo, "gedf") == 0)
+	{
+		global = eMultiCoreGlobalEdf;
+	}
+	else if (strcmp(modo, "ffd") != 0 && strcmp(modo, "wfd") != 0)
+	{
+		printf("-> ZIGZAG_MULTICORE=\"%s\" nao reconhecido\n", texto);
+		printf("-> Use \"modo:nucleos:sinteticas:utilizacao:migracao\", com modo ffd, wfd, gfp ou gedf\n");
+		return 1;
+	}
+
+	if (nucleos < 1 || nucleos > multicoreMAX_CORES)
+	{
+		printf("-> O numero de nucleos deve estar entre 1 e %d\n", multicoreMAX_CORES);
+		return 1;
+	}
+
+	/* As tarefas do jogo, com os tempos em us (T3 é esporádica: intervalo mínimo = D = 35ms) */
+	vMultiCoreInitialise(&conjunto_multicore);
+	xMultiCoreAddTask(&conjunto_multicore, "Atualiza Display", E_ATUALIZA_DISPLAY * 1000, P_ATUALIZA_DISPLAY * 1000, P_ATUALIZA_DISPLAY * 1000);
+	xMultiCoreAddTask(&conjunto_multicore, "Cria Caminho", E_CRIA_CAMINHO * 1000, P_CRIA_CAMINHO * 1000, P_CRIA_CAMINHO * 1000);
+	xMultiCoreAddTask(&conjunto_multicore, "Le Comando", 3 * 1000, 35 * 1000, 35 * 1000);
+	xMultiCoreAddTask(&conjunto_multicore, "Adiciona Diamante", E_ADICIONA_DIAMANTE * 1000, P_ADICIONA_DIAMANTE * 1000, P_ADICIONA_DIAMANTE * 1000);
+	xMultiCoreAddTask(&conjunto_multicore, "Checa Fim do Jogo", E_CHECA_FIM_DO_JOGO * 1000, P_CHECA_FIM_DO_JOGO * 1000, P_CHECA_FIM_DO_JOGO * 1000);
+
+	/* As tarefas sintéticas são sorteadas a partir da semente da sessão */
+	vRandomSeed(&aleatorio, semente_da_sessao, FLUXO_MULTICORE);
+	if (xMultiCoreAddSyntheticTasks(&conjunto_multicore, sinteticas, utilizacao, &aleatorio) != pdPASS)
+	{
+		printf("-> Nao foi possivel sortear %u tarefas sinteticas com %u%% de utilizacao: cabem %u tarefas\n",
+			   sinteticas, utilizacao, (unsigned)(multicoreMAX_TASKS - conjunto_multicore.uxTaskCount));
+		printf("   na simulacao e nenhuma pode passar de 100%%\n");
+		return 1;
+	}
+
+	if (global != eMultiCorePartitioned)
+	{
+		vMultiCoreSimulateGlobal(&conjunto_multicore, nucleos, global, migracao, HORIZONTE_MULTICORE);
+		vMultiCorePrintReport(&conjunto_multicore);
+	}
+
+	necessarios = uxMultiCoreMinimumCores(&conjunto_multicore, escolhida);
+	sem_nucleo = uxMultiCorePartition(&conjunto_multicore, nucleos, escolhida);
+	vMultiCoreSimulatePartitioned(&conjunto_multicore, HORIZONTE_MULTICORE);
+	vMultiCorePrintReport(&conjunto_multicore);
+
+	if (necessarios == 0)
+	{
+		printf("\r\nAs tarefas nao cabem em %d nucleos\r\n", multicoreMAX_CORES);
+	}
+	else
+	{
+		printf("\r\nNucleos necessarios: %u\r\n", (unsigned)necessarios);
+	}
+
+	vRunLogPrintf("multicore %s: %u nucleos, %u tarefas sem nucleo, %u necessarios", texto, nucleos, (unsigned)sem_nucleo, (unsigned)necessarios);
+
+	return 1;
+}
+
+void vApplicationDeadlineMissHook(PeriodicJob_t *job, uint32_t indice, TickType_t atraso)
+{
+	/* Essa função é chamada quando um job de T1, T2, T4 ou T5 termina depois da liberação
+	   seguinte, ou quando uma liberação de T4 é pulada. Ela pode rodar na tarefa de serviço dos
+	   timers, que não pode bloquear, então só pede uma cópia do trace em volta do prazo perdido.
+	   Os prazos perdidos são mostrados no fim da sessão. */
+
+	(void)job;
+	(void)indice;
+	(void)atraso;
+
+	xTraceSnapshotRequest("prazo");
+}
+
+void vApplicationBudgetOverrunHook(const char *nome, uint32_t usado, uint32_t orcamento)
+{
+	/* Essa função é chamada pela própria tarefa, ou pela tarefa de serviço dos timers para T4,
+	   no início do job seguinte ao que estourou o orçamento. Os tempos estão em centésimos de
+	   milissegundo. */
+
+	vCeilingResourceTake(recurso_console);
+	vAnsiRendererLog("-> %s estourou o orcamento: %.2fms de %.2fms", nome, usado / 100.0, orcamento / 100.0);
+	vRunLogPrintf("%s estourou o orcamento: %lu de %lu", nome, (unsigned long)usado, (unsigned long)orcamento);
+	vCeilingResourceGive(recurso_console);
+}
+
 void delay(int tempo_execucao_tarefa)
 {
 	/* Essa função simula o tempo de execução das tarefas do sistema */
@@ -197,12 +606,159 @@ void delay(int tempo_execucao_tarefa)
 	/* Armazenando o tempo inicial */
 	TickType_t tempo_inicial = xTaskGetTickCount();
 
-	/* Loop até que o tempo de execução da tarefa seja alcançado */
-	while (xTaskGetTickCount() < tempo_inicial + tempo_de_execucao - tempo_de_sobra);
+	/* Loop até que o tempo de execução da tarefa seja alcançado ou o job seja abortado por
+	   estourar o seu orçamento */
+	while (xTaskGetTickCount() < tempo_inicial + tempo_de_execucao - tempo_de_sobra
+		   && xBudgetJobAborted() == pdFALSE);
 
 	tempo_de_execucao = tempo_de_sobra + tempo_execucao_tarefa;
 }
 
+int publica_caminho()
+{
+	/* Essa função monta a janela do caminho em volta da bolinha e publica para T1 e T5.
+	   Retorna quantos segmentos novos foram gerados para isso. */
+
+	QuadroCaminho *quadro = (QuadroCaminho *)pvTripleBufferGetWriteBuffer(&buffer_caminho);
+	int32_t linha_base = linha_da_bola - LINHAS_ATRAS_DA_BOLA;
+	int gerados;
+
+	if (linha_base < 0)
+	{
+		linha_base = 0;
+	}
+
+	/* Descartando os segmentos que ficaram para trás e gerando um lote, se preciso */
+	gerados = atualiza_caminho(&caminho, linha_base);
+
+	preenche_quadro(&caminho, quadro, linha_base);
+
+	/* A primeira janela de cada partida tem o número 1, pois 0 indica que não há janela */
+	if (InterlockedExchange(&recomeca_sequencia_caminho, 0) != 0)
+	{
+		sequencia_caminho = 0;
+	}
+	quadro->sequencia = ++sequencia_caminho;
+
+	/* Entregando cópias do quadro completo para T5 e T4 e o próprio quadro para T1 */
+	memcpy(pvTripleBufferGetWriteBuffer(&buffer_caminho_fisica), quadro, sizeof(QuadroCaminho));
+	vTripleBufferPublish(&buffer_caminho_fisica);
+	memcpy(pvTripleBufferGetWriteBuffer(&buffer_caminho_diamantes), quadro, sizeof(QuadroCaminho));
+	vTripleBufferPublish(&buffer_caminho_diamantes);
+	vTripleBufferPublish(&buffer_caminho);
+
+	return gerados;
+}
+
+void reinicia_bola(const QuadroCaminho *janela)
+{
+	/* Essa função coloca a bolinha de volta no centro do caminho, na linha em que ela estava */
+
+	int32_t linha = bola.y / FISICA_UNIDADE;
+	int indice = linha - janela->linha_base;
+	int coluna = LARGURA_CAMINHO / 2;
+
+	if (indice >= 0 && indice < ALTURA_CAMINHO)
+	{
+		coluna = (janela->esquerda[indice] + janela->direita[indice]) / 2;
+	}
+
+	inicializa_bola(&bola, linha, coluna);
+}
+
+void reinicia_partida()
+{
+	/* Essa função zera o placar e limpa a tela para uma nova partida. É a ação da transição
+	   de fim de jogo para partida em andamento. */
+
+	/* Limpando a tela para que T1 redesenhe o quadro inteiro */
+	vCeilingResourceTake(recurso_console);
+	vAnsiRendererClearScreen();
+	vAnsiRendererLog("-+-+-+-+-+-+ NOVA PARTIDA +-+-+-+-+-+-");
+	vRunLogPrintf("nova partida");
+	vCeilingResourceGive(recurso_console);
+
+	/* Reiniciando as variáveis */
+	vCeilingResourceTake(recurso_contadores);
+	diamantes_coletados = 0;
+	contador_T1 = 0;
+	contador_T2 = 0;
+	contador_T3 = 0;
+	contador_T5 = 0;
+	quadros_repetidos = 0;
+	vCeilingResourceGive(recurso_contadores);
+
+	/* A numeração das janelas do caminho recomeça no próximo quadro de T2 */
+	InterlockedExchange(&recomeca_sequencia_caminho, 1);
+}
+
+void encerra_sessao()
+{
+	/* Essa função mostra os relatórios da sessão e encerra o programa. É a ação da transição
+	   de fim de jogo para sessão encerrada. */
+
+	vCeilingResourceTake(recurso_console);
+	printf("-+-+-+-+-+-+ Ate a Proxima ;) +-+-+-+-+-+- \n");
+
+	/* Mostrando os tetos dos recursos, os bloqueios medidos e a análise de tempo de resposta */
+	vCeilingPrintAnalysis();
+	vBudgetPrintReport();
+	vTickWorkPrintReport();
+
+	/* Tempos de execução medidos de cada job, para estimar o pWCET com Tools/pwcet.py */
+	vProfilerPrintReport();
+	xProfilerWriteCsv(ARQUIVO_TEMPOS_DOS_JOBS);
+	vRunLogPrintf("tempos dos jobs gravados em %s", ARQUIVO_TEMPOS_DOS_JOBS);
+
+	printf("\r\nT4 executada por %s: %lu liberacoes puladas, %lu prazos perdidos\r\n",
+		   (ePeriodicJobGetBacking(job_T4) == ePeriodicJobTimer) ? "timer" : "tarefa", (unsigned long)ulPeriodicJobGetSkipped(job_T4),
+		   (unsigned long)ulPeriodicJobGetDeadlineMisses(job_T4));
+	printf("Prazos perdidos: T1 %lu, T2 %lu, T5 %lu\r\n", (unsigned long)ulPeriodicJobGetDeadlineMisses(job_T1),
+		   (unsigned long)ulPeriodicJobGetDeadlineMisses(job_T2), (unsigned long)ulPeriodicJobGetDeadlineMisses(job_T5));
+	printf("\r\nCopias do trace: %lu gravadas em %s_*." tracesnapshotEXTENSION ", %lu descartadas, copia mais longa %lu us\r\n",
+		   (unsigned long)ulTraceSnapshotGetWritten(), ARQUIVOS_DE_SNAPSHOT, (unsigned long)ulTraceSnapshotGetDropped(),
+		   (unsigned long)ulTraceSnapshotGetLongestCopyUs());
+#if (tracesnapshotCOMPRESS == 1)
+	printf("-> Para abrir no Tracealyzer: python Tools/trcz.py %s_*.trcz\r\n", ARQUIVOS_DE_SNAPSHOT);
+#endif
+
+#if (LIBERA_T5_EM_ALTA_RESOLUCAO == 1)
+	printf("\r\nMaior atraso de liberacao de T5: %lu us\r\n", (unsigned long)ulHiResTimerGetMaxLateness());
+#endif
+
+	/* Quanto tempo a tarefa idle dormiu. Os ticks continuam sendo processados, só a thread
+	   da tarefa idle deixa de rodar */
+	printf("\r\nIdle sem tick: dormiu %lu vezes, por %lu ticks\r\n",
+		   (unsigned long)ulTicklessIdleGetSleeps(), (unsigned long)ulTicklessIdleGetSleptTicks());
+	vRunLogPrintf("idle sem tick: %lu vezes, %lu ticks dormindo",
+				  (unsigned long)ulTicklessIdleGetSleeps(), (unsigned long)ulTicklessIdleGetSleptTicks());
+
+	/* Gravando os eventos ou comparando com os gravados */
+	vRunLogPrintf("hash dos eventos %016llx", (unsigned long long)ullReplayGetHash());
+	vReplayFinish();
+	vRunLogPrintf("fim da sessao");
+	vRunLogClose();
+	vCeilingResourceGive(recurso_console);
+	Sleep(1000);
+
+	/* Encerra o escalonador do sistema e o programa */
+	vTaskEndScheduler();
+}
+
+/* Transições entre os estados do jogo (veja EstadoJogo.h). As tarefas esperam pelo estado
+   em que trabalham:
+	-> T1, T2 e T3 só trabalham com a partida em andamento
+	-> T5 move a bolinha com a partida em andamento e mostra o resultado no fim de jogo
+	-> T4 não pode bloquear na tarefa de serviço dos timers, então pula os jobs fora da partida */
+static const TransicaoJogo transicoes_do_jogo[] =
+{
+	{ ESTADO_MENU,        EVENTO_INICIA_PARTIDA, ESTADO_JOGANDO,     NULL },
+	{ ESTADO_JOGANDO,     EVENTO_BOLINHA_CAIU,   ESTADO_FIM_DE_JOGO, NULL },
+	{ ESTADO_JOGANDO,     EVENTO_DESISTENCIA,    ESTADO_FIM_DE_JOGO, NULL },
+	{ ESTADO_FIM_DE_JOGO, EVENTO_JOGA_NOVAMENTE, ESTADO_JOGANDO,     reinicia_partida },
+	{ ESTADO_FIM_DE_JOGO, EVENTO_SAI_DO_JOGO,    ESTADO_ENCERRADO,   encerra_sessao }
+};
+
 void finaliza_partida()
 {
 	/* Essa função, ao fim de uma partida, oferece a opção de começar outra partida ou sair do jogo. */
@@ -210,59 +766,64 @@ void finaliza_partida()
 	int resposta;
 	while (1)
 	{
+		vCeilingResourceTake(recurso_console);
 		printf("-> Para jogar novamente pressione - 1 - \n-> Para sair do jogo pressione - 0 - \n");
 		printf("-> Digite aqui: ");
-		scanf("%d", &resposta);
+		vCeilingResourceGive(recurso_console);
+
+		/* A leitura bloqueia, então é feita fora da seção crítica */
+		resposta = le_opcao();
 
 		if (resposta == 1)
 		{
-			system("cls");
-			printf("-+-+-+-+-+-+ NOVA PARTIDA +-+-+-+-+-+- \n");
-
-			/* Reiniciando as variáveis */
-			fim_de_jogo = FALSE;
-			diamantes_coletados = 0;
-			contador_T1 = 0;
-			contador_T2 = 0;
-			contador_T3 = 0;
-			contador_T5 = 0;
-
+			dispara_evento(EVENTO_JOGA_NOVAMENTE);
 			break;
 		}
 
-		else if (resposta == 0)
+		else if (resposta == 0 || resposta == OPCAO_FIM_DA_REPETICAO)
 		{
-
-			printf("-+-+-+-+-+-+ Ate a Proxima ;) +-+-+-+-+-+- \n");
-			Sleep(1000);
-
-			/* Encerra o escalonador do sistema e o programa */
-			vTaskEndScheduler();
-
+			/* Sem opções gravadas a repetição termina como se o jogador tivesse saído,
+			   com os relatórios da sessão */
+			dispara_evento(EVENTO_SAI_DO_JOGO);
 			break;
 		}
 		else {
+			vCeilingResourceTake(recurso_console);
 			printf("-+-+-+-+-+-+-+ Opcao Invalida! +-+-+-+-+-+-+ \n");
 			printf("-+-+-+-+-+-+ Tente novamente ;) +-+-+-+-+-+-+ \n");
+			vCeilingResourceGive(recurso_console);
 			Sleep(1000);
 		}
 	}
 }
 
-void verifica_coleta_de_diamante() {
-	/* Essa função utiliza a função rand() para sortear 1 ou 0. 
-	   Se o número sorteado for 1, na simulação o jogador coletou o diamante.
-	   Se o número sorteado for 0, na simulação o jogador não conseguiu coletar o diamante */
-	
-	/* 1 ou 0 é sorteado e atribuído a variável coletou */
-	int coletou = rand() % 2;
+void verifica_coleta_de_diamante(const QuadroCaminho *janela) {
+	/* Essa função verifica se a bolinha está na mesma célula de um diamante.
+	   O diamante da linha da bolinha é achado pelo segmento da linha, sem percorrer os diamantes. */
+
+	int32_t linha = bola.y / FISICA_UNIDADE;
+	int indice = linha - janela->linha_base;
+	int coletou;
+
+	/* Antes da primeira janela, ou com a bolinha fora dela, não há o que coletar */
+	if (janela->sequencia == 0 || indice < 0 || indice >= ALTURA_CAMINHO) {
+		return;
+	}
+
+	vCeilingResourceTake(recurso_diamantes);
+	coletou = coleta_diamante(&diamantes, janela->segmento[indice], linha, bola.x / FISICA_UNIDADE);
+	vCeilingResourceGive(recurso_diamantes);
 
 	/* Se coletou for igual a 1 (TRUE) */
 	if (coletou) {
-		printf("-> Diamante Coletado!! \n");
+		vCeilingResourceTake(recurso_console);
+		vAnsiRendererLog("-> Diamante Coletado!!");
+		vCeilingResourceGive(recurso_console);
 
 		/* Incrementando o contador do número de diamantes coletados */
+		vCeilingResourceTake(recurso_contadores);
 		diamantes_coletados++;
+		vCeilingResourceGive(recurso_contadores);
 	}
 }
 
@@ -276,6 +837,76 @@ int calcula_pontuacao() {
 	return pontuacao;
 }
 
+void desenha_display(const QuadroCaminho *quadro, const EstadoBola *estado, int atualizacoes)
+{
+	/* Essa função desenha o quadro do caminho, o placar e as últimas mensagens no framebuffer
+	   e envia para o console somente os caracteres que mudaram desde o quadro anterior */
+
+	int linha, coluna, pontuacao, coletados, direita;
+	const int coluna_placar = LARGURA_CAMINHO + 2;
+	const Diamante *diamante;
+
+	/* Lendo o placar */
+	vCeilingResourceTake(recurso_contadores);
+	pontuacao = calcula_pontuacao();
+	coletados = diamantes_coletados;
+	direita = contador_T3;
+	vCeilingResourceGive(recurso_contadores);
+
+	vAnsiRendererClear();
+
+	/* A linha 0 do quadro fica atrás da bolinha, na parte de baixo da tela */
+	for (linha = 0; linha < ALTURA_CAMINHO; linha++)
+	{
+		for (coluna = quadro->esquerda[linha]; coluna <= quadro->direita[linha]; coluna++)
+		{
+			vAnsiRendererPutChar(coluna, ALTURA_CAMINHO - 1 - linha, '#');
+		}
+	}
+
+	/* Desenhando os diamantes, procurando pelo segmento de cada linha */
+	vCeilingResourceTake(recurso_diamantes);
+	for (linha = 0; linha < ALTURA_CAMINHO; linha++)
+	{
+		diamante = diamante_do_segmento(&diamantes, quadro->segmento[linha]);
+
+		if (diamante != NULL && diamante->linha == quadro->linha_base + linha)
+		{
+			vAnsiRendererPutChar(diamante->coluna, ALTURA_CAMINHO - 1 - linha, '*');
+		}
+	}
+	vCeilingResourceGive(recurso_diamantes);
+
+	/* Desenhando a bolinha, se a linha dela estiver na janela */
+	linha = estado->bola.y / FISICA_UNIDADE - quadro->linha_base;
+	if (linha >= 0 && linha < ALTURA_CAMINHO)
+	{
+		vAnsiRendererPutChar(estado->bola.x / FISICA_UNIDADE, ALTURA_CAMINHO - 1 - linha, 'O');
+	}
+
+	vAnsiRendererPutString(coluna_placar, 0, "ZigZag");
+	vAnsiRendererPrintf(coluna_placar, 2, "Pontuacao: %d", pontuacao);
+	vAnsiRendererPrintf(coluna_placar, 3, "Diamantes: %d", coletados);
+	vAnsiRendererPrintf(coluna_placar, 4, "Sentido:   %s", direita ? "Direita" : "Esquerda");
+	if (estado->linhas_ate_queda >= 0)
+	{
+		vAnsiRendererPrintf(coluna_placar, 5, "Queda em:  %d linhas", estado->linhas_ate_queda);
+	}
+	else
+	{
+		vAnsiRendererPutString(coluna_placar, 5, "Queda em:  --");
+	}
+	vAnsiRendererPrintf(coluna_placar, 6, "Quadros:   %d", atualizacoes);
+	vAnsiRendererPrintf(coluna_placar, 7, "Caminho:   %u", (unsigned)quadro->sequencia);
+	vAnsiRendererPrintf(coluna_placar, 8, "Repetidos: %d", quadros_repetidos);
+
+	/* As mensagens das outras tarefas e a escrita no console usam o recurso do console */
+	vCeilingResourceTake(recurso_console);
+	vAnsiRendererDrawLog(ALTURA_CAMINHO + 1);
+	xAnsiRendererPresent();
+	vCeilingResourceGive(recurso_console);
+}
+
 
 /* ---------- Funções das Tarefas do Sistema ---------- */
 
@@ -288,26 +919,53 @@ void AtualizaDisplay(){
 	   Para simular o tempo de execução dessa tarefa (3ms) foi utilizado a função delay(). */
 
 	TickType_t UltimaAtualizacao;
+	const QuadroCaminho *quadro;
+	const EstadoBola *estado;
+	int atualizacoes;
 
 	while (1)
 	{
-		/* A mensagem será apresentada a cada 1s -> 50 * 20 (período da tarefa) = 1000ms = 1s */
-		if (contador_T1 % 50 == 0)
+		/* Esperando uma partida em andamento. Se for preciso esperar, o job é liberado pelo
+		   início da partida, e não no tick em que a tarefa acorda */
+		if (estado_do_jogo() != ESTADO_JOGANDO)
+		{
+			vPeriodicJobDropRelease(job_T1);
+		}
+		espera_estado(BIT_DO_ESTADO(ESTADO_JOGANDO));
+
+		vReplayJobReleased(1);
+		vPeriodicJobStart(job_T1);
+		vProfilerJobStart();
+		xBudgetJobStart();
+
+		/* Pegando o quadro mais recente do caminho. Se T2 ainda não publicou um novo,
+		   o quadro anterior é desenhado novamente. */
+		if (xTripleBufferAcquire(&buffer_caminho, (const void **)&quadro) == pdFALSE)
 		{
-			printf("-> O display foi atualizado > %d vezes \n", contador_T1);
-			fflush(stdout);
+			quadros_repetidos++;
 		}
 
+		/* Pegando a posição mais recente da bolinha */
+		xTripleBufferAcquire(&buffer_bola, (const void **)&estado);
+
 		/* Incrementando contador de T1 */
-		contador_T1++;
+		vCeilingResourceTake(recurso_contadores);
+		atualizacoes = contador_T1++;
+		vCeilingResourceGive(recurso_contadores);
+
+		/* Desenhando o quadro. Somente os caracteres que mudaram são escritos no console,
+		   com uma única escrita por quadro */
+		desenha_display(quadro, estado, atualizacoes);
 
 		/* Simulando o tempo de execução */
 		delay(E_ATUALIZA_DISPLAY);
+		vPeriodicJobEnd(job_T1);
 
 		/* Coletando o tick atual */
 		UltimaAtualizacao = xTaskGetTickCount();
 
 		/* Função que configura a periodicidade desta tarefa */
+		vPeriodicJobSetNextRelease(job_T1, UltimaAtualizacao + P_ATUALIZA_DISPLAY/2);
 		vTaskDelayUntil(&UltimaAtualizacao, P_ATUALIZA_DISPLAY/2);
 	}
 }
@@ -315,102 +973,245 @@ void AtualizaDisplay(){
 /* T2 - Cria caminho: P = D(soft) = 20ms; e = 3ms */
 void CriaCaminho(){
 	/* Essa função cria o caminho a frente que deve ser atualizado no display.
-	   Para simular o tempo de execução dessa tarefa (3ms) foi utilizado a função delay(). */
+	   O caminho é gerado em lotes de segmentos, então a maioria dos jobs apenas monta a
+	   janela e o tempo de execução é o da própria geração, sem simulação com delay(). */
 
 	TickType_t UltimaAtualizacao;
+	int atualizacoes, gerados;
 
 	while (1)
 	{
-		/* A mensagem será apresentada a cada 2s -> 100 * 20 (período da tarefa) = 2000ms = 2s */
-		if (contador_T2 % 100 == 0)
+		/* Esperando uma partida em andamento, como em T1 */
+		if (estado_do_jogo() != ESTADO_JOGANDO)
 		{
-			printf("-> O caminho foi atualizado > %d vezes \n", contador_T2);
-			fflush(stdout);
+			vPeriodicJobDropRelease(job_T2);
 		}
+		espera_estado(BIT_DO_ESTADO(ESTADO_JOGANDO));
+
+		vReplayJobReleased(2);
+		vPeriodicJobStart(job_T2);
+		vProfilerJobStart();
+		xBudgetJobStart();
 
 		/* Incrementando contador de T2 */
-		contador_T2++;
+		vCeilingResourceTake(recurso_contadores);
+		atualizacoes = contador_T2++;
+		vCeilingResourceGive(recurso_contadores);
 
-		/* Simulando o tempo de execução */
-		delay(E_CRIA_CAMINHO);
+		/* A mensagem será apresentada a cada 2s -> 100 * 20 (período da tarefa) = 2000ms = 2s */
+		if (atualizacoes % 100 == 0)
+		{
+			vCeilingResourceTake(recurso_console);
+			vAnsiRendererLog("-> O caminho foi atualizado > %d vezes", atualizacoes);
+			vCeilingResourceGive(recurso_console);
+		}
+
+		/* Montando a janela do caminho e entregando o quadro para T1 e T5 */
+		gerados = publica_caminho();
+
+		if (gerados > 0)
+		{
+			vCeilingResourceTake(recurso_console);
+			vAnsiRendererLog("-> Lote %u do caminho: %d segmentos", (unsigned)caminho.lotes, gerados);
+			vCeilingResourceGive(recurso_console);
+		}
+		vPeriodicJobEnd(job_T2);
 
 		/* Coletando o tick atual */
 		UltimaAtualizacao = xTaskGetTickCount();
 
 		/* Função que configura a periodicidade desta tarefa */
+		vPeriodicJobSetNextRelease(job_T2, UltimaAtualizacao + P_CRIA_CAMINHO / 2);
 		vTaskDelayUntil(&UltimaAtualizacao, P_CRIA_CAMINHO / 2);
 	}
 }
 
 /* T4 - Adiciona diamante: P = D(soft) = 5s; e = 0.5s */
-void AdicionaDiamante(){
-	/* Essa função adiciona um diamante novo no caminho a cada 5s.
-	   Para simular o tempo de execução dessa tarefa (0.5s) foi utilizado a função delay(). */
+BaseType_t AdicionaDiamante(void *parametros, uint32_t passo){
+	/* Essa função adiciona um diamante novo no caminho a cada 5s, perto do centro da linha
+	   mais distante da janela do caminho (a coluna é sorteada entre as três do meio).
+	   A coleta é verificada por T5 a cada movimento da bolinha.
+	   Para simular o tempo de execução dessa tarefa (0.5s) foi utilizado a função delay(),
+	   uma fatia a cada passo do job. Retorna pdTRUE enquanto o job tiver passos a executar. */
 
-	TickType_t UltimaAtualizacao;
+	const QuadroCaminho *janela;
+	const int linha = ALTURA_CAMINHO - 1;
+	int adicionado;
 
-	while (1)
+	(void)parametros;
+
+	if (passo == 0)
 	{
-		/* Simulando o tempo de execução */
-		delay(E_ADICIONA_DIAMANTE);
+		/* Fora de uma partida o job não faz nada */
+		if (estado_do_jogo() != ESTADO_JOGANDO)
+		{
+			return pdFALSE;
+		}
+
+		vReplayJobReleased(4);
+		vProfilerJobStart();
+
+		/* O job é pulado se o anterior estourou o orçamento (veja ACOES_ORCAMENTO_T4) */
+		if (xBudgetJobStart() == pdFALSE)
+		{
+			return pdFALSE;
+		}
+	}
 
-		/* A mensagem será apresentada a cada 5s (período da tarefa) */
-		printf("-> Novo Diamante!! \n");
-		fflush(stdout);
+	/* Simulando o tempo de execução, uma fatia por passo */
+	if (passo < E_ADICIONA_DIAMANTE / FATIA_ADICIONA_DIAMANTE && xBudgetJobAborted() == pdFALSE)
+	{
+		delay(FATIA_ADICIONA_DIAMANTE);
+		return pdTRUE;
+	}
 
-		/* Chamada da função que verifica se o jogador conseguiu coletar o diamante */
-		verifica_coleta_de_diamante();
+	/* Pegando a janela mais recente do caminho */
+	xTripleBufferAcquire(&buffer_caminho_diamantes, (const void **)&janela);
 
-		/* Coletando o tick atual */
-		UltimaAtualizacao = xTaskGetTickCount();
+	/* Os diamantes que ficaram para trás da bolinha voltam para a lista de livres.
+	   Um job abortado por estourar o orçamento não coloca um diamante novo. */
+	vCeilingResourceTake(recurso_diamantes);
+	expira_diamantes(&diamantes, linha_da_bola);
+	adicionado = janela->sequencia != 0 && xBudgetJobAborted() == pdFALSE
+		&& adiciona_diamante(&diamantes, janela->segmento[linha], janela->linha_base + linha,
+							 (int16_t)(janela->esquerda[linha] + MEIA_LARGURA_CAMINHO - 1 + (int)ulRandomBounded(&aleatorio_T4, 3)));
+	vCeilingResourceGive(recurso_diamantes);
 
-		/* Função que configura a periodicidade desta tarefa */
-		vTaskDelayUntil(&UltimaAtualizacao, P_ADICIONA_DIAMANTE / 2);
+	/* A mensagem será apresentada a cada 5s (período da tarefa) */
+	if (adicionado)
+	{
+		vCeilingResourceTake(recurso_console);
+		vAnsiRendererLog("-> Novo Diamante!!");
+		vCeilingResourceGive(recurso_console);
 	}
+
+	return pdFALSE;
+}
+
+#if (LIBERA_T5_EM_ALTA_RESOLUCAO == 1)
+static void marca_liberacao_T5(void *job)
+{
+	/* Chamada pela interrupção do timer de alta resolução no instante em que T5 é liberada,
+	   que fica entre dois ticks, para marcar a liberação no trace nesse instante */
+	vPeriodicJobReleaseFromISR((PeriodicJob_t *)job);
 }
+#endif
 
 /* T5 - Checa fim do jogo: P = D(hard) = 5ms; e = 1ms */
 void ChecaFimDoJogo(){
-	/* Essa função verifica se a partida chegou ao fim, ou seja, a bola caiu.
-	   Para simular o tempo de execução dessa tarefa (1ms) foi utilizado a função delay(). */
+	/* Essa função move a bolinha e verifica se a partida chegou ao fim, ou seja, a bola caiu.
+	   O tempo de execução dessa tarefa é o da própria física, sem simulação com delay(). */
 
 	TickType_t UltimaAtualizacao;
+	const QuadroCaminho *janela;
+	EstadoBola *estado;
+	int verificacoes, direita, queda, pontuacao, coletados;
+	EstadoJogo estado_atual;
+#if (LIBERA_T5_EM_ALTA_RESOLUCAO == 1)
+	uint64_t liberacao = ullHiResTimerNow();
+
+	vHiResTimerSetReleaseHook(marca_liberacao_T5, job_T5);
+#endif
 
 	while (1)
 	{
-		/* Simulando o tempo de execução */
-		delay(E_CHECA_FIM_DO_JOGO);
+		/* Esperando uma partida em andamento ou o fim dela. Só os passos da partida são jobs
+		   periódicos, então fora dela o job seguinte é liberado pelo início da partida */
+		if (estado_do_jogo() != ESTADO_JOGANDO)
+		{
+			vPeriodicJobDropRelease(job_T5);
+		}
+		estado_atual = espera_estado(BIT_DO_ESTADO(ESTADO_JOGANDO) | BIT_DO_ESTADO(ESTADO_FIM_DE_JOGO));
+
+		vReplayJobReleased(5);
+		vProfilerJobStart();
 
 		/* Coletando o tick atual */
 		UltimaAtualizacao = xTaskGetTickCount();
 
-		if (fim_de_jogo == FALSE)
+		/* Pegando a janela mais recente do caminho */
+		xTripleBufferAcquire(&buffer_caminho_fisica, (const void **)&janela);
+
+		if (estado_atual == ESTADO_JOGANDO)
 		{
+			vPeriodicJobStart(job_T5);
+
+			/* Incrementando contador de T5 e lendo o sentido escolhido pelo jogador */
+			vCeilingResourceTake(recurso_contadores);
+			verificacoes = contador_T5++;
+			direita = contador_T3;
+			vCeilingResourceGive(recurso_contadores);
+
+			/* Movendo a bolinha */
+			muda_sentido_da_bola(&bola, direita);
+			move_bola(&bola);
+			linha_da_bola = bola.y / FISICA_UNIDADE;
+
+			/* Antes da primeira janela publicada por T2 não há caminho para testar */
+			queda = (janela->sequencia != 0) ? linhas_ate_queda(&bola, janela) : -2;
+
+			if (queda == 0)
+			{
+				dispara_evento(EVENTO_BOLINHA_CAIU);
+			}
+			else
+			{
+				verifica_coleta_de_diamante(janela);
+			}
+
+			/* Entregando a posição da bolinha para T1 */
+			estado = (EstadoBola *)pvTripleBufferGetWriteBuffer(&buffer_bola);
+			estado->bola = bola;
+			estado->linhas_ate_queda = queda;
+			vTripleBufferPublish(&buffer_bola);
+
 			/* A mensagem será apresentada a cada 1s -> 200 * 5 (período da tarefa) = 1000ms = 1s */
-			if (contador_T5 % 200 == 0)
+			if (verificacoes % 200 == 0)
 			{
-				printf("-> Fim do Jogo Verificado > %d vezes \n", contador_T5);
-				fflush(stdout);
+				vCeilingResourceTake(recurso_console);
+				vAnsiRendererLog("-> Fim do Jogo Verificado > %d vezes", verificacoes);
+				vCeilingResourceGive(recurso_console);
 			}
 
-			/* Incrementando contador de T5 */
-			contador_T5++;
+			/* Pelo timer de alta resolução a liberação é marcada pela interrupção que libera T5 */
+			vPeriodicJobEnd(job_T5);
+#if (LIBERA_T5_EM_ALTA_RESOLUCAO == 0)
+			vPeriodicJobSetNextRelease(job_T5, UltimaAtualizacao + ESPERA_T5);
+#endif
 		}
 		else
 		{
-			/* A mensagem será apresentada quando ESC for pressionado, simulando fim da partida */
+			/* Lendo o resultado da partida */
+			vCeilingResourceTake(recurso_contadores);
+			pontuacao = calcula_pontuacao();
+			coletados = diamantes_coletados;
+			vCeilingResourceGive(recurso_contadores);
+
+			/* A mensagem será apresentada quando a bolinha cair ou ESC for pressionado.
+			   A tela do jogo é limpa antes, pois daqui em diante o console é usado com printf */
+			vCeilingResourceTake(recurso_console);
+			vAnsiRendererClearScreen();
 			printf("----------------------------------------- \n");
 			printf("-+-+-+-+-+-+ A bolinha caiu +-+-+-+-+-+-+ \n");
-			printf("+-+-+-+-+-+-+ Pontuacao: %d +-+-+-+-+-+-+ \n", calcula_pontuacao());
-			printf("-+-+-+-+ %d Diamantes Coletados +-+-+-+-+ \n", diamantes_coletados);
+			printf("+-+-+-+-+-+-+ Pontuacao: %d +-+-+-+-+-+-+ \n", pontuacao);
+			printf("-+-+-+-+ %d Diamantes Coletados +-+-+-+-+ \n", coletados);
 			printf("+-+-+-+-+-+-+ Fim do Jogo +-+-+-+-+-+-+-+ \n");
 			printf("----------------------------------------- \n");
+			vRunLogPrintf("fim de jogo: pontuacao %d, %d diamantes", pontuacao, coletados);
+			vCeilingResourceGive(recurso_console);
 			Sleep(2000);
 
 			finaliza_partida();
+
+			/* Em uma nova partida a bolinha continua da linha em que caiu, no centro do caminho */
+			reinicia_bola(janela);
 		}
 		/* Função que configura a periodicidade desta tarefa */
-		vTaskDelayUntil(&UltimaAtualizacao, P_CHECA_FIM_DO_JOGO / 2);
+#if (LIBERA_T5_EM_ALTA_RESOLUCAO == 1)
+		vHiResTimerDelayUntil(&liberacao, ESPERA_T5 * 1000);
+#else
+		vTaskDelayUntil(&UltimaAtualizacao, ESPERA_T5);
+#endif
 	}
 }
 
@@ -419,36 +1220,49 @@ static void LeComandoDoJogador(){
 	/* Essa função lê os comandos feitos pelo jogador.
 	   Para simular o tempo de execução dessa tarefa (3ms) foi utilizado a função delay(). */
 
+	int direita, tecla;
+
 	while (1)
 	{
+		/* Esperando uma partida em andamento, para não ler as teclas dos menus */
+		espera_estado(BIT_DO_ESTADO(ESTADO_JOGANDO));
+
+		vReplayJobReleased(3);
+		vProfilerJobStart();
+
 		/* Se alguma tecla foi pressionada */
-		if (_kbhit() != 0)
+		if (le_tecla(&tecla))
 		{
 
-			int tecla = getch();
-
 			/* Se a tecla ESC for pressionada */
 			if (tecla == 27)
 			{
-				/* Simula a queda da bolinha */
-				fim_de_jogo = TRUE;
+				/* Termina a partida, como se a bolinha tivesse caído */
+				dispara_evento(EVENTO_DESISTENCIA);
 			}
 			/* Se a barra de espaço for pressionada */
 			else if (tecla == 32)
 			{
-				if (contador_T3 == 0)
+				vCeilingResourceTake(recurso_contadores);
+				contador_T3 = !contador_T3;
+				direita = contador_T3;
+				vCeilingResourceGive(recurso_contadores);
+
+				vCeilingResourceTake(recurso_console);
+				if (direita)
 				{
-					printf("-> Mudando sentido da bolinha para > Direita \n");
-					contador_T3 = 1;
+					vAnsiRendererLog("-> Mudando sentido da bolinha para > Direita");
 				}
-				else if (contador_T3 == 1)
+				else
 				{
-					printf("-> Mudando sentido da bolinha para > Esquerda \n");
-					contador_T3 = 0;
+					vAnsiRendererLog("-> Mudando sentido da bolinha para > Esquerda");
 				}
+				vCeilingResourceGive(recurso_console);
 			}
 			else {
-				printf("-> Comando Invalido!\n");
+				vCeilingResourceTake(recurso_console);
+				vAnsiRendererLog("-> Comando Invalido!");
+				vCeilingResourceGive(recurso_console);
 			}
 		}
 		/* Deadline da tarefa de 35ms */
@@ -471,6 +1285,15 @@ int main(void)
 	See http://www.FreeRTOS.org/trace for more information. */
 	vTraceEnable(TRC_START);
 
+	/* A demo application selected from the environment runs instead of the
+	game. */
+	if (prvRunSelectedDemo() != pdFALSE)
+	{
+		return 0;
+	}
+
+	xTraceSnapshotInitialise(ARQUIVOS_DE_SNAPSHOT, SNAPSHOTS_GUARDADOS);
+
 	/* Criando as Task Handlers
 	-> T1 - Atualiza display
 	-> T2 - Cria caminho
@@ -484,30 +1307,158 @@ int main(void)
 	xTaskHandle HChecaFimDoJogo;
 
 	/* Criando as tarefas 
-	   -> Prioridades: T3 > T5 > T1 > T2 > T4 */
+	   -> Prioridades: T3 > T5 > T1 > T2 > T4
+	   -> T4 só tem tarefa própria com SUPORTE_T4 = ePeriodicJobTask. Sem ela, o orçamento e os
+	      tempos são declarados para o job de T4, e a tarefa de serviço dos timers é declarada
+	      nos recursos quando começa a executar (veja vApplicationDaemonTaskStartupHook()) */
 	xTaskCreate(AtualizaDisplay, (signed char *)"Atualiza Display", configMINIMAL_STACK_SIZE, NULL, 3, &HAtualizaDisplay);
 	xTaskCreate(CriaCaminho, (signed char *)"Cria Caminho", configMINIMAL_STACK_SIZE, NULL, 2, &HCriaCaminho);
 	xTaskCreate(LeComandoDoJogador, (signed char *)"Le Comando do Jogador", configMINIMAL_STACK_SIZE, NULL, 5, &HLeComandoDoJogador);
-	xTaskCreate(AdicionaDiamante, (signed char *)"Adiciona Diamante", configMINIMAL_STACK_SIZE, NULL, 1, &HAdicionaDiamante);
+	job_T4 = pxPeriodicJobCreate("Adiciona Diamante", AdicionaDiamante, NULL, P_ADICIONA_DIAMANTE / 2, PRIORIDADE_T4, configMINIMAL_STACK_SIZE, SUPORTE_T4);
 	xTaskCreate(ChecaFimDoJogo, (signed char *)"Checa Fim do Jogo", configMINIMAL_STACK_SIZE, NULL, 4, &HChecaFimDoJogo);
+	HAdicionaDiamante = xPeriodicJobGetTask(job_T4);
+
+	/* Os jobs de T1, T2 e T5 têm como prazo a liberação seguinte, como os de T4 */
+	job_T1 = pxPeriodicJobCreateExternal(HAtualizaDisplay, P_ATUALIZA_DISPLAY / 2);
+	job_T2 = pxPeriodicJobCreateExternal(HCriaCaminho, P_CRIA_CAMINHO / 2);
+	job_T5 = pxPeriodicJobCreateExternal(HChecaFimDoJogo, ESPERA_T5);
+
+	/* Declarando as tarefas e os recursos que cada uma usa. Os tetos dos recursos
+	   são calculados a partir dessas declarações e os tempos de bloqueio medidos
+	   alimentam a análise de tempo de resposta (T3 é esporádica: intervalo mínimo = D = 35ms). */
+	vCeilingDeclareTask(HAtualizaDisplay, E_ATUALIZA_DISPLAY, P_ATUALIZA_DISPLAY, P_ATUALIZA_DISPLAY);
+	vCeilingDeclareTask(HCriaCaminho, E_CRIA_CAMINHO, P_CRIA_CAMINHO, P_CRIA_CAMINHO);
+	vCeilingDeclareTask(HLeComandoDoJogador, 3, 35, 35);
+	if (HAdicionaDiamante != NULL)
+	{
+		vCeilingDeclareTask(HAdicionaDiamante, E_ADICIONA_DIAMANTE, P_ADICIONA_DIAMANTE, P_ADICIONA_DIAMANTE);
+	}
+	vCeilingDeclareTask(HChecaFimDoJogo, E_CHECA_FIM_DO_JOGO, P_CHECA_FIM_DO_JOGO, P_CHECA_FIM_DO_JOGO);
+
+	recurso_console = pxCeilingResourceCreate("Console", POLITICA_RECURSOS);
+	vCeilingDeclareUse(recurso_console, HAtualizaDisplay);
+	vCeilingDeclareUse(recurso_console, HCriaCaminho);
+	vCeilingDeclareUse(recurso_console, HLeComandoDoJogador);
+	if (HAdicionaDiamante != NULL)
+	{
+		vCeilingDeclareUse(recurso_console, HAdicionaDiamante);
+	}
+	vCeilingDeclareUse(recurso_console, HChecaFimDoJogo);
 
-	/* Inicializa o contador de tempo da função rand */
-	srand(time(NULL));
+	recurso_contadores = pxCeilingResourceCreate("Contadores", POLITICA_RECURSOS);
+	vCeilingDeclareUse(recurso_contadores, HAtualizaDisplay);
+	vCeilingDeclareUse(recurso_contadores, HCriaCaminho);
+	vCeilingDeclareUse(recurso_contadores, HLeComandoDoJogador);
+	if (HAdicionaDiamante != NULL)
+	{
+		vCeilingDeclareUse(recurso_contadores, HAdicionaDiamante);
+	}
+	vCeilingDeclareUse(recurso_contadores, HChecaFimDoJogo);
+
+	recurso_diamantes = pxCeilingResourceCreate("Diamantes", POLITICA_RECURSOS);
+	vCeilingDeclareUse(recurso_diamantes, HAtualizaDisplay);
+	if (HAdicionaDiamante != NULL)
+	{
+		vCeilingDeclareUse(recurso_diamantes, HAdicionaDiamante);
+	}
+	vCeilingDeclareUse(recurso_diamantes, HChecaFimDoJogo);
+
+	vCeilingComputeCeilings();
+
+	vBudgetDeclare(HAtualizaDisplay, E_ATUALIZA_DISPLAY + FOLGA_ORCAMENTO, ACOES_ORCAMENTO_T1, tskIDLE_PRIORITY);
+	vBudgetDeclare(HCriaCaminho, E_CRIA_CAMINHO + FOLGA_ORCAMENTO, ACOES_ORCAMENTO_T2, tskIDLE_PRIORITY);
+	if (HAdicionaDiamante != NULL)
+	{
+		vBudgetDeclare(HAdicionaDiamante, E_ADICIONA_DIAMANTE + FOLGA_ORCAMENTO, ACOES_ORCAMENTO_T4, tskIDLE_PRIORITY);
+	}
+	else
+	{
+		/* A tarefa de serviço dos timers é compartilhada, então não é rebaixada: o job que
+		   estoura é abortado e o seguinte é pulado */
+		vBudgetDeclareWork(job_T4, "Adiciona Diamante", E_ADICIONA_DIAMANTE + FOLGA_ORCAMENTO, ACOES_ORCAMENTO_T4);
+	}
+
+	/* Os tempos dos jobs são gravados com o nome completo de cada tarefa, que o kernel
+	   trunca em configMAX_TASK_NAME_LEN caracteres, para que Tools/pwcet.py os encontre */
+	vProfilerDeclareTask(HAtualizaDisplay, "Atualiza Display");
+	vProfilerDeclareTask(HCriaCaminho, "Cria Caminho");
+	vProfilerDeclareTask(HLeComandoDoJogador, "Le Comando do Jogador");
+	if (HAdicionaDiamante != NULL)
+	{
+		vProfilerDeclareTask(HAdicionaDiamante, "Adiciona Diamante");
+	}
+	else
+	{
+		vProfilerDeclareWork(job_T4, "Adiciona Diamante");
+	}
+	vProfilerDeclareTask(HChecaFimDoJogo, "Checa Fim do Jogo");
+
+	/* A contabilização dos orçamentos é o trabalho do tick, e precisa ser feita em todo tick */
+	xTickWorkRegister("Orcamentos", vBudgetTickHook, pdTRUE);
+
+	/* As liberações dos jobs são marcadas no trace no tick em que acontecem */
+	xTickWorkRegister("Jobs", vPeriodicJobTickHook, pdTRUE);
+
+	/* O tempo de T4 executada pela tarefa de serviço dos timers é medido a cada tick */
+	if (HAdicionaDiamante == NULL)
+	{
+		xTickWorkRegister("Tempos", vProfilerTickHook, pdTRUE);
+	}
+
+	/* Escolhendo a semente da sessão e registrando no log da execução */
+	semente_da_sessao = escolhe_semente();
+	xRunLogOpen("ZigZag.log");
+	inicializa_replay(&semente_da_sessao);
+	vRunLogPrintf("semente %llu", (unsigned long long)semente_da_sessao);
+	vRandomSeed(&aleatorio_T4, semente_da_sessao, FLUXO_DIAMANTES);
+	inicializa_filtro_do_trace();
+
+	/* A simulação com vários núcleos substitui o jogo */
+	if (simula_multicore())
+	{
+		vRunLogClose();
+		return 0;
+	}
+
+	/* Inicializa o caminho, a bolinha, os diamantes e os buffers triplos entre T2, T1, T4 e T5 */
+	vTripleBufferInitialise(&buffer_caminho, quadros_caminho, sizeof(QuadroCaminho));
+	vTripleBufferInitialise(&buffer_caminho_fisica, quadros_caminho_fisica, sizeof(QuadroCaminho));
+	vTripleBufferInitialise(&buffer_caminho_diamantes, quadros_caminho_diamantes, sizeof(QuadroCaminho));
+	vTripleBufferInitialise(&buffer_bola, estados_bola, sizeof(EstadoBola));
+	inicializa_caminho(&caminho, semente_da_sessao, FLUXO_CAMINHO);
+	inicializa_diamantes(&diamantes);
+	inicializa_bola(&bola, 0, LARGURA_CAMINHO / 2);
+
+	/* Preparando o console para o renderizador de T1 */
+	vAnsiRendererInitialise();
+	vAnsiRendererLog("-> Semente da sessao: %llu", (unsigned long long)semente_da_sessao);
+
+	/* O jogo começa no menu */
+	inicializa_estado_do_jogo(transicoes_do_jogo, sizeof(transicoes_do_jogo) / sizeof(transicoes_do_jogo[0]), ESTADO_MENU);
 
 	/* Criando o menu do jogo */
 	int menu = 0;
 
 	while (menu != 1)
 	{
-		system("cls");
+		vAnsiRendererClearScreen();
 		printf("-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+- \n");
 		printf("----------------------------   ZigZag   ----------------------------- \n");
 		printf("-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+- \n");
 		printf("                Para comecar a partida pressione - 1 - \n");
 		printf("-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+- \n");
 		printf("                            Digite aqui: ");
-		scanf("%d", &menu);
-		if (menu == 1) {
+		menu = le_opcao();
+		if (menu == OPCAO_FIM_DA_REPETICAO) {
+			/* A repetição acabou antes de a partida começar: não há o que executar, só
+			   comparar os eventos vistos até aqui com os gravados */
+			vRunLogPrintf("hash dos eventos %016llx", (unsigned long long)ullReplayGetHash());
+			vReplayFinish();
+			vRunLogPrintf("fim da sessao");
+			vRunLogClose();
+			return 0;
+		}
+		else if (menu == 1) {
 			printf("\n-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+- \n");
 			printf("   Para mudar o sentido da bolinha pressione a - barra de espaco - \n");
 			printf("-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+- \n");
@@ -522,7 +1473,8 @@ int main(void)
 		}
 	}
 
-	system("cls");
+	vAnsiRendererClearScreen();
+	dispara_evento(EVENTO_INICIA_PARTIDA);
 
 	/* Inicializa o escalonador do sistema e o programa */
 	vTaskStartScheduler();
@@ -578,13 +1530,12 @@ void vApplicationIdleHook(void)
 		}
 	*/
 
-#if (mainCREATE_SIMPLE_BLINKY_DEMO_ONLY != 1)
+	if (xFullDemoRunning != pdFALSE)
 	{
-		/* Call the idle task processing used by the full demo.  The simple
-		blinky demo does not use the idle task hook. */
+		/* Call the idle task processing used by the full demo.  The game does
+		not use it. */
 		vFullDemoIdleFunction();
 	}
-#endif
 }
 /*-----------------------------------------------------------*/
 
@@ -609,11 +1560,14 @@ void vApplicationTickHook(void)
 	added here, but the tick hook is called from an interrupt context, so
 	code must not attempt to block, and only the interrupt safe FreeRTOS API
 	functions can be used (those that end in FromISR()). */
-#if (mainCREATE_SIMPLE_BLINKY_DEMO_ONLY != 1)
-	{
-		vFullDemoTickHookFunction();
-	}
-#endif /* mainCREATE_SIMPLE_BLINKY_DEMO_ONLY */
+
+	/* Run, and time, the work registered with xTickWorkRegister() - the
+	budget accounting, and the full demo's interrupt tests when it is built. */
+	vTickWorkRun();
+
+	/* The tick hook also runs while the idle task sleeps, and the work above
+	can ready a task from it. */
+	vTicklessIdleWakeIfReady();
 }
 /*-----------------------------------------------------------*/
 
@@ -623,6 +1577,47 @@ void vApplicationDaemonTaskStartupHook(void)
 	execute	(sometimes called the timer task).  This is useful if the
 	application includes initialisation code that would benefit from executing
 	after the scheduler has been started. */
+
+	/* The rest is the game's. */
+	if (xDemoRunning != pdFALSE)
+	{
+		return;
+	}
+
+	/* Ctrl+Break generates a simulated interrupt, which can only be taken
+	now that the scheduler is running. */
+	vTraceSnapshotEnableBreak();
+
+#if (LIBERA_T5_EM_ALTA_RESOLUCAO == 1)
+	{
+		/* The daemon task has the highest priority, so this runs before T5
+		first asks for a high resolution release. */
+		xHiResTimerInitialise();
+	}
+#endif
+
+	if (ePeriodicJobGetBacking(job_T4) == ePeriodicJobTimer)
+	{
+		/* T4 runs in the daemon task, which only exists now.  Until here the
+		daemon task has the highest priority, so the code above runs before
+		any game task.  It now takes T4's place, below every game task, so the
+		steps of T4 only use the time the game tasks leave, and is declared as
+		the user of T4's resources, with T4's timing, at that priority.  The
+		scheduler is suspended so no game task can take a resource before the
+		ceilings are recomputed. */
+		TaskHandle_t xDaemon = xTimerGetTimerDaemonTaskHandle();
+
+		vTaskSuspendAll();
+		{
+			vTaskPrioritySet(NULL, PRIORIDADE_T4);
+			vCeilingDeclareTask(xDaemon, E_ADICIONA_DIAMANTE, P_ADICIONA_DIAMANTE, P_ADICIONA_DIAMANTE);
+			vCeilingDeclareUse(recurso_console, xDaemon);
+			vCeilingDeclareUse(recurso_contadores, xDaemon);
+			vCeilingDeclareUse(recurso_diamantes, xDaemon);
+			vCeilingComputeCeilings();
+		}
+		xTaskResumeAll();
+	}
 }
 /*-----------------------------------------------------------*/
 
@@ -668,6 +1663,40 @@ void vAssertCalled(unsigned long ulLine, const char *const pcFileName)
 }
 /*-----------------------------------------------------------*/
 
+static BaseType_t prvRunSelectedDemo(void)
+{
+	const char *pcDemo = getenv(mainDEMO_VARIABLE);
+
+	if (pcDemo == NULL)
+	{
+		return pdFALSE;
+	}
+
+	if (strcmp(pcDemo, mainDEMO_BLINKY) == 0)
+	{
+		/* The blinky demo does not use the hook functions.  Its IPC benchmark
+		mode exits the process once every case has run. */
+		xDemoRunning = pdTRUE;
+		main_blinky();
+	}
+	else if (strcmp(pcDemo, mainDEMO_FULL) == 0)
+	{
+		/* main_full() exits the process at the end of its run window, so only
+		returns if the scheduler could not be started. */
+		xDemoRunning = pdTRUE;
+		xFullDemoRunning = pdTRUE;
+		main_full();
+	}
+	else
+	{
+		printf("Unknown %s \"%s\" - set it to \"%s\" or \"%s\", or leave it unset to play the game\r\n", mainDEMO_VARIABLE, pcDemo,
+			   mainDEMO_BLINKY, mainDEMO_FULL);
+	}
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
 static void prvSaveTraceFile(void)
 {
 	FILE *pxOutputFile;
@@ -35,10 +35,10 @@
  *
  * NOTE 2:  This project provides two demo applications.  A simple blinky style
  * project, and a more comprehensive test and demo application.  The
- * mainCREATE_SIMPLE_BLINKY_DEMO_ONLY setting in main.c is used to select
- * between the two.  See the notes on using mainCREATE_SIMPLE_BLINKY_DEMO_ONLY
- * in main.c.  This file implements the simply blinky version.  Console output
- * is used in place of the normal LED toggling.
+ * environment variable named by mainDEMO_VARIABLE in main.c is used to select
+ * between the two and the game.  See the notes on using mainDEMO_VARIABLE in
+ * main.c.  This file implements the simply blinky version.  Console output is
+ * used in place of the normal LED toggling.
  *
  * NOTE 3:  This file only contains the source code that is specific to the
  * basic demo.  Generic functions, such FreeRTOS hook functions, are defined
@@ -76,6 +76,28 @@
  *   pressed then the queue receive task will output a message indicating that
  *   data was received on the queue from the queue send software timer.
  *
+ * IPC Benchmark Mode:
+ * If the environment variable named by mainBENCHMARK_VARIABLE is set then
+ * main_blinky() runs a throughput and latency benchmark of the kernel's
+ * message passing primitives instead of the demo above.  The benchmark control
+ * task runs one case after another.  Each case has one sender task and one
+ * receiver task passing items through a queue, a task notification, a stream
+ * buffer, a message buffer or a zero copy channel (see ZeroCopy.h), with a
+ * given payload size, depth (the number of items the primitive can hold) and
+ * priority relationship between the sender and the receiver.  The zero copy
+ * channel's pool has two buffers more than its depth, for the one the sender
+ * is filling and the one the receiver is reading.  The sender sends as fast
+ * as the primitive lets it, and stamps each item with the host performance
+ * counter just before sending it.  The receiver counts the items and measures
+ * the send-to-receive latency of each one, which includes any time the sender
+ * was blocked waiting for space and the item then waited in the primitive.
+ * Each case runs for mainBENCHMARK_CASE_MS milliseconds, or for the number of
+ * milliseconds the variable is set to.  A task notification holds a single
+ * 32-bit value, so it is only run with a 4 byte payload and a depth of 1, and
+ * the receiver notifies the sender back each time the value is free.  The
+ * results are printed and written to mainBENCHMARK_RESULT_FILE, and then the
+ * process exits - with EXIT_FAILURE if any case could not be created.
+ *
  * NOTE:  Console input and output relies on Windows system calls, which can
  * interfere with the execution of the FreeRTOS Windows port.  This demo only
  * uses Windows system call occasionally.  Heavier use of Windows system calls
@@ -84,6 +106,8 @@
 
 /* Standard includes. */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <conio.h>
 
 /* Kernel includes. */
@@ -91,6 +115,11 @@
 #include "task.h"
 #include "timers.h"
 #include "semphr.h"
+#include "stream_buffer.h"
+#include "message_buffer.h"
+
+/* Demo includes. */
+#include "ZeroCopy.h"
 
 /* Priorities at which the tasks are created. */
 #define mainQUEUE_RECEIVE_TASK_PRIORITY		( tskIDLE_PRIORITY + 2 )
@@ -109,6 +138,60 @@ queue send software timer respectively. */
 #define mainVALUE_SENT_FROM_TASK			( 100UL )
 #define mainVALUE_SENT_FROM_TIMER			( 200UL )
 
+/* The benchmark mode described at the top of this file.  The control task
+runs above the sender and receiver, which run at mainBENCHMARK_LOW_PRIORITY
+and, when one has priority over the other, mainBENCHMARK_HIGH_PRIORITY. */
+#define mainBENCHMARK_VARIABLE				"BLINKY_IPC_BENCHMARK"
+#define mainBENCHMARK_CASE_MS				( 200UL )
+#define mainBENCHMARK_RESULT_FILE			"IpcBenchmark.csv"
+#define mainBENCHMARK_CONTROL_PRIORITY		( configMAX_PRIORITIES - 2 )
+#define mainBENCHMARK_HIGH_PRIORITY			( tskIDLE_PRIORITY + 2 )
+#define mainBENCHMARK_LOW_PRIORITY			( tskIDLE_PRIORITY + 1 )
+
+/* The largest payload, which must be at least the 4 bytes of the time
+stamp, and the largest depth. */
+#define mainBENCHMARK_MAX_PAYLOAD			( 256 )
+#define mainBENCHMARK_MAX_DEPTH				( 32 )
+
+typedef enum
+{
+	eBenchmarkQueue = 0,
+	eBenchmarkNotification,
+	eBenchmarkStreamBuffer,
+	eBenchmarkMessageBuffer,
+	eBenchmarkZeroCopy,
+	eBenchmarkPrimitiveCount
+} BenchmarkPrimitive_t;
+
+typedef enum
+{
+	eBenchmarkSenderHigher = 0,
+	eBenchmarkEqual,
+	eBenchmarkReceiverHigher,
+	eBenchmarkRelationCount
+} BenchmarkRelation_t;
+
+typedef struct BENCHMARK_CASE
+{
+	BenchmarkPrimitive_t ePrimitive;
+	size_t xPayload;
+	UBaseType_t uxDepth;
+	BenchmarkRelation_t eRelation;
+
+	/* The primitive, and the tasks passing items through it. */
+	QueueHandle_t xQueue;				/* Also used for zero copy channels. */
+	StreamBufferHandle_t xStreamBuffer;	/* Also used for message buffers. */
+	ZeroCopyPool_t xPool;
+	TaskHandle_t xSender;
+	TaskHandle_t xReceiver;
+
+	/* Written by the receiver, in host performance counter counts. */
+	uint32_t ulItems;
+	uint32_t ulMinLatency;
+	uint32_t ulMaxLatency;
+	uint64_t ullTotalLatency;
+} BenchmarkCase_t;
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -122,6 +205,27 @@ static void prvQueueSendTask( void *pvParameters );
  */
 static void prvQueueSendTimerCallback( TimerHandle_t xTimerHandle );
 
+/*
+ * The tasks of the benchmark mode described at the top of this file.  The
+ * parameter of the sender and receiver is the BenchmarkCase_t being run.
+ */
+static void prvBenchmarkControlTask( void *pvParameters );
+static void prvBenchmarkSendTask( void *pvParameters );
+static void prvBenchmarkReceiveTask( void *pvParameters );
+
+/*
+ * Create the primitive and tasks of pxCase, let it run for xDuration ticks,
+ * then delete them again.  Returns pdFAIL if the case could not be created.
+ * *pullElapsed is set to the length of the run in performance counter counts.
+ */
+static BaseType_t prvRunBenchmarkCase( BenchmarkCase_t *pxCase, TickType_t xDuration, uint64_t *pullElapsed );
+
+/*
+ * The low 32 bits of the host performance counter, which are enough to time
+ * one item.
+ */
+static uint32_t prvBenchmarkTimeStamp( void );
+
 /*-----------------------------------------------------------*/
 
 /* The queue used by both tasks. */
@@ -130,6 +234,15 @@ static QueueHandle_t xQueue = NULL;
 /* A software timer that is started from the tick hook. */
 static TimerHandle_t xTimer = NULL;
 
+/* The parameters every benchmark case is run with. */
+static const size_t xBenchmarkPayloads[] = { 4, 16, 64, mainBENCHMARK_MAX_PAYLOAD };
+static const UBaseType_t uxBenchmarkDepths[] = { 1, 8, mainBENCHMARK_MAX_DEPTH };
+static const char * const pcBenchmarkPrimitiveNames[ eBenchmarkPrimitiveCount ] = { "Queue", "Notification", "StreamBuffer", "MessageBuffer", "ZeroCopy" };
+
+/* The storage of the zero copy channel's pool, aligned by its type. */
+static uint64_t ullBenchmarkPoolStorage[ zerocopySTORAGE_SIZE( mainBENCHMARK_MAX_DEPTH + 2, mainBENCHMARK_MAX_PAYLOAD ) / sizeof( uint64_t ) ];
+static const char * const pcBenchmarkRelationNames[ eBenchmarkRelationCount ] = { "sender>receiver", "sender=receiver", "sender<receiver" };
+
 /*-----------------------------------------------------------*/
 
 /*** SEE THE COMMENTS AT THE TOP OF THIS FILE ***/
@@ -137,6 +250,15 @@ void main_blinky( void )
 {
 const TickType_t xTimerPeriod = mainTIMER_SEND_FREQUENCY_MS;
 
+	if( getenv( mainBENCHMARK_VARIABLE ) != NULL )
+	{
+		/* Run the benchmark instead of the demo.  The control task creates the
+		tasks of each case itself. */
+		xTaskCreate( prvBenchmarkControlTask, "Bench", configMINIMAL_STACK_SIZE, NULL, mainBENCHMARK_CONTROL_PRIORITY, NULL );
+		vTaskStartScheduler();
+		for( ;; );
+	}
+
 	/* Create the queue. */
 	xQueue = xQueueCreate( mainQUEUE_LENGTH, sizeof( uint32_t ) );
 
@@ -270,3 +392,345 @@ uint32_t ulReceivedValue;
 /*-----------------------------------------------------------*/
 
 
+
+static void prvBenchmarkControlTask( void *pvParameters )
+{
+static BenchmarkCase_t xCase;
+TickType_t xDuration = pdMS_TO_TICKS( mainBENCHMARK_CASE_MS );
+const char *pcCaseMs;
+LARGE_INTEGER liFrequency;
+uint64_t ullElapsed;
+double dCountsPerMicrosecond, dItemsPerSecond, dMean, dMin, dMax;
+BaseType_t xAllCreated = pdTRUE;
+int iPrimitive, iRelation;
+size_t xPayload, xDepth;
+FILE *pxFile;
+
+	/* Prevent the compiler warning about the unused parameter. */
+	( void ) pvParameters;
+
+	/* The length of each case can be set in milliseconds from the
+	environment. */
+	pcCaseMs = getenv( mainBENCHMARK_VARIABLE );
+
+	if( ( pcCaseMs != NULL ) && ( atol( pcCaseMs ) > 0L ) )
+	{
+		xDuration = pdMS_TO_TICKS( ( TickType_t ) atol( pcCaseMs ) );
+	}
+
+	QueryPerformanceFrequency( &liFrequency );
+	dCountsPerMicrosecond = ( double ) liFrequency.QuadPart / 1000000.0;
+
+	pxFile = fopen( mainBENCHMARK_RESULT_FILE, "w" );
+
+	if( pxFile != NULL )
+	{
+		fprintf( pxFile, "primitive,payload_bytes,depth,priorities,items,items_per_s,latency_min_us,latency_mean_us,latency_max_us\n" );
+	}
+
+	printf( "Primitive      Payload  Depth  Priorities          Items     Items/s  Min (us)  Mean (us)  Max (us)\r\n" );
+
+	for( iPrimitive = 0; iPrimitive < ( int ) eBenchmarkPrimitiveCount; iPrimitive++ )
+	{
+		for( iRelation = 0; iRelation < ( int ) eBenchmarkRelationCount; iRelation++ )
+		{
+			for( xPayload = 0; xPayload < ( sizeof( xBenchmarkPayloads ) / sizeof( xBenchmarkPayloads[ 0 ] ) ); xPayload++ )
+			{
+				for( xDepth = 0; xDepth < ( sizeof( uxBenchmarkDepths ) / sizeof( uxBenchmarkDepths[ 0 ] ) ); xDepth++ )
+				{
+					/* A notification holds a single 32-bit value. */
+					if( ( iPrimitive == ( int ) eBenchmarkNotification ) &&
+						( ( xBenchmarkPayloads[ xPayload ] != sizeof( uint32_t ) ) || ( uxBenchmarkDepths[ xDepth ] != 1 ) ) )
+					{
+						continue;
+					}
+
+					memset( &xCase, 0x00, sizeof( xCase ) );
+					xCase.ePrimitive = ( BenchmarkPrimitive_t ) iPrimitive;
+					xCase.eRelation = ( BenchmarkRelation_t ) iRelation;
+					xCase.xPayload = xBenchmarkPayloads[ xPayload ];
+					xCase.uxDepth = uxBenchmarkDepths[ xDepth ];
+
+					if( prvRunBenchmarkCase( &xCase, xDuration, &ullElapsed ) != pdPASS )
+					{
+						printf( "%-13s  %7u  %5u  %-15s  could not be created\r\n", pcBenchmarkPrimitiveNames[ iPrimitive ],
+								( unsigned ) xCase.xPayload, ( unsigned ) xCase.uxDepth, pcBenchmarkRelationNames[ iRelation ] );
+						xAllCreated = pdFALSE;
+						continue;
+					}
+
+					dItemsPerSecond = ( double ) xCase.ulItems * 1000000.0 * dCountsPerMicrosecond / ( double ) ullElapsed;
+					dMin = 0.0;
+					dMean = 0.0;
+					dMax = 0.0;
+
+					if( xCase.ulItems > 0UL )
+					{
+						dMin = ( double ) xCase.ulMinLatency / dCountsPerMicrosecond;
+						dMean = ( ( double ) xCase.ullTotalLatency / ( double ) xCase.ulItems ) / dCountsPerMicrosecond;
+						dMax = ( double ) xCase.ulMaxLatency / dCountsPerMicrosecond;
+					}
+
+					printf( "%-13s  %7u  %5u  %-15s  %9lu  %10.0f  %8.2f  %9.2f  %8.2f\r\n", pcBenchmarkPrimitiveNames[ iPrimitive ],
+							( unsigned ) xCase.xPayload, ( unsigned ) xCase.uxDepth, pcBenchmarkRelationNames[ iRelation ],
+							( unsigned long ) xCase.ulItems, dItemsPerSecond, dMin, dMean, dMax );
+
+					if( pxFile != NULL )
+					{
+						fprintf( pxFile, "%s,%u,%u,%s,%lu,%.1f,%.3f,%.3f,%.3f\n", pcBenchmarkPrimitiveNames[ iPrimitive ],
+								 ( unsigned ) xCase.xPayload, ( unsigned ) xCase.uxDepth, pcBenchmarkRelationNames[ iRelation ],
+								 ( unsigned long ) xCase.ulItems, dItemsPerSecond, dMin, dMean, dMax );
+					}
+				}
+			}
+		}
+	}
+
+	if( pxFile != NULL )
+	{
+		fclose( pxFile );
+	}
+	else
+	{
+		printf( "Could not write %s\r\n", mainBENCHMARK_RESULT_FILE );
+	}
+
+	fflush( stdout );
+
+	/* vTaskEndScheduler() can not return an exit code, so the process is
+	exited directly. */
+	exit( ( xAllCreated != pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRunBenchmarkCase( BenchmarkCase_t *pxCase, TickType_t xDuration, uint64_t *pullElapsed )
+{
+UBaseType_t uxSenderPriority = mainBENCHMARK_LOW_PRIORITY, uxReceiverPriority = mainBENCHMARK_LOW_PRIORITY;
+BaseType_t xReturn = pdPASS;
+LARGE_INTEGER liStart, liEnd;
+
+	if( pxCase->eRelation == eBenchmarkSenderHigher )
+	{
+		uxSenderPriority = mainBENCHMARK_HIGH_PRIORITY;
+	}
+	else if( pxCase->eRelation == eBenchmarkReceiverHigher )
+	{
+		uxReceiverPriority = mainBENCHMARK_HIGH_PRIORITY;
+	}
+
+	pxCase->ulMinLatency = UINT32_MAX;
+
+	switch( pxCase->ePrimitive )
+	{
+		case eBenchmarkQueue:
+			pxCase->xQueue = xQueueCreate( pxCase->uxDepth, pxCase->xPayload );
+			xReturn = ( pxCase->xQueue != NULL ) ? pdPASS : pdFAIL;
+			break;
+
+		case eBenchmarkStreamBuffer:
+			/* The receiver is woken once a whole item has been written. */
+			pxCase->xStreamBuffer = xStreamBufferCreate( pxCase->uxDepth * pxCase->xPayload, pxCase->xPayload );
+			xReturn = ( pxCase->xStreamBuffer != NULL ) ? pdPASS : pdFAIL;
+			break;
+
+		case eBenchmarkMessageBuffer:
+			/* Each message is stored with its length. */
+			pxCase->xStreamBuffer = xMessageBufferCreate( pxCase->uxDepth * ( pxCase->xPayload + sizeof( size_t ) ) );
+			xReturn = ( pxCase->xStreamBuffer != NULL ) ? pdPASS : pdFAIL;
+			break;
+
+		case eBenchmarkZeroCopy:
+			pxCase->xQueue = xZeroCopyChannelCreate( pxCase->uxDepth );
+			xReturn = ( pxCase->xQueue != NULL ) ? pdPASS : pdFAIL;
+
+			if( xReturn == pdPASS )
+			{
+				xReturn = xZeroCopyPoolCreate( &( pxCase->xPool ), ullBenchmarkPoolStorage, pxCase->xPayload, pxCase->uxDepth + 2 );
+			}
+			break;
+
+		default:
+			/* A notification uses the receiving task itself. */
+			break;
+	}
+
+	/* Neither task runs before this task blocks, as this task has the higher
+	priority. */
+	if( xReturn == pdPASS )
+	{
+		xReturn = xTaskCreate( prvBenchmarkReceiveTask, "BRx", configMINIMAL_STACK_SIZE, pxCase, uxReceiverPriority, &( pxCase->xReceiver ) );
+	}
+
+	if( xReturn == pdPASS )
+	{
+		xReturn = xTaskCreate( prvBenchmarkSendTask, "BTx", configMINIMAL_STACK_SIZE, pxCase, uxSenderPriority, &( pxCase->xSender ) );
+	}
+
+	if( xReturn == pdPASS )
+	{
+		QueryPerformanceCounter( &liStart );
+		vTaskDelay( xDuration );
+		QueryPerformanceCounter( &liEnd );
+		*pullElapsed = ( uint64_t ) ( liEnd.QuadPart - liStart.QuadPart );
+	}
+
+	/* This task preempts the sender and receiver as soon as the case ends, so
+	neither runs again before it is deleted, and the receiver's counts are
+	final.  A task blocked on the primitive is deleted before the primitive
+	is. */
+	if( pxCase->xSender != NULL )
+	{
+		vTaskDelete( pxCase->xSender );
+	}
+
+	if( pxCase->xReceiver != NULL )
+	{
+		vTaskDelete( pxCase->xReceiver );
+	}
+
+	if( pxCase->xQueue != NULL )
+	{
+		vQueueDelete( pxCase->xQueue );
+	}
+
+	if( pxCase->xStreamBuffer != NULL )
+	{
+		vStreamBufferDelete( pxCase->xStreamBuffer );
+	}
+
+	/* Buffers held by the deleted tasks are not returned, so the whole pool
+	goes. */
+	vZeroCopyPoolDelete( &( pxCase->xPool ) );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkSendTask( void *pvParameters )
+{
+BenchmarkCase_t *pxCase = ( BenchmarkCase_t * ) pvParameters;
+uint8_t ucItem[ mainBENCHMARK_MAX_PAYLOAD ];
+uint32_t ulTimeStamp;
+void *pvBuffer;
+
+	memset( ucItem, 0x00, sizeof( ucItem ) );
+
+	for( ;; )
+	{
+		/* The time stamp is taken before the send, so the latency includes any
+		time the sender is blocked waiting for space. */
+		ulTimeStamp = prvBenchmarkTimeStamp();
+		memcpy( ucItem, &ulTimeStamp, sizeof( ulTimeStamp ) );
+
+		switch( pxCase->ePrimitive )
+		{
+			case eBenchmarkQueue:
+				xQueueSend( pxCase->xQueue, ucItem, portMAX_DELAY );
+				break;
+
+			case eBenchmarkNotification:
+				/* The value is free, as the receiver has notified this task
+				since the previous one was sent. */
+				xTaskNotify( pxCase->xReceiver, ulTimeStamp, eSetValueWithOverwrite );
+				ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+				break;
+
+			case eBenchmarkStreamBuffer:
+				xStreamBufferSend( pxCase->xStreamBuffer, ucItem, pxCase->xPayload, portMAX_DELAY );
+				break;
+
+			case eBenchmarkMessageBuffer:
+				xMessageBufferSend( pxCase->xStreamBuffer, ucItem, pxCase->xPayload, portMAX_DELAY );
+				break;
+
+			default:
+				/* The item is written in place, so only the time stamp is
+				written and only the pointer is sent. */
+				pvBuffer = pvZeroCopyAllocate( &( pxCase->xPool ), portMAX_DELAY );
+				memcpy( pvBuffer, &ulTimeStamp, sizeof( ulTimeStamp ) );
+				xZeroCopySend( pxCase->xQueue, pvBuffer, portMAX_DELAY );
+				break;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmarkReceiveTask( void *pvParameters )
+{
+BenchmarkCase_t *pxCase = ( BenchmarkCase_t * ) pvParameters;
+uint8_t ucItem[ mainBENCHMARK_MAX_PAYLOAD ];
+uint32_t ulTimeStamp, ulLatency;
+size_t xReceived;
+void *pvBuffer;
+
+	for( ;; )
+	{
+		switch( pxCase->ePrimitive )
+		{
+			case eBenchmarkQueue:
+				xQueueReceive( pxCase->xQueue, ucItem, portMAX_DELAY );
+				xReceived = pxCase->xPayload;
+				break;
+
+			case eBenchmarkNotification:
+				xTaskNotifyWait( 0UL, 0UL, &ulTimeStamp, portMAX_DELAY );
+				memcpy( ucItem, &ulTimeStamp, sizeof( ulTimeStamp ) );
+				xReceived = sizeof( ulTimeStamp );
+				break;
+
+			case eBenchmarkStreamBuffer:
+				/* The sender writes whole items, and the trigger level is one
+				item, so whole items are received. */
+				xReceived = xStreamBufferReceive( pxCase->xStreamBuffer, ucItem, pxCase->xPayload, portMAX_DELAY );
+				break;
+
+			case eBenchmarkMessageBuffer:
+				xReceived = xMessageBufferReceive( pxCase->xStreamBuffer, ucItem, sizeof( ucItem ), portMAX_DELAY );
+				break;
+
+			default:
+				/* The item is read in place, so only the time stamp is read
+				before the buffer goes back to the pool. */
+				pvBuffer = pvZeroCopyReceive( pxCase->xQueue, portMAX_DELAY );
+				memcpy( ucItem, pvBuffer, sizeof( ulTimeStamp ) );
+				vZeroCopyRelease( pvBuffer );
+				xReceived = pxCase->xPayload;
+				break;
+		}
+
+		configASSERT( xReceived == pxCase->xPayload );
+
+		memcpy( &ulTimeStamp, ucItem, sizeof( ulTimeStamp ) );
+		ulLatency = prvBenchmarkTimeStamp() - ulTimeStamp;
+
+		pxCase->ulItems++;
+		pxCase->ullTotalLatency += ulLatency;
+
+		if( ulLatency < pxCase->ulMinLatency )
+		{
+			pxCase->ulMinLatency = ulLatency;
+		}
+
+		if( ulLatency > pxCase->ulMaxLatency )
+		{
+			pxCase->ulMaxLatency = ulLatency;
+		}
+
+		if( pxCase->ePrimitive == eBenchmarkNotification )
+		{
+			/* Let the sender send the next value. */
+			xTaskNotifyGive( pxCase->xSender );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBenchmarkTimeStamp( void )
+{
+LARGE_INTEGER liNow;
+
+	QueryPerformanceCounter( &liNow );
+
+	return ( uint32_t ) liNow.QuadPart;
+}
+/*-----------------------------------------------------------*/
@@ -41,9 +41,9 @@
  *
  * NOTE 2:  This project provides two demo applications.  A simple blinky style
  * project, and a more comprehensive test and demo application.  The
- * mainCREATE_SIMPLE_BLINKY_DEMO_ONLY setting in main.c is used to select
- * between the two.  See the notes on using mainCREATE_SIMPLE_BLINKY_DEMO_ONLY
- * in main.c.  This file implements the comprehensive test and demo version.
+ * environment variable named by mainDEMO_VARIABLE in main.c is used to select
+ * between the two and the game.  See the notes on using mainDEMO_VARIABLE in
+ * main.c.  This file implements the comprehensive test and demo version.
  *
  * NOTE 3:  This file only contains the source code that is specific to the
  * basic demo.  Generic functions, such FreeRTOS hook functions, are defined in
@@ -58,12 +58,30 @@
  * In addition to the standard demo tasks, the following tasks and tests are
  * defined and/or created within this file:
  *
- * "Check" task - This only executes every five seconds but has a high priority
- * to ensure it gets processor time.  Its main function is to check that all the
- * standard demo tasks are still operational.  While no errors have been
- * discovered the check task will print out "OK" and the current simulated tick
- * time.  If an error is discovered in the execution of a task then the check
- * task will print out an appropriate error message.
+ * "Check" task - This runs the standard demo tasks as a timed regression test
+ * and benchmark.  It executes every two and a half seconds but has a high
+ * priority to ensure it gets processor time.  Each time it checks that every
+ * standard demo is still operational and prints the tick count, the free heap
+ * and the names of any demos that have failed.  Once the run window
+ * (mainRUN_WINDOW_MS, or the number of seconds in the environment variable
+ * named by mainRUN_WINDOW_VARIABLE) has elapsed it prints the result of every
+ * demo, writes them to mainRESULT_FILE, and exits the process with
+ * EXIT_FAILURE if any demo failed, or EXIT_SUCCESS if they all passed.
+ *
+ * The tasks each demo creates when it is started are tagged with the demo, so
+ * the processor time of its tasks can be added up, and each demo is reported
+ * with the share of the processor time it took during the run.  Tasks that
+ * belong to no demo - the kernel's own, those created in this file, and those
+ * the demos create while they run - are reported as "Other".  The demos keep
+ * the counters of the loops they complete private to the standard demo
+ * sources, and only expose them through their check functions, so the number
+ * of operations each demo completes is not reported; the number of checks it
+ * passed, one every two and a half seconds while its counters advance, is.
+ *
+ * If the environment variable named by mainIRQ_LATENCY_VARIABLE is set, the
+ * interrupt latency harness (see IrqLatency.h) also runs during the window,
+ * and its latencies are printed and written to mainIRQ_LATENCY_FILE at the
+ * end of the run.  Its tasks are counted as "Other".
  *
  */
 
@@ -71,6 +89,7 @@
 /* Standard includes. */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* Kernel includes. */
 #include <FreeRTOS.h>
@@ -106,6 +125,10 @@
 #include "StreamBufferInterrupt.h"
 #include "MessageBufferAMP.h"
 
+/* Demo includes. */
+#include "TickWork.h"
+#include "IrqLatency.h"
+
 /* Priorities at which the tasks are created. */
 #define mainCHECK_TASK_PRIORITY			( configMAX_PRIORITIES - 2 )
 #define mainQUEUE_POLL_PRIORITY			( tskIDLE_PRIORITY + 1 )
@@ -120,9 +143,66 @@
 
 #define mainTIMER_TEST_PERIOD			( 50 )
 
+/* The length of the run and the file the results are written to. */
+#define mainRUN_WINDOW_MS				( 60000UL )
+#define mainRUN_WINDOW_VARIABLE			"FULL_DEMO_WINDOW_S"
+
+/* The environment variable that sets the budget of the tick hook's work, in
+microseconds per tick - see TickWork.h.  There is no budget if it is not
+set. */
+#define mainTICK_BUDGET_VARIABLE		"FULL_DEMO_TICK_BUDGET_US"
+#define mainRESULT_FILE					"FullDemoResults.csv"
+
+/* The environment variable that runs the interrupt latency harness alongside
+the demos, taking the given number of samples of each case - see
+IrqLatency.h.  The harness's background task runs at the priority of the
+blocking queue tasks. */
+#define mainIRQ_LATENCY_VARIABLE		"FULL_DEMO_IRQ_LATENCY"
+#define mainIRQ_LATENCY_PRIORITY		( tskIDLE_PRIORITY + 2 )
+#define mainIRQ_LATENCY_FILE			"IrqLatency.csv"
+
+/* The most tasks the results are gathered from. */
+#define mainMAX_TASKS					( 100 )
+
+/* The standard demos, in the order main_full() starts them. */
+typedef BaseType_t ( *DemoCheckFunction_t )( void );
+
+typedef struct DEMO_DEFINITION
+{
+	const char *pcName;
+	DemoCheckFunction_t pxCheck;	/* Returns pdPASS while the demo is operational. */
+} DemoDefinition_t;
+
 /* Task function prototypes. */
 static void prvCheckTask( void *pvParameters );
 
+/*
+ * The TimerDemo check needs the interval between checks, so is called through
+ * this function.
+ */
+static BaseType_t prvCheckTimerDemo( void );
+
+/*
+ * Tag every task that has not been tagged yet with uxDemo, which is an index
+ * into xDemos[], or mainNO_DEMO for the tasks created in this file.
+ */
+static void prvAttributeNewTasks( UBaseType_t uxDemo );
+
+/*
+ * Print the results of the run and write them to mainRESULT_FILE, then exit
+ * the process with the result of the run.  xElapsed is the length of the run
+ * in ticks.
+ */
+static void prvFinishRun( TickType_t xElapsed );
+
+/*
+ * Register the interrupt level tests of the standard demos as the work of the
+ * tick hook, which is defined in main.c.  prvCheckTimerTaskPriorityFromISR()
+ * is one of them.
+ */
+static void prvRegisterTickWork( void );
+static void prvCheckTimerTaskPriorityFromISR( void );
+
 /* A task that is created from the idle task to test the functionality of
 eTaskStateGet(). */
 static void prvTestTask( void *pvParameters );
@@ -174,44 +254,148 @@ static char *pcStatusMessage = "No errors";
 semaphore tracing API functions.  It has no other purpose. */
 static SemaphoreHandle_t xMutexToDelete = NULL;
 
+static const DemoDefinition_t xDemos[] =
+{
+	{ "TaskNotify",				xAreTaskNotificationTasksStillRunning },
+	{ "BlockQ",					xAreBlockingQueuesStillRunning },
+	{ "SemTest",				xAreSemaphoreTasksStillRunning },
+	{ "PollQ",					xArePollingQueuesStillRunning },
+	{ "IntMath",				xAreIntegerMathsTaskStillRunning },
+	{ "GenQTest",				xAreGenericQueueTasksStillRunning },
+	{ "QPeek",					xAreQueuePeekTasksStillRunning },
+	{ "Flop",					xAreMathsTaskStillRunning },
+	{ "RecMutex",				xAreRecursiveMutexTasksStillRunning },
+	{ "CountSem",				xAreCountingSemaphoreTasksStillRunning },
+	{ "Dynamic",				xAreDynamicPriorityTasksStillRunning },
+	{ "QueueSet",				xAreQueueSetTasksStillRunning },
+	{ "QueueOverwrite",			xIsQueueOverwriteTaskStillRunning },
+	{ "EventGroups",			xAreEventGroupTasksStillRunning },
+	{ "IntSem",					xAreInterruptSemaphoreTasksStillRunning },
+	{ "QueueSetPolling",		xAreQueueSetPollTasksStillRunning },
+	{ "BlockTime",				xAreBlockTimeTestTasksStillRunning },
+	{ "AbortDelay",				xAreAbortDelayTestTasksStillRunning },
+	{ "MessageBuffer",			xAreMessageBufferTasksStillRunning },
+	{ "StreamBuffer",			xAreStreamBufferTasksStillRunning },
+	{ "StreamBufferISR",		xIsInterruptStreamBufferDemoStillRunning },
+	{ "MessageBufferAMP",		xAreMessageBufferAMPTasksStillRunning },
+	#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+		{ "StaticAllocation",	xAreStaticAllocationTasksStillRunning },
+	#endif
+	#if( configUSE_PREEMPTION != 0 )
+		{ "TimerDemo",			prvCheckTimerDemo },
+	#endif
+	{ "Death",					xIsCreateTaskStillRunning }
+};
+
+#define mainDEMO_COUNT					( sizeof( xDemos ) / sizeof( xDemos[ 0 ] ) )
+#define mainNO_DEMO						( ( UBaseType_t ) mainDEMO_COUNT )
+
+/* The result of each demo so far. */
+static uint32_t ulChecksPassed[ mainDEMO_COUNT ];
+static BaseType_t xDemoFailed[ mainDEMO_COUNT ];
+static TickType_t xFailedAt[ mainDEMO_COUNT ];
+
+/* The length of the run. */
+static TickType_t xRunWindow = pdMS_TO_TICKS( mainRUN_WINDOW_MS );
+
+/* Whether the interrupt latency harness was started. */
+static BaseType_t xIrqLatencyStarted = pdFALSE;
+
+static TaskStatus_t xTaskStatus[ mainMAX_TASKS ];
+
 /*-----------------------------------------------------------*/
 
 int main_full( void )
 {
+UBaseType_t uxDemo = 0;
+const char *pcWindow, *pcTickBudget, *pcIrqLatency;
+
+	/* The length of the run can be set in seconds from the environment. */
+	pcWindow = getenv( mainRUN_WINDOW_VARIABLE );
+
+	if( ( pcWindow != NULL ) && ( atol( pcWindow ) > 0L ) )
+	{
+		xRunWindow = pdMS_TO_TICKS( ( TickType_t ) atol( pcWindow ) * 1000UL );
+	}
+
+	/* So can the budget of the tick hook. */
+	prvRegisterTickWork();
+	pcTickBudget = getenv( mainTICK_BUDGET_VARIABLE );
+
+	if( ( pcTickBudget != NULL ) && ( atol( pcTickBudget ) > 0L ) )
+	{
+		vTickWorkSetBudget( ( uint32_t ) atol( pcTickBudget ) );
+	}
+
 	/* Start the check task as described at the top of this file. */
 	xTaskCreate( prvCheckTask, "Check", configMINIMAL_STACK_SIZE, NULL, mainCHECK_TASK_PRIORITY, NULL );
+	xTaskCreate( prvDemoQueueSpaceFunctions, "QSpace", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL );
+	xTaskCreate( prvPermanentlyBlockingSemaphoreTask, "BlockSem", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL );
+	xTaskCreate( prvPermanentlyBlockingNotificationTask, "BlockNoti", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL );
+	prvAttributeNewTasks( mainNO_DEMO );
 
-	/* Create the standard demo tasks. */
+	/* The interrupt latency harness creates all its tasks now, so they are
+	counted before the suicidal tasks are created. */
+	pcIrqLatency = getenv( mainIRQ_LATENCY_VARIABLE );
+
+	if( ( pcIrqLatency != NULL ) && ( atol( pcIrqLatency ) > 0L ) )
+	{
+		xIrqLatencyStarted = xIrqLatencyStart( mainIRQ_LATENCY_PRIORITY, ( uint32_t ) atol( pcIrqLatency ) );
+		configASSERT( xIrqLatencyStarted );
+		prvAttributeNewTasks( mainNO_DEMO );
+	}
+
+	/* Create the standard demo tasks, in the order of xDemos[], tagging the
+	tasks each one creates. */
 	vStartTaskNotifyTask();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartBlockingQueueTasks( mainBLOCK_Q_PRIORITY );
+	prvAttributeNewTasks( uxDemo++ );
 	vStartSemaphoreTasks( mainSEM_TEST_PRIORITY );
+	prvAttributeNewTasks( uxDemo++ );
 	vStartPolledQueueTasks( mainQUEUE_POLL_PRIORITY );
+	prvAttributeNewTasks( uxDemo++ );
 	vStartIntegerMathTasks( mainINTEGER_TASK_PRIORITY );
+	prvAttributeNewTasks( uxDemo++ );
 	vStartGenericQueueTasks( mainGEN_QUEUE_TASK_PRIORITY );
+	prvAttributeNewTasks( uxDemo++ );
 	vStartQueuePeekTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartMathTasks( mainFLOP_TASK_PRIORITY );
+	prvAttributeNewTasks( uxDemo++ );
 	vStartRecursiveMutexTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartCountingSemaphoreTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartDynamicPriorityTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartQueueSetTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartQueueOverwriteTask( mainQUEUE_OVERWRITE_PRIORITY );
+	prvAttributeNewTasks( uxDemo++ );
 	vStartEventGroupTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartInterruptSemaphoreTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartQueueSetPollingTask();
+	prvAttributeNewTasks( uxDemo++ );
 	vCreateBlockTimeTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vCreateAbortDelayTasks();
-	xTaskCreate( prvDemoQueueSpaceFunctions, "QSpace", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL );
-	xTaskCreate( prvPermanentlyBlockingSemaphoreTask, "BlockSem", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL );
-	xTaskCreate( prvPermanentlyBlockingNotificationTask, "BlockNoti", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY, NULL );
-
+	prvAttributeNewTasks( uxDemo++ );
 	vStartMessageBufferTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartStreamBufferTasks();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartStreamBufferInterruptDemo();
+	prvAttributeNewTasks( uxDemo++ );
 	vStartMessageBufferAMPTasks();
+	prvAttributeNewTasks( uxDemo++ );
 
 	#if( configSUPPORT_STATIC_ALLOCATION == 1 )
 	{
 		vStartStaticallyAllocatedTasks();
+		prvAttributeNewTasks( uxDemo++ );
 	}
 	#endif
 
@@ -219,6 +403,7 @@ int main_full( void )
 	{
 		/* Don't expect these tasks to pass when preemption is not used. */
 		vStartTimerDemoTask( mainTIMER_TEST_PERIOD );
+		prvAttributeNewTasks( uxDemo++ );
 	}
 	#endif
 
@@ -227,6 +412,8 @@ int main_full( void )
 	ascertain whether or not the correct/expected number of tasks are running at
 	any given time. */
 	vCreateSuicidalTasks( mainCREATOR_TASK_PRIORITY );
+	prvAttributeNewTasks( uxDemo++ );
+	configASSERT( uxDemo == mainDEMO_COUNT );
 
 	/* Create the semaphore that will be deleted in the idle task hook.  This
 	is done purely to test the use of vSemaphoreDelete(). */
@@ -243,138 +430,203 @@ int main_full( void )
 
 static void prvCheckTask( void *pvParameters )
 {
-TickType_t xNextWakeTime;
+TickType_t xNextWakeTime, xRunStart;
 const TickType_t xCycleFrequency = pdMS_TO_TICKS( 2500UL );
+UBaseType_t x;
+BaseType_t xFinished = pdFALSE;
 
 	/* Just to remove compiler warning. */
 	( void ) pvParameters;
 
-	/* Initialise xNextWakeTime - this only needs to be done once. */
+	/* Initialise xNextWakeTime - this only needs to be done once.  The run
+	window starts now. */
 	xNextWakeTime = xTaskGetTickCount();
+	xRunStart = xNextWakeTime;
 
-	for( ;; )
+	while( xFinished == pdFALSE )
 	{
 		/* Place this task in the blocked state until it is time to run again. */
 		vTaskDelayUntil( &xNextWakeTime, xCycleFrequency );
 
-		/* Check the standard demo tasks are running without error. */
-		#if( configUSE_PREEMPTION != 0 )
+		/* The last check is made once the window has elapsed. */
+		if( ( xNextWakeTime - xRunStart ) >= xRunWindow )
 		{
-			/* These tasks are only created when preemption is used. */
-			if( xAreTimerDemoTasksStillRunning( xCycleFrequency ) != pdTRUE )
-			{
-				pcStatusMessage = "Error: TimerDemo";
-			}
+			xFinished = pdTRUE;
 		}
-		#endif
 
-		if( xAreStreamBufferTasksStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error:  StreamBuffer";
-		}
-		else if( xAreMessageBufferTasksStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error:  MessageBuffer";
-		}
-		else if( xAreTaskNotificationTasksStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error:  Notification";
-		}
-		else if( xAreInterruptSemaphoreTasksStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: IntSem";
-		}
-		else if( xAreEventGroupTasksStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: EventGroup";
-		}
-		else if( xAreIntegerMathsTaskStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: IntMath";
-		}
-		else if( xAreGenericQueueTasksStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: GenQueue";
-		}
-		else if( xAreQueuePeekTasksStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: QueuePeek";
-		}
-		else if( xAreBlockingQueuesStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: BlockQueue";
-		}
-		else if( xAreSemaphoreTasksStillRunning() != pdTRUE )
+		/* Check the standard demo tasks are running without error.  A demo
+		that fails once has failed the run, but is still checked so the
+		number of checks it passed is known. */
+		for( x = 0; x < mainDEMO_COUNT; x++ )
 		{
-			pcStatusMessage = "Error: SemTest";
-		}
-		else if( xArePollingQueuesStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: PollQueue";
-		}
-		else if( xAreMathsTaskStillRunning() != pdPASS )
-		{
-			pcStatusMessage = "Error: Flop";
-		}
-		else if( xAreRecursiveMutexTasksStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: RecMutex";
-		}
-		else if( xAreCountingSemaphoreTasksStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: CountSem";
-		}
-		else if( xIsCreateTaskStillRunning() != pdTRUE )
-		{
-			pcStatusMessage = "Error: Death";
-		}
-		else if( xAreDynamicPriorityTasksStillRunning() != pdPASS )
-		{
-			pcStatusMessage = "Error: Dynamic";
+			if( xDemos[ x ].pxCheck() == pdPASS )
+			{
+				ulChecksPassed[ x ]++;
+			}
+			else if( xDemoFailed[ x ] == pdFALSE )
+			{
+				xDemoFailed[ x ] = pdTRUE;
+				xFailedAt[ x ] = xNextWakeTime - xRunStart;
+			}
 		}
-		else if( xAreQueueSetTasksStillRunning() != pdPASS )
+
+		/* This is the only task that uses stdout so its ok to call printf()
+		directly. */
+		printf( "%s - tick count %zu - free heap %zu - min free heap %zu", pcStatusMessage,
+																		   xTaskGetTickCount(),
+																		   xPortGetFreeHeapSize(),
+																		   xPortGetMinimumEverFreeHeapSize() );
+
+		for( x = 0; x < mainDEMO_COUNT; x++ )
 		{
-			pcStatusMessage = "Error: Queue set";
+			if( xDemoFailed[ x ] != pdFALSE )
+			{
+				printf( " - Error: %s", xDemos[ x ].pcName );
+			}
 		}
-		else if( xIsQueueOverwriteTaskStillRunning() != pdPASS )
+
+		printf( "\r\n" );
+	}
+
+	prvFinishRun( xNextWakeTime - xRunStart );
+
+	/* prvFinishRun() exits the process. */
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCheckTimerDemo( void )
+{
+	return xAreTimerDemoTasksStillRunning( pdMS_TO_TICKS( 2500UL ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAttributeNewTasks( UBaseType_t uxDemo )
+{
+UBaseType_t x, uxTasks;
+
+	uxTasks = uxTaskGetSystemState( xTaskStatus, mainMAX_TASKS, NULL );
+	configASSERT( uxTasks > 0 );
+
+	for( x = 0; x < uxTasks; x++ )
+	{
+		if( xTaskGetApplicationTaskTag( xTaskStatus[ x ].xHandle ) == NULL )
 		{
-			pcStatusMessage = "Error: Queue overwrite";
+			vTaskSetApplicationTaskTag( xTaskStatus[ x ].xHandle, ( TaskHookFunction_t ) ( uxDemo + 1 ) );
 		}
-		else if( xAreQueueSetPollTasksStillRunning() != pdPASS )
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvFinishRun( TickType_t xElapsed )
+{
+uint32_t ulRunTime[ mainDEMO_COUNT + 2 ] = { 0 };
+uint32_t ulTotalRunTime, ulOtherRunTime;
+UBaseType_t x, uxTasks, uxTag;
+BaseType_t xPassed, xOtherPassed;
+double dShare;
+FILE *pxFile;
+
+	/* Add up the processor time of the tasks of each demo.  A tag of 0 is an
+	untagged task, and a tag of x + 1 is a task of xDemos[ x ], or of this file
+	when x is mainNO_DEMO. */
+	uxTasks = uxTaskGetSystemState( xTaskStatus, mainMAX_TASKS, &ulTotalRunTime );
+
+	for( x = 0; x < uxTasks; x++ )
+	{
+		uxTag = ( UBaseType_t ) xTaskGetApplicationTaskTag( xTaskStatus[ x ].xHandle );
+
+		if( uxTag < ( mainDEMO_COUNT + 2 ) )
 		{
-			pcStatusMessage = "Error: Queue set polling";
+			ulRunTime[ uxTag ] += xTaskStatus[ x ].ulRunTimeCounter;
 		}
-		else if( xAreBlockTimeTestTasksStillRunning() != pdPASS )
+	}
+
+	if( ulTotalRunTime == 0UL )
+	{
+		ulTotalRunTime = 1UL;
+	}
+
+	ulOtherRunTime = ulRunTime[ 0 ] + ulRunTime[ mainNO_DEMO + 1 ];
+
+	/* The tasks that belong to no demo pass if the checks made from the idle
+	hook found no errors. */
+	xOtherPassed = ( strcmp( pcStatusMessage, "No errors" ) == 0 ) ? pdTRUE : pdFALSE;
+	xPassed = xOtherPassed;
+
+	printf( "\r\nDemo              Result  Checks  Failed at (ms)  CPU (%%)\r\n" );
+
+	for( x = 0; x < mainDEMO_COUNT; x++ )
+	{
+		dShare = ( double ) ulRunTime[ x + 1 ] * 100.0 / ( double ) ulTotalRunTime;
+
+		if( xDemoFailed[ x ] != pdFALSE )
 		{
-			pcStatusMessage = "Error: Block time";
+			xPassed = pdFALSE;
+			printf( "%-16s  FAIL    %6lu  %14lu  %7.2f\r\n", xDemos[ x ].pcName, ( unsigned long ) ulChecksPassed[ x ],
+					( unsigned long ) ( xFailedAt[ x ] * portTICK_PERIOD_MS ), dShare );
 		}
-		else if( xAreAbortDelayTestTasksStillRunning() != pdPASS )
+		else
 		{
-			pcStatusMessage = "Error: Abort delay";
+			printf( "%-16s  pass    %6lu  %14s  %7.2f\r\n", xDemos[ x ].pcName, ( unsigned long ) ulChecksPassed[ x ],
+					"-", dShare );
 		}
-		else if( xIsInterruptStreamBufferDemoStillRunning() != pdPASS )
+	}
+
+	printf( "%-16s  %s    %6s  %14s  %7.2f\r\n", "Other", ( xOtherPassed != pdFALSE ) ? "pass" : "FAIL", "-", "-",
+			( double ) ulOtherRunTime * 100.0 / ( double ) ulTotalRunTime );
+
+	/* The same results, one row per demo, for comparing runs. */
+	pxFile = fopen( mainRESULT_FILE, "w" );
+
+	if( pxFile != NULL )
+	{
+		fprintf( pxFile, "demo,result,checks_passed,failed_at_ms,cpu_percent,window_ms\n" );
+
+		for( x = 0; x < mainDEMO_COUNT; x++ )
 		{
-			pcStatusMessage = "Error: Stream buffer interrupt";
+			fprintf( pxFile, "%s,%s,%lu,%ld,%.3f,%lu\n", xDemos[ x ].pcName, ( xDemoFailed[ x ] != pdFALSE ) ? "fail" : "pass",
+					 ( unsigned long ) ulChecksPassed[ x ],
+					 ( xDemoFailed[ x ] != pdFALSE ) ? ( long ) ( xFailedAt[ x ] * portTICK_PERIOD_MS ) : -1L,
+					 ( double ) ulRunTime[ x + 1 ] * 100.0 / ( double ) ulTotalRunTime,
+					 ( unsigned long ) ( xElapsed * portTICK_PERIOD_MS ) );
 		}
-		else if( xAreMessageBufferAMPTasksStillRunning() != pdPASS )
+
+		fprintf( pxFile, "Other,%s,0,-1,%.3f,%lu\n", ( xOtherPassed != pdFALSE ) ? "pass" : "fail",
+				 ( double ) ulOtherRunTime * 100.0 / ( double ) ulTotalRunTime,
+				 ( unsigned long ) ( xElapsed * portTICK_PERIOD_MS ) );
+
+		fclose( pxFile );
+	}
+	else
+	{
+		/* A run whose results can not be recorded has not passed. */
+		printf( "Could not write %s\r\n", mainRESULT_FILE );
+		xPassed = pdFALSE;
+	}
+
+	/* The interference the tick hook caused during the run. */
+	vTickWorkPrintReport();
+
+	/* The latencies measured so far, which are reported as incomplete if the
+	run window was too short to measure every case. */
+	if( xIrqLatencyStarted != pdFALSE )
+	{
+		vIrqLatencyPrintReport();
+
+		if( xIrqLatencyWriteResults( mainIRQ_LATENCY_FILE ) != pdPASS )
 		{
-			pcStatusMessage = "Error: Message buffer AMP";
+			printf( "Could not write %s\r\n", mainIRQ_LATENCY_FILE );
+			xPassed = pdFALSE;
 		}
+	}
 
-		#if( configSUPPORT_STATIC_ALLOCATION == 1 )
-			else if( xAreStaticAllocationTasksStillRunning() != pdPASS )
-			{
-				pcStatusMessage = "Error: Static allocation";
-			}
-		#endif /* configSUPPORT_STATIC_ALLOCATION */
+	printf( "%s\r\n", ( xPassed != pdFALSE ) ? "PASS" : "FAIL" );
+	fflush( stdout );
 
-		/* This is the only task that uses stdout so its ok to call printf()
-		directly. */
-		printf( "%s - tick count %zu - free heap %zu - min free heap %zu\r\n", pcStatusMessage,
-																			   xTaskGetTickCount(),
-																			   xPortGetFreeHeapSize(),
-																			   xPortGetMinimumEverFreeHeapSize() );
-	}
+	/* vTaskEndScheduler() can not return an exit code, so the process is
+	exited directly. */
+	exit( ( xPassed != pdFALSE ) ? EXIT_SUCCESS : EXIT_FAILURE );
 }
 /*-----------------------------------------------------------*/
 
@@ -446,46 +698,52 @@ void *pvAllocated;
 }
 /*-----------------------------------------------------------*/
 
-/* Called by vApplicationTickHook(), which is defined in main.c. */
-void vFullDemoTickHookFunction( void )
+static void prvRegisterTickWork( void )
 {
-TaskHandle_t xTimerTask;
-
-	/* Call the periodic timer test, which tests the timer API functions that
-	can be called from an ISR. */
+	/* The periodic timer test, which tests the timer API functions that can be
+	called from an ISR, counts its calls as ticks, so must run on every
+	tick. */
 	#if( configUSE_PREEMPTION != 0 )
 	{
 		/* Only created when preemption is used. */
-		vTimerPeriodicISRTests();
+		xTickWorkRegister( "TimerISR", vTimerPeriodicISRTests, pdTRUE );
 	}
 	#endif
 
-	/* Call the periodic queue overwrite from ISR demo. */
-	vQueueOverwritePeriodicISRDemo();
+	/* The periodic queue overwrite from ISR demo. */
+	xTickWorkRegister( "QOverwriteISR", vQueueOverwritePeriodicISRDemo, pdFALSE );
 
 	/* Write to a queue that is in use as part of the queue set demo to
 	demonstrate using queue sets from an ISR. */
-	vQueueSetAccessQueueSetFromISR();
-	vQueueSetPollingInterruptAccess();
+	xTickWorkRegister( "QueueSetISR", vQueueSetAccessQueueSetFromISR, pdFALSE );
+	xTickWorkRegister( "QSetPollISR", vQueueSetPollingInterruptAccess, pdFALSE );
 
 	/* Exercise event groups from interrupts. */
-	vPeriodicEventGroupsProcessing();
+	xTickWorkRegister( "EventGroupISR", vPeriodicEventGroupsProcessing, pdFALSE );
 
 	/* Exercise giving mutexes from an interrupt. */
-	vInterruptSemaphorePeriodicTest();
+	xTickWorkRegister( "IntSemISR", vInterruptSemaphorePeriodicTest, pdFALSE );
 
 	/* Exercise using task notifications from an interrupt. */
-	xNotifyTaskFromISR();
+	xTickWorkRegister( "NotifyISR", xNotifyTaskFromISR, pdFALSE );
 
 	/* Writes to stream buffer byte by byte to test the stream buffer trigger
 	level functionality. */
-	vPeriodicStreamBufferProcessing();
+	xTickWorkRegister( "StreamBufISR", vPeriodicStreamBufferProcessing, pdFALSE );
 
 	/* Writes a string to a string buffer four bytes at a time to demonstrate
 	a stream being sent from an interrupt to a task. */
-	vBasicStreamBufferSendFromISR();
+	xTickWorkRegister( "BasicSBISR", vBasicStreamBufferSendFromISR, pdFALSE );
 
 	/* For code coverage purposes. */
+	xTickWorkRegister( "TmrSvcPrioISR", prvCheckTimerTaskPriorityFromISR, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCheckTimerTaskPriorityFromISR( void )
+{
+TaskHandle_t xTimerTask;
+
 	xTimerTask = xTimerGetTimerDaemonTaskHandle();
 	configASSERT( uxTaskPriorityGetFromISR( xTimerTask ) == configTIMER_TASK_PRIORITY );
 }